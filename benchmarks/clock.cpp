@@ -0,0 +1,123 @@
+#include <time.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "rix/util/argument_parser.hpp"
+#include "rix/util/clock.hpp"
+#include "rix/util/time.hpp"
+
+using namespace rix::util;
+
+namespace {
+
+int64_t realtime_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1'000'000'000 + ts.tv_nsec;
+}
+
+/*
+ * Offset of Time::now() from CLOCK_REALTIME, taken from the tightest of a few
+ * brackets so that the cost of the reads does not count as error.
+ */
+int64_t offset_ns() {
+    int64_t best_width = INT64_MAX, best = 0;
+    for (int i = 0; i < 5; i++) {
+        int64_t before = realtime_ns();
+        int64_t now = Time::now().to_nanoseconds();
+        int64_t after = realtime_ns();
+        if (after - before < best_width) {
+            best_width = after - before;
+            best = now - (before + (after - before) / 2);
+        }
+    }
+    return best;
+}
+
+}  // namespace
+
+/*
+ * Reports, for every available clock source, the cost of Time::now() and how
+ * far it strays from CLOCK_REALTIME over a few seconds:
+ *
+ *     ./clock_benchmark -n 1000000 -d 5
+ *
+ * "max |offset|" is the largest difference seen, "drift" the slope of a
+ * least-squares line through the offsets, and "backwards" the number of
+ * consecutive reads that went back in time.
+ */
+int main(int argc, char **argv) {
+    ArgumentParser parser("clock_benchmark", "Measures the cost and accuracy of each clock source.");
+    parser.add<int>("iterations", "Calls to Time::now() per source", 'n', 1000000);
+    parser.add<double>("duration", "Seconds over which offsets are sampled per source", 'd', 2.0);
+    parser.add<double>("reanchor", "Re-anchoring interval of anchored sources (s)", 'r', 1.0);
+
+    if (!parser.parse(argc, argv)) {
+        std::cerr << parser.help() << std::endl;
+        return 1;
+    }
+
+    int iterations;
+    double duration, reanchor;
+    if (!parser.get<int>("iterations", iterations) || !parser.get<double>("duration", duration) ||
+        !parser.get<double>("reanchor", reanchor)) {
+        std::cerr << "Failed to get arguments." << std::endl;
+        return 1;
+    }
+
+    std::cout << std::left << std::setw(17) << "source" << std::setw(12) << "ns/call" << std::setw(18)
+              << "max |offset| us" << std::setw(14) << "drift ppm"
+              << "backwards" << std::endl;
+
+    for (ClockSource source : {ClockSource::SYSTEM, ClockSource::MONOTONIC, ClockSource::MONOTONIC_RAW,
+                               ClockSource::REALTIME_COARSE, ClockSource::TSC}) {
+        if (!set_clock_source(source, Duration(reanchor))) {
+            std::cout << std::setw(17) << clock_source_name(source) << "not available" << std::endl;
+            continue;
+        }
+
+        // Cost per call and monotonicity
+        int backwards = 0;
+        int64_t last = Time::now().to_nanoseconds();
+        int64_t start = realtime_ns();
+        for (int i = 0; i < iterations; i++) {
+            int64_t now = Time::now().to_nanoseconds();
+            backwards += now < last;
+            last = now;
+        }
+        double ns_per_call = static_cast<double>(realtime_ns() - start) / iterations;
+
+        // Offset from the realtime clock, sampled every 10 ms
+        std::vector<double> t, offset;
+        int64_t begin = realtime_ns();
+        while (realtime_ns() - begin < static_cast<int64_t>(duration * 1e9)) {
+            t.push_back((realtime_ns() - begin) * 1e-9);
+            offset.push_back(static_cast<double>(offset_ns()));
+            sleep_for(Duration(0.01));
+        }
+        double max_abs = 0.0, t_mean = 0.0, o_mean = 0.0;
+        for (size_t i = 0; i < t.size(); i++) {
+            max_abs = std::max(max_abs, std::abs(offset[i]));
+            t_mean += t[i];
+            o_mean += offset[i];
+        }
+        t_mean /= t.size();
+        o_mean /= t.size();
+        double cov = 0.0, var = 0.0;
+        for (size_t i = 0; i < t.size(); i++) {
+            cov += (t[i] - t_mean) * (offset[i] - o_mean);
+            var += (t[i] - t_mean) * (t[i] - t_mean);
+        }
+        double drift_ppm = var > 0.0 ? cov / var * 1e-3 : 0.0;  // ns per s -> ppm
+
+        std::cout << std::setw(17) << clock_source_name(source) << std::setw(12) << std::fixed << std::setprecision(1)
+                  << ns_per_call << std::setw(18) << std::setprecision(3) << max_abs * 1e-3 << std::setw(14)
+                  << drift_ppm << backwards << std::endl;
+    }
+    set_clock_source(ClockSource::SYSTEM);
+    return 0;
+}
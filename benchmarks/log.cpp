@@ -0,0 +1,86 @@
+#include <thread>
+#include <vector>
+
+#include "rix/util/argument_parser.hpp"
+#include "rix/util/binary_log.hpp"
+#include "rix/util/log.hpp"
+#include "rix/util/time.hpp"
+
+using namespace rix::util;
+
+/*
+ * Measures the time spent on the calling thread per log call while several
+ * threads log concurrently. Log output goes to stdout, so redirect it:
+ *
+ *     ./log_benchmark -t 4 -n 100000 > /dev/null
+ *     ./log_benchmark -t 4 -n 100000 --async > /dev/null
+ *     ./log_benchmark -t 4 -n 100000 --binary
+ */
+int main(int argc, char **argv) {
+    ArgumentParser parser("log_benchmark", "Measures nanoseconds per log call under contention.");
+    parser.add<int>("threads", "Number of logging threads", 't', 4);
+    parser.add<int>("iterations", "Log calls per thread", 'n', 100000);
+    parser.add<bool>("async", "Use the asynchronous logging backend", 'a', false);
+    parser.add<bool>("binary", "Use the binary logging backend (writes ~/.rix/log/log_benchmark_*.rixlog)", 'b',
+                     false);
+
+    if (!parser.parse(argc, argv)) {
+        std::cerr << parser.help() << std::endl;
+        return 1;
+    }
+
+    int threads, iterations;
+    bool async, binary;
+    if (!parser.get<int>("threads", threads) || !parser.get<int>("iterations", iterations) ||
+        !parser.get<bool>("async", async) || !parser.get<bool>("binary", binary)) {
+        std::cerr << "Failed to get arguments." << std::endl;
+        return 1;
+    }
+
+    if (binary && !BinaryLog::init("log_benchmark")) {
+        std::cerr << "Failed to open binary log." << std::endl;
+        return 1;
+    }
+    Log::init("log_benchmark", false, async);
+
+    std::vector<Duration> elapsed(threads);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([t, iterations, binary, &elapsed] {
+            Timer timer;
+            timer.start();
+            if (binary) {
+                for (int i = 0; i < iterations; i++) {
+                    RIX_BINLOG_INFO("thread {} iteration {} value {}", t, i, i * 0.5);
+                }
+            } else {
+                for (int i = 0; i < iterations; i++) {
+                    Log::info << "thread " << t << " iteration " << i << " value " << i * 0.5 << std::endl;
+                }
+            }
+            timer.stop();
+            elapsed[t] = timer.get();
+        });
+    }
+    for (auto &w : workers) {
+        w.join();
+    }
+
+    Timer flush_timer;
+    flush_timer.start();
+    if (binary) {
+        BinaryLog::flush();
+    } else {
+        Log::flush();
+    }
+    flush_timer.stop();
+
+    double total_ns = 0.0;
+    for (const auto &d : elapsed) {
+        total_ns += d.to_nanoseconds();
+    }
+    std::cerr << (binary ? "binary" : async ? "async" : "sync") << ": " << threads << " threads x " << iterations
+              << " calls, " << total_ns / (static_cast<double>(threads) * iterations) << " ns/call, final flush "
+              << flush_timer.get().to_microseconds() << " us" << std::endl;
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,66 @@
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <thread>
+
+#include "rix/util/argument_parser.hpp"
+#include "rix/util/thread_pool.hpp"
+#include "rix/util/time.hpp"
+
+using namespace rix::util;
+
+/*
+ * Measures the throughput of small tasks on a ThreadPool, submitted from
+ * outside the pool and from its own workers, for 1 up to `threads` workers.
+ *
+ *     ./thread_pool_benchmark -t 8 -n 1000000
+ */
+int main(int argc, char **argv) {
+    ArgumentParser parser("thread_pool_benchmark", "Measures nanoseconds per ThreadPool task.");
+    parser.add<int>("threads", "Largest number of workers", 't', static_cast<int>(std::thread::hardware_concurrency()));
+    parser.add<int>("iterations", "Tasks per run", 'n', 1000000);
+
+    if (!parser.parse(argc, argv)) {
+        std::cerr << parser.help() << std::endl;
+        return 1;
+    }
+
+    int threads, iterations;
+    if (!parser.get<int>("threads", threads) || !parser.get<int>("iterations", iterations)) {
+        std::cerr << "Failed to get arguments." << std::endl;
+        return 1;
+    }
+
+    for (int workers = 1; workers <= std::max(threads, 1); workers *= 2) {
+        ThreadPool pool(workers);
+        std::atomic<int64_t> sum{0};
+        auto task = [&sum] { sum.fetch_add(1, std::memory_order_relaxed); };
+
+        Timer outside;
+        outside.start();
+        for (int i = 0; i < iterations; i++) {
+            pool.submit(task);
+        }
+        pool.wait();
+        outside.stop();
+
+        // Each worker submits its share to its own queue; idle workers steal
+        Timer inside;
+        inside.start();
+        for (int w = 0; w < workers; w++) {
+            pool.submit([&, w] {
+                for (int i = w; i < iterations; i += workers) {
+                    pool.submit(task);
+                }
+            });
+        }
+        pool.wait();
+        inside.stop();
+
+        std::cout << workers << " workers: " << static_cast<double>(outside.get().to_nanoseconds()) / iterations
+                  << " ns/task submitted from outside, "
+                  << static_cast<double>(inside.get().to_nanoseconds()) / iterations
+                  << " ns/task submitted by workers (" << sum.load() << " tasks)" << std::endl;
+    }
+    return 0;
+}
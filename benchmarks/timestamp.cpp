@@ -0,0 +1,84 @@
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+#include "rix/util/argument_parser.hpp"
+#include "rix/util/time.hpp"
+#include "rix/util/timestamp.hpp"
+
+using namespace rix::util;
+
+namespace {
+
+/*
+ * The implementation of Time::to_string before TimestampFormatter, kept for
+ * comparison.
+ */
+std::string legacy_to_string(const Time &t) {
+    auto time = Clock::to_time_t(std::chrono::time_point_cast<std::chrono::seconds>(t.get()));
+    std::stringstream ss;
+    std::tm *timeinfo = std::gmtime(&time);
+    ss << std::put_time(timeinfo, "%D %T");
+    int64_t us = t.to_microseconds() % 1'000'000;
+    if (us == 0) {
+        ss << ".000000";
+    } else {
+        ss << "." << us;
+    }
+    ss << " GMT";
+    return ss.str();
+}
+
+template <typename F>
+double ns_per_call(int iterations, F &&fn) {
+    Timer timer;
+    timer.start();
+    for (int i = 0; i < iterations; i++) {
+        fn(i);
+    }
+    timer.stop();
+    return static_cast<double>(timer.get().to_nanoseconds()) / iterations;
+}
+
+}  // namespace
+
+/*
+ * Compares the cost of formatting a timestamp. Times advance by `step`
+ * microseconds per call, so a small step exercises the cached path and a
+ * step of 1,000,000 or more renders the date on every call.
+ *
+ *     ./timestamp_benchmark -n 1000000 -s 10
+ */
+int main(int argc, char **argv) {
+    ArgumentParser parser("timestamp_benchmark", "Measures nanoseconds per timestamp format.");
+    parser.add<int>("iterations", "Timestamps formatted per method", 'n', 1000000);
+    parser.add<int>("step", "Microseconds between consecutive timestamps", 's', 10);
+
+    if (!parser.parse(argc, argv)) {
+        std::cerr << parser.help() << std::endl;
+        return 1;
+    }
+
+    int iterations, step;
+    if (!parser.get<int>("iterations", iterations) || !parser.get<int>("step", step)) {
+        std::cerr << "Failed to get arguments." << std::endl;
+        return 1;
+    }
+
+    const Time start = Time::now();
+    auto at = [&](int i) { return start + Duration(Duration::Type(static_cast<int64_t>(i) * step * 1000)); };
+
+    size_t sink = 0;
+    double legacy = ns_per_call(iterations, [&](int i) { sink += legacy_to_string(at(i)).size(); });
+    double to_string = ns_per_call(iterations, [&](int i) { sink += at(i).to_string().size(); });
+    TimestampFormatter &formatter = TimestampFormatter::utc();
+    char buf[TimestampFormatter::MAX_SIZE];
+    double raw = ns_per_call(iterations, [&](int i) { sink += formatter.format(at(i), buf); });
+
+    std::cout << "step " << step << " us, " << iterations << " calls (" << sink << " chars)\n"
+              << "  legacy Time::to_string:       " << legacy << " ns/call\n"
+              << "  Time::to_string:              " << to_string << " ns/call\n"
+              << "  TimestampFormatter::format:   " << raw << " ns/call" << std::endl;
+    return 0;
+}
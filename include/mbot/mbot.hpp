@@ -7,30 +7,72 @@
 #include <termios.h>
 #include <unistd.h>
 
+#include <atomic>
 #include <mutex>
 #include <thread>
 #include <functional>
+#include <vector>
 
 #include "mbot/messages.hpp"
 #include "mbot/mbot_base.hpp"
+#include "mbot/timesync.hpp"
 #include "rix/ipc/file.hpp"
+#include "rix/ipc/pipe.hpp"
 #include "rix/msg/geometry/Twist2DStamped.hpp"
+#include "rix/util/histogram.hpp"
+#include "rix/util/scheduler.hpp"
+#include "rix/util/time.hpp"
 
 using rix::msg::geometry::Twist2DStamped;
 
 class MBot : public MBotBase {
    public:
-    MBot();
+    /**
+     * @brief Opens the MBot serial port and starts the background jobs.
+     *
+     * @param watchdog_timeout If positive, the MBot is stopped when it has
+     * been moving without receiving a command for this long.
+     */
+    explicit MBot(const rix::util::Duration &watchdog_timeout = rix::util::Duration(0.0));
     ~MBot();
 
     bool ok() const;
     void drive(const Twist2DStamped &cmd) const;
 
+    /**
+     * @brief Returns the host/board clock estimator. It is fed by the replies
+     * to timesync requests and by the timestamps of incoming telemetry.
+     */
+    const TimeSync &clock() const;
+
+    /**
+     * @brief Time spent in the serial write of each drive command.
+     */
+    const rix::util::Histogram &write_latency() const;
+
+    /**
+     * @brief Time from each drive command's `header.stamp` until its serial
+     * write completed.
+     */
+    const rix::util::Histogram &end_to_end_latency() const;
+
    private:
     void timesync();
+    void watchdog();
+    void receive();
+    void handle_packet(uint16_t topic, const uint8_t *data, size_t len, int64_t host_rx_us);
 
     mutable std::mutex mtx;
-    std::thread timesync_thr;
-    std::atomic<bool> stop_timesync_flag;
+    std::thread receive_thr;
+    std::atomic<bool> stop_flag{false};
+    std::array<rix::ipc::Pipe, 2> wake_pipe;  ///< Written to on shutdown to wake the receive thread
+    std::atomic<int64_t> timesync_tx_us{0};   ///< Host time of the last unanswered timesync request
+    mutable std::atomic<int64_t> last_drive_ns{0};
+    mutable std::atomic<bool> moving{false};
+    mutable rix::util::Histogram write_latency_;
+    mutable rix::util::Histogram end_to_end_latency_;
+    rix::util::Duration watchdog_timeout;
+    TimeSync clock_;
     rix::ipc::File file;
+    rix::util::Scheduler scheduler;  ///< Runs timesync and watchdog; declared last so it stops first
 };
\ No newline at end of file
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "mbot/messages.hpp"
+#include "rix/msg/quantize.hpp"
+
+/*
+ * Opt-in quantized counterparts of the pose and twist serial structs, with
+ * each float field sent as a 16-bit `rix::msg::Quantizer` code. The board
+ * firmware only understands the float structs on the existing topics, so these
+ * are for links and recordings where both ends have agreed to use them.
+ */
+
+typedef struct __attribute__((__packed__)) serial_quantized_pose2D_t {
+    int64_t utime;
+    uint16_t x;
+    uint16_t y;
+    uint16_t theta;
+} serial_quantized_pose2D_t;
+
+typedef struct __attribute__((__packed__)) serial_quantized_twist2D_t {
+    int64_t utime;
+    uint16_t vx;
+    uint16_t vy;
+    uint16_t wz;
+} serial_quantized_twist2D_t;
+
+/**
+ * @brief The quantizers for `serial_pose2D_t`. The defaults cover +/-32 m at
+ * 1 mm and +/-pi at 0.1 mrad. `theta` is clamped, not wrapped, so it must
+ * already lie in the angle range.
+ */
+struct SerialPose2DQuantization {
+    rix::msg::Quantizer position{-32.0f, 32.0f, 0.001f};
+    rix::msg::Quantizer angle{-3.14159265f, 3.14159265f, 0.0001f};
+
+    serial_quantized_pose2D_t encode(const serial_pose2D_t &src) const;
+    serial_pose2D_t decode(const serial_quantized_pose2D_t &src) const;
+
+    /**
+     * @brief Encodes `n` poses with the batch `Quantizer` loops.
+     */
+    void encode(const serial_pose2D_t *src, size_t n, serial_quantized_pose2D_t *dst) const;
+    void decode(const serial_quantized_pose2D_t *src, size_t n, serial_pose2D_t *dst) const;
+};
+
+/**
+ * @brief The quantizers for `serial_twist2D_t`, the same as those of
+ * `rix::msg::Twist2DQuantization` by default.
+ */
+struct SerialTwist2DQuantization {
+    rix::msg::Quantizer linear = rix::msg::Twist2DQuantization().linear;
+    rix::msg::Quantizer angular = rix::msg::Twist2DQuantization().angular;
+
+    serial_quantized_twist2D_t encode(const serial_twist2D_t &src) const;
+    serial_twist2D_t decode(const serial_quantized_twist2D_t &src) const;
+
+    /**
+     * @brief Encodes `n` twists with the batch `Quantizer` loops.
+     */
+    void encode(const serial_twist2D_t *src, size_t n, serial_quantized_twist2D_t *dst) const;
+    void decode(const serial_quantized_twist2D_t *src, size_t n, serial_twist2D_t *dst) const;
+};
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <deque>
+#include <mutex>
+
+/**
+ * @class TimeSync
+ * @brief Estimates the offset and drift between the host clock and the MBot
+ * board clock from timestamped serial traffic.
+ *
+ * @details Every sample bounds the true offset (board - host). A packet that
+ * was stamped by the board at `board_us` and received by the host at
+ * `host_rx_us` cannot have taken less than the serial transit time, so
+ * `board_us - host_rx_us + min_transit_us` is a lower bound on the offset.
+ * When the packet is a reply to a timesync request sent at `host_tx_us`, the
+ * board stamp cannot precede the request, giving an upper bound as well.
+ *
+ * Like NTP, the filter trusts the samples with the smallest delay: the window
+ * is split into buckets, and each bucket contributes its tightest bounds. A
+ * least-squares line through the bucket estimates yields the offset and the
+ * drift, which are used by `host_to_board` and `board_to_host`. Round trips
+ * (estimated by the midpoint of their bounds) and one-way samples (by their
+ * lower bound) are biased differently, so only round trips are fitted while
+ * the window holds any, and one-way samples otherwise.
+ */
+class TimeSync {
+   public:
+    /**
+     * @brief Constructs a TimeSync estimator.
+     *
+     * @param window The number of samples retained by the filter.
+     * @param buckets The number of buckets the window is split into.
+     * @param max_drift_ppm Drift estimates are clamped to +/- this value.
+     */
+    explicit TimeSync(size_t window = 256, size_t buckets = 8, double max_drift_ppm = 500.0);
+
+    /**
+     * @brief Adds a sample from a reply to a timesync request.
+     *
+     * @param host_tx_us Host time at which the request was sent.
+     * @param board_us Board time stamped in the reply.
+     * @param host_rx_us Host time at which the reply was received.
+     * @param min_transit_us Lower bound on the one-way transit time.
+     */
+    void add_round_trip(int64_t host_tx_us, int64_t board_us, int64_t host_rx_us, int64_t min_transit_us = 0);
+
+    /**
+     * @brief Adds a sample from a telemetry packet stamped by the board.
+     *
+     * @param board_us Board time stamped in the packet.
+     * @param host_rx_us Host time at which the packet was received.
+     * @param min_transit_us Lower bound on the one-way transit time.
+     */
+    void add_one_way(int64_t board_us, int64_t host_rx_us, int64_t min_transit_us = 0);
+
+    /**
+     * @brief Returns `true` once at least one sample has been filtered.
+     */
+    bool synchronized() const;
+
+    /**
+     * @brief Returns the estimated offset (board - host) at `host_us`, in
+     * microseconds.
+     */
+    double offset(int64_t host_us) const;
+
+    /**
+     * @brief Returns the estimated drift of the board clock relative to the
+     * host clock, in parts per million.
+     */
+    double drift_ppm() const;
+
+    /**
+     * @brief Converts a host timestamp to the board clock. Returns `host_us`
+     * unchanged until the estimator is synchronized.
+     */
+    int64_t host_to_board(int64_t host_us) const;
+
+    /**
+     * @brief Converts a board timestamp to the host clock. Returns `board_us`
+     * unchanged until the estimator is synchronized.
+     */
+    int64_t board_to_host(int64_t board_us) const;
+
+    /**
+     * @brief Discards all samples and the current estimate.
+     */
+    void reset();
+
+   private:
+    struct Sample {
+        int64_t host_us;  ///< Host time the bounds refer to
+        double lower;     ///< Lower bound on the offset
+        double upper;     ///< Upper bound on the offset (infinity if unknown)
+    };
+
+    void add(const Sample &sample);
+    void update();
+
+    const size_t window_;
+    const size_t buckets_;
+    const double max_drift_;
+
+    mutable std::mutex mtx_;
+    std::deque<Sample> samples_;
+    bool synchronized_;
+    int64_t ref_us_;  ///< Host time at which `offset_us_` is valid
+    double offset_us_;
+    double drift_;  ///< Dimensionless (board seconds per host second - 1)
+};
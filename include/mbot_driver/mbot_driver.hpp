@@ -1,6 +1,8 @@
 #pragma once
 
+#include <atomic>
 #include <memory>
+#include <vector>
 
 #include "mbot/mbot.hpp"
 #include "mbot/mbot_base.hpp"
@@ -10,16 +12,120 @@
 #include "rix/ipc/signal.hpp"
 #include "rix/msg/geometry/Twist2DStamped.hpp"
 #include "rix/msg/standard/UInt32.hpp"
+#include "rix/util/bounded_queue.hpp"
+#include "rix/util/histogram.hpp"
+#include "rix/util/profile.hpp"
+#include "rix/util/time.hpp"
 
 using namespace rix::ipc;
 using namespace rix::msg;
 
 class MBotDriver {
    public:
-    MBotDriver(std::unique_ptr<interfaces::IO> input, std::unique_ptr<MBotBase> mbot);
+    /**
+     * @brief Command counters. Every received (successfully decoded) command
+     * is either coalesced (replaced by a newer one read in the same wakeup),
+     * dropped (discarded by a full or closed command queue in
+     * `spin_pipelined`), suppressed (identical to the last command sent within
+     * the keep-alive period) or sent.
+     */
+    struct Stats {
+        uint64_t received = 0;
+        uint64_t coalesced = 0;
+        uint64_t dropped = 0;
+        uint64_t suppressed = 0;
+        uint64_t sent = 0;
+        uint64_t dropped_frames = 0;  ///< Frames discarded by the frame queue before decoding; not received
+    };
+
+    /**
+     * @brief Command latencies that are not a single scope. Per-stage timings
+     * are recorded by the "mbot_driver.*" profiler probes.
+     */
+    struct Latency {
+        rix::util::Histogram transit;  ///< `header.stamp` until the frame has been read
+    };
+
+    /**
+     * @brief Options for `spin_pipelined`. A CPU index of -1 leaves the
+     * corresponding thread unpinned.
+     */
+    struct PipelineOptions {
+        size_t frame_capacity = 64;    ///< Capacity of the input -> decode queue
+        size_t command_capacity = 64;  ///< Capacity of the decode -> drive queue
+        rix::util::OverflowPolicy frame_policy = rix::util::OverflowPolicy::DROP_OLDEST;
+        rix::util::OverflowPolicy command_policy = rix::util::OverflowPolicy::KEEP_LATEST;
+        int input_cpu = -1;
+        int decode_cpu = -1;
+        int drive_cpu = -1;
+    };
+
+    /**
+     * @brief Constructs an MBotDriver.
+     *
+     * @param input The stream of size-prefixed Twist2DStamped messages.
+     * @param mbot The MBot to drive.
+     * @param keep_alive An unchanged command is forwarded again only once this
+     * much time has passed since it was last sent.
+     */
+    MBotDriver(std::unique_ptr<interfaces::IO> input, std::unique_ptr<MBotBase> mbot,
+               const rix::util::Duration &keep_alive = rix::util::Duration(0.5));
     void spin(std::unique_ptr<interfaces::Notification> notif);
 
+    /**
+     * @brief Like `spin`, but reads, decodes and drives on three threads
+     * connected by bounded queues, so a slow serial write does not hold up
+     * reading the next command. The calling thread waits for `notif` or the
+     * end of the input and then shuts the pipeline down.
+     */
+    void spin_pipelined(std::unique_ptr<interfaces::Notification> notif, const PipelineOptions &options);
+
+    const Stats &stats() const;
+    const Latency &latency() const;
+
    private:
+    enum class ReadStatus { OK, ERROR, END };
+
+    /**
+     * @brief A serialized command and the time its last byte was read.
+     */
+    struct Frame {
+        std::vector<uint8_t> data;
+        rix::util::Time read_end;
+    };
+
+    /**
+     * @brief Reads exactly `size` bytes. If `stop` is given, the input is
+     * polled in short slices and the read gives up with ERROR once `*stop` is
+     * set, even partway through a frame.
+     */
+    ReadStatus read_exact(uint8_t *dst, size_t size, const std::atomic<bool> *stop = nullptr);
+
+    /**
+     * @brief Reads a frame's size prefix. Sizes over `sizeof(buffer)` are an
+     * ERROR, and the frame's body is read and discarded so the stream stays
+     * in sync.
+     */
+    ReadStatus read_size(uint32_t &size, const std::atomic<bool> *stop = nullptr);
+
+    /**
+     * @brief Reads the `size` bytes of a frame's body. The input ending here
+     * is an ERROR, since the frame is incomplete.
+     */
+    ReadStatus read_body(uint8_t *dst, uint32_t size, const std::atomic<bool> *stop = nullptr);
+    bool decode(const uint8_t *src, uint32_t size, const rix::util::Time &read_end, geometry::Twist2DStamped &cmd);
+    ReadStatus read_command(geometry::Twist2DStamped &cmd);
+    void forward(const geometry::Twist2DStamped &cmd);
+    void stop();
+
     std::unique_ptr<interfaces::IO> input;
     std::unique_ptr<MBotBase> mbot;
+    rix::util::Duration keep_alive;
+
+    uint8_t buffer[4096];  ///< Message buffer (max message size)
+    bool has_last_sent;
+    geometry::Twist2D last_sent;
+    rix::util::Time last_sent_time;
+    Stats stats_;
+    Latency latency_;
 };
\ No newline at end of file
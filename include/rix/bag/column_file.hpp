@@ -0,0 +1,149 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace rix {
+namespace bag {
+
+/**
+ * @brief The element type of a column. Values are part of the file format.
+ */
+enum class ColumnType : uint32_t { INT64 = 0, UINT32 = 1, FLOAT32 = 2, FLOAT64 = 3 };
+
+/**
+ * @brief Returns the ColumnType of T.
+ */
+template <typename T>
+constexpr ColumnType column_type();
+template <>
+constexpr ColumnType column_type<int64_t>() { return ColumnType::INT64; }
+template <>
+constexpr ColumnType column_type<uint32_t>() { return ColumnType::UINT32; }
+template <>
+constexpr ColumnType column_type<float>() { return ColumnType::FLOAT32; }
+template <>
+constexpr ColumnType column_type<double>() { return ColumnType::FLOAT64; }
+
+/**
+ * @brief Returns the size in bytes of one element of `type`.
+ */
+size_t column_type_size(ColumnType type);
+
+/**
+ * @brief A column to write: `rows` contiguous elements of `type` at `data`.
+ */
+struct Column {
+    std::string name;
+    ColumnType type;
+    const void *data;
+    size_t rows;
+
+    template <typename T>
+    static Column of(const std::string &name, const std::vector<T> &values) {
+        return Column{name, column_type<T>(), values.data(), values.size()};
+    }
+};
+
+namespace detail {
+
+/**
+ * @brief The on-disk layout of a column file. All integers and column values
+ * are little-endian: the file is written and mapped in host byte order, so
+ * only little-endian hosts are supported.
+ *
+ *     ColumnFileHeader
+ *     ColumnEntry[column_count]
+ *     column data            (each starting at a multiple of COLUMN_ALIGNMENT)
+ *
+ * Every column holds `row_count` elements. Because the data is aligned, a
+ * mapped file can be read in place as arrays of the column types.
+ */
+constexpr char COLUMN_MAGIC[8] = {'R', 'I', 'X', 'C', 'O', 'L', 'S', '\0'};
+constexpr uint32_t COLUMN_VERSION = 1;
+constexpr size_t COLUMN_ALIGNMENT = 64;
+
+struct ColumnFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t column_count;
+    uint64_t row_count;
+};
+
+struct ColumnEntry {
+    char name[48];  ///< Null-terminated
+    uint32_t type;
+    uint32_t reserved;
+    uint64_t offset;  ///< Of the column data in the file
+};
+
+static_assert(sizeof(ColumnFileHeader) == 24);
+static_assert(sizeof(ColumnEntry) == 64);
+static_assert(std::endian::native == std::endian::little, "Column files are written and mapped in host byte order");
+
+}  // namespace detail
+
+/**
+ * @brief Writes columns of equal length to a column file at `path`.
+ *
+ * @return false if the columns differ in length, a name is empty or longer
+ * than 47 bytes, or a write failed.
+ */
+bool write_column_file(const std::string &path, const std::vector<Column> &columns);
+
+/**
+ * @brief A column file mapped into memory. Columns are read in place, with no
+ * copying or decoding.
+ */
+class ColumnFile {
+   public:
+    ColumnFile();
+
+    /**
+     * @brief Unmaps the file.
+     */
+    ~ColumnFile();
+
+    ColumnFile(const ColumnFile &) = delete;
+    ColumnFile &operator=(const ColumnFile &) = delete;
+
+    /**
+     * @brief Maps the column file at `path`.
+     *
+     * @return false if the file cannot be mapped or is not a valid column
+     * file.
+     */
+    bool open(const std::string &path);
+    void close();
+    bool is_open() const;
+
+    size_t rows() const;
+    size_t columns() const;
+    std::string name(size_t i) const;
+    ColumnType type(size_t i) const;
+
+    /**
+     * @brief Returns the column called `name`, or an empty span if there is
+     * none or it does not hold T.
+     */
+    template <typename T>
+    std::span<const T> column(const std::string &name) const {
+        const void *data = find(name, column_type<T>());
+        return data ? std::span<const T>(static_cast<const T *>(data), rows_) : std::span<const T>();
+    }
+
+   private:
+    const void *find(const std::string &name, ColumnType type) const;
+    detail::ColumnEntry entry(size_t i) const;
+
+    const uint8_t *map_;
+    size_t map_size_;
+    size_t rows_;
+    size_t columns_;
+};
+
+}  // namespace bag
+}  // namespace rix
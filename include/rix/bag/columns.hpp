@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "rix/bag/column_file.hpp"
+#include "rix/bag/reader.hpp"
+#include "rix/msg/geometry/Twist2DStamped.hpp"
+#include "rix/util/time.hpp"
+
+namespace rix {
+namespace bag {
+
+/**
+ * @brief A stream of `Twist2DStamped` messages stored as one contiguous
+ * vector per field (structure of arrays).
+ *
+ * @details Row i of every vector belongs to the same message. Scans over one
+ * field read only that field's memory and compile to plain loops over arrays,
+ * rather than visiting each message object. `frame_id` is not kept.
+ */
+struct Twist2DColumns {
+    std::vector<int64_t> stamp_ns;         ///< When each message was recorded
+    std::vector<uint32_t> seq;             ///< `header.seq`
+    std::vector<int64_t> header_stamp_ns;  ///< `header.stamp`
+    std::vector<float> vx;
+    std::vector<float> vy;
+    std::vector<float> wz;
+
+    size_t size() const;
+    bool empty() const;
+    void reserve(size_t n);
+    void clear();
+
+    /**
+     * @brief Appends a message recorded at `stamp`.
+     */
+    void push_back(const msg::geometry::Twist2DStamped &msg, const util::Time &stamp);
+
+    /**
+     * @brief Appends every row of `other`.
+     */
+    void append(const Twist2DColumns &other);
+
+    /**
+     * @brief Orders the rows by `stamp_ns`, then by `seq`.
+     */
+    void sort();
+
+    /**
+     * @brief Materializes the `Twist2DStamped` messages recorded in
+     * [start, end), in stamp order. Decoding runs in parallel with
+     * `Reader::for_each`.
+     */
+    static Twist2DColumns load(const Reader &reader, const util::Time &start, const util::Time &end);
+
+    /**
+     * @brief Describes the columns for `write_column_file`, named after the
+     * fields above.
+     */
+    std::vector<Column> columns() const;
+
+    /**
+     * @brief Exports the columns to a column file.
+     */
+    bool write(const std::string &path) const;
+};
+
+/**
+ * @brief Count, extremes and mean of a column.
+ */
+struct Summary {
+    size_t count = 0;
+    double min = 0.0;
+    double max = 0.0;
+    double mean = 0.0;
+};
+
+/**
+ * @brief Summarizes a column in one pass. The loop keeps independent partial
+ * results in several lanes so that it vectorizes.
+ */
+Summary summarize(std::span<const float> values);
+
+}  // namespace bag
+}  // namespace rix
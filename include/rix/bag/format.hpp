@@ -0,0 +1,112 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstdint>
+
+namespace rix {
+namespace bag {
+
+/**
+ * @brief The type of a recorded message: its `Message::hash()`.
+ */
+using Hash = std::array<uint64_t, 2>;
+
+/**
+ * @brief How the records of a chunk are stored. Values are part of the file
+ * format.
+ *
+ * @details
+ *     NONE:     The records as written.
+ *     LZ:       The records compressed as one `lz` block.
+ *     DELTA_LZ: The `Twist2DStamped` records delta-encoded with
+ *               `msg::DeltaEncoder`, starting afresh in each chunk, and the
+ *               result compressed as one `lz` block. Reading restores the
+ *               records byte for byte.
+ */
+enum class Compression : uint32_t { NONE = 0, LZ = 1, DELTA_LZ = 2 };
+
+namespace detail {
+
+/**
+ * @brief The on-disk layout of a bag. All integers are little-endian: the
+ * structs below are copied to and from the file in host byte order, so only
+ * little-endian hosts are supported.
+ *
+ *     FileHeader
+ *     ChunkHeader, records      (repeated)
+ *     ChunkEntry[chunk_count]   (chunk table)
+ *     IndexEntry[index_count]   (sorted by stamp, then by write order)
+ *     Footer
+ *
+ * A chunk holds `count` records, each a RecordHeader followed by `size`
+ * bytes of serialized message, stored as described by `compression`. Record
+ * offsets in the index are offsets into the decompressed records. The
+ * chunk table, index and footer are written when the bag is closed; a bag
+ * without them (e.g. after a crash) can still be read by scanning its chunks.
+ */
+constexpr char MAGIC[8] = {'R', 'I', 'X', 'B', 'A', 'G', '\0', '\0'};
+constexpr char FOOTER_MAGIC[8] = {'R', 'I', 'X', 'B', 'A', 'G', 'I', 'X'};
+constexpr uint32_t VERSION = 1;
+constexpr uint32_t CHUNK_MAGIC = 0x4b4e4843;  // "CHNK"
+constexpr uint32_t RECORD_DELTA = 1;          ///< RecordHeader flag: the data is delta-encoded
+
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t flags;
+};
+
+struct ChunkHeader {
+    uint32_t magic;
+    uint32_t compression;
+    uint64_t stored_size;   ///< Bytes following the header
+    uint64_t raw_size;      ///< Bytes of records once decompressed
+    int64_t start_ns;       ///< Earliest stamp in the chunk
+    int64_t end_ns;         ///< Latest stamp in the chunk
+    uint32_t count;
+    uint32_t encoded_size;  ///< DELTA_LZ: bytes of delta-encoded records the `lz` block expands to
+};
+
+struct RecordHeader {
+    int64_t stamp_ns;
+    uint64_t hash[2];
+    uint32_t size;
+    uint32_t flags;  ///< RECORD_DELTA, only inside DELTA_LZ chunks
+};
+
+struct ChunkEntry {
+    uint64_t offset;  ///< Of the ChunkHeader in the file
+    int64_t start_ns;
+    int64_t end_ns;
+    uint32_t count;
+    uint32_t reserved;
+};
+
+struct IndexEntry {
+    int64_t stamp_ns;
+    uint64_t hash[2];
+    uint32_t chunk;   ///< Position in the chunk table
+    uint32_t offset;  ///< Of the RecordHeader within the chunk's records
+};
+
+struct Footer {
+    uint64_t chunk_table_offset;
+    uint64_t chunk_count;
+    uint64_t index_offset;
+    uint64_t index_count;
+    char magic[8];
+};
+
+static_assert(sizeof(FileHeader) == 16);
+static_assert(sizeof(ChunkHeader) == 48);
+static_assert(sizeof(RecordHeader) == 32);
+static_assert(sizeof(ChunkEntry) == 32);
+static_assert(sizeof(IndexEntry) == 32);
+static_assert(sizeof(Footer) == 40);
+static_assert(std::endian::native == std::endian::little, "Bag files are read and written in host byte order");
+
+}  // namespace detail
+
+}  // namespace bag
+}  // namespace rix
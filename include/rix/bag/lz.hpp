@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace rix {
+namespace bag {
+namespace lz {
+
+/**
+ * @brief A byte-oriented LZ77 block codec in the style of LZ4, used for
+ * `Compression::LZ` chunks.
+ *
+ * @details A block is a series of sequences, each a token byte, a run of
+ * literals and a match:
+ *
+ *     token                 high nibble: literal count, low nibble: match length - 4
+ *     [literal count - 15]  if the high nibble is 15, as bytes of 255 ending with one below 255
+ *     literals
+ *     offset                uint16, little-endian, 1-65535 bytes back into the output
+ *     [match length - 19]   if the low nibble is 15, encoded like the literal count
+ *
+ * The last sequence ends after its literals. Compression finds matches with a
+ * single-entry hash table over 4-byte windows and never looks back further
+ * than 64 KiB, so it is fast and needs no allocation; decompression is a
+ * bounds-checked copy loop. The format is part of the bag format.
+ */
+
+/**
+ * @brief Returns the largest compressed size of `size` bytes.
+ */
+constexpr size_t compress_bound(size_t size) { return size + size / 255 + 16; }
+
+/**
+ * @brief Compresses `size` bytes from `src` into `dst`.
+ *
+ * @return The compressed size, or 0 if it would exceed `capacity`.
+ */
+size_t compress(const uint8_t *src, size_t size, uint8_t *dst, size_t capacity);
+
+/**
+ * @brief Decompresses a block of `size` bytes that expands to exactly
+ * `raw_size` bytes into `dst`.
+ *
+ * @return false if the block is malformed or does not expand to `raw_size`
+ * bytes.
+ */
+bool decompress(const uint8_t *src, size_t size, uint8_t *dst, size_t raw_size);
+
+}  // namespace lz
+}  // namespace bag
+}  // namespace rix
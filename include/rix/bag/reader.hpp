@@ -0,0 +1,309 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "rix/bag/format.hpp"
+#include "rix/msg/message.hpp"
+#include "rix/util/thread_pool.hpp"
+#include "rix/util/time.hpp"
+
+namespace rix {
+namespace bag {
+
+/**
+ * @brief A recorded message. `data` points into the reader's mapping and is
+ * valid until the reader is closed, or, if the record was compressed, into
+ * the decompressed chunk that `chunk` keeps alive.
+ */
+struct Record {
+    util::Time stamp;
+    Hash hash{};
+    const uint8_t *data = nullptr;
+    size_t size = 0;
+    std::shared_ptr<const std::vector<uint8_t>> chunk;
+
+    /**
+     * @brief Deserializes the record into `msg`.
+     *
+     * @return false if `msg` is of a different type or the data is invalid.
+     */
+    bool deserialize(msg::Message &msg) const;
+};
+
+/**
+ * @brief Reads a bag file written by `Writer`.
+ *
+ * @details The file is memory-mapped, so opening it reads only the footer,
+ * chunk table and index; record data is paged in as it is accessed. Records
+ * are addressed by their position in time order. If the bag has no index
+ * (it was not closed), `open` rebuilds one by scanning the chunk headers and
+ * records. A Reader may be used from several threads once opened.
+ *
+ * Compressed chunks are decompressed on first access into a cache of the
+ * `cache_chunks` most recently used. Each time a chunk is first used, the
+ * `readahead` chunks after it are decompressed in parallel on a pool of
+ * `threads` workers, so a reader moving forward through the bag rarely waits.
+ *
+ * For bulk processing, `for_each` shards the bag by chunk across the same
+ * work-stealing pool: each worker decompresses whole chunks into its own
+ * buffer and hands their records to the callback, bypassing the index and the
+ * cache. Rebuilding a missing index scans the chunks in parallel the same way.
+ */
+class Reader {
+   public:
+    struct Options {
+        size_t cache_chunks = 8;  ///< Decompressed chunks kept
+        size_t readahead = 2;     ///< Chunks decompressed ahead of the one in use (0 = none)
+        size_t threads = 0;       ///< Workers for read-ahead and bulk reads (0 = one per core)
+    };
+
+    /**
+     * @brief Iterates the records of a `Range` in time order.
+     */
+    class Iterator {
+       public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Record;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Record *;
+        using reference = Record;
+
+        Iterator() = default;
+
+        Record operator*() const;
+        Iterator &operator++();
+        Iterator operator++(int);
+        bool operator==(const Iterator &other) const { return pos_ == other.pos_; }
+        bool operator!=(const Iterator &other) const { return pos_ != other.pos_; }
+
+        /**
+         * @brief Returns the position of the current record, for `Reader::record`.
+         */
+        size_t position() const { return pos_; }
+
+       private:
+        friend class Reader;
+        Iterator(const Reader *reader, size_t pos, size_t end, const Hash *type);
+        void skip();
+
+        const Reader *reader_ = nullptr;
+        size_t pos_ = 0;
+        size_t end_ = 0;
+        bool filter_ = false;
+        Hash type_{};
+    };
+
+    /**
+     * @brief The records stamped in [start, end), optionally of one type.
+     */
+    class Range {
+       public:
+        Iterator begin() const { return begin_; }
+        Iterator end() const { return end_; }
+
+       private:
+        friend class Reader;
+        Range(Iterator begin, Iterator end) : begin_(begin), end_(end) {}
+
+        Iterator begin_;
+        Iterator end_;
+    };
+
+    Reader();
+
+    /**
+     * @brief Unmaps the file.
+     */
+    ~Reader();
+
+    Reader(const Reader &) = delete;
+    Reader &operator=(const Reader &) = delete;
+
+    /**
+     * @brief Maps the bag at `path` and loads or rebuilds its index.
+     *
+     * @return false if the file cannot be mapped or is not a bag.
+     */
+    bool open(const std::string &path, const Options &options);
+    bool open(const std::string &path);
+    void close();
+    bool is_open() const;
+
+    /**
+     * @brief Returns `false` if the bag had no index and it was rebuilt from
+     * the chunks.
+     */
+    bool indexed() const;
+
+    /**
+     * @brief Returns the number of records.
+     */
+    size_t size() const;
+
+    /**
+     * @brief Returns the record at position `i` in time order. Records with
+     * equal stamps keep the order they were written in.
+     */
+    Record record(size_t i) const;
+
+    /**
+     * @brief Returns the position of the first record stamped at or after
+     * `time`.
+     */
+    size_t lower_bound(const util::Time &time) const;
+
+    /**
+     * @brief Returns the stamps of the first and last records.
+     */
+    util::Time start_time() const;
+    util::Time end_time() const;
+
+    Range range(const util::Time &start, const util::Time &end) const;
+    Range range(const Hash &type, const util::Time &start, const util::Time &end) const;
+
+    /**
+     * @brief Returns the number of chunks.
+     */
+    size_t chunks() const;
+
+    /**
+     * @brief Returns the number of workers used by `for_each`. Worker indices
+     * passed to callbacks are below `workers()`.
+     */
+    size_t workers() const;
+
+    /**
+     * @brief Calls `fn(record, worker)` for every record of type `type`
+     * stamped in [start, end), in parallel and in no particular order.
+     * `record.data` is only valid during the call, and `worker` identifies
+     * the calling thread, so per-thread state can be kept in an array of
+     * `workers()` slots without locking.
+     *
+     * @return The number of records visited.
+     */
+    size_t for_each(const Hash &type, const util::Time &start, const util::Time &end,
+                    const std::function<void(const Record &, size_t)> &fn) const;
+
+    /**
+     * @brief Calls `fn(msg, record, worker)` for every message of type M
+     * stamped in [start, end), in parallel and in no particular order. Each
+     * worker deserializes into its own M, reusing its storage from message to
+     * message. Records that fail to deserialize are skipped.
+     *
+     * @return The number of messages passed to `fn`.
+     */
+    template <typename M, typename F>
+    size_t for_each(const util::Time &start, const util::Time &end, F fn) const;
+
+   private:
+    using Records = std::shared_ptr<const std::vector<uint8_t>>;
+
+    struct CacheEntry {
+        std::shared_future<Records> records;
+        uint64_t used;    ///< When the entry was last used, for eviction
+        bool prefetched;  ///< Loaded ahead and not used yet
+    };
+
+    detail::IndexEntry index_entry(size_t i) const;
+    detail::ChunkEntry chunk_entry(size_t i) const;
+
+    /**
+     * @brief Returns the header of a chunk and where its stored bytes start,
+     * or null if the chunk is invalid.
+     */
+    const uint8_t *chunk_data(uint32_t chunk, detail::ChunkHeader &header) const;
+
+    /**
+     * @brief Returns the records of a chunk and their size, or null if the
+     * chunk is invalid. Compressed records are held by `owner`.
+     */
+    const uint8_t *chunk_records(uint32_t chunk, size_t &size, Records &owner) const;
+
+    /**
+     * @brief Returns the decompressed records of a chunk from the cache,
+     * decompressing them if needed.
+     */
+    Records cached_records(uint32_t chunk) const;
+
+    /**
+     * @brief Starts decompressing the chunks after `chunk`. Called with
+     * `cache_mtx_` held.
+     */
+    void read_ahead(uint32_t chunk) const;
+
+    /**
+     * @brief Drops the least recently used entries beyond `cache_chunks`.
+     * Called with `cache_mtx_` held.
+     */
+    void evict() const;
+
+    Records decompress(uint32_t chunk) const;
+
+    /**
+     * @brief Returns the records of a chunk, decompressing them into `buffer`
+     * if needed, or null if the chunk is invalid.
+     */
+    const uint8_t *load_records(uint32_t chunk, std::vector<uint8_t> &buffer, size_t &size) const;
+
+    /**
+     * @brief Calls `fn(header, offset)` for each of the first `count` records
+     * in `records`, stopping at the first that does not fit.
+     */
+    static void scan(const uint8_t *records, size_t size, uint32_t count,
+                     const std::function<void(const detail::RecordHeader &, size_t)> &fn);
+
+    util::ThreadPool &pool() const;
+
+    bool read_index();
+    bool rebuild_index();
+
+    Options options_;
+    int fd_;
+    const uint8_t *map_;
+    size_t map_size_;
+    bool indexed_;
+
+    // Either point into the mapping or at the rebuilt tables below
+    const uint8_t *chunk_table_;
+    size_t chunk_count_;
+    const uint8_t *index_;
+    size_t index_count_;
+    std::vector<detail::ChunkEntry> rebuilt_chunks_;
+    std::vector<detail::IndexEntry> rebuilt_index_;
+
+    mutable std::mutex cache_mtx_;
+    mutable std::unordered_map<uint32_t, CacheEntry> cache_;
+    mutable uint64_t cache_clock_;
+    mutable std::mutex pool_mtx_;
+    mutable std::unique_ptr<util::ThreadPool> pool_;  ///< Started when first needed
+};
+
+template <typename M, typename F>
+size_t Reader::for_each(const util::Time &start, const util::Time &end, F fn) const {
+    std::vector<M> arenas(workers());
+    std::vector<size_t> counts(workers(), 0);
+    for_each(M().hash(), start, end, [&](const Record &record, size_t worker) {
+        M &msg = arenas[worker];
+        size_t offset = 0;
+        if (msg.deserialize(record.data, record.size, offset)) {
+            counts[worker]++;
+            fn(static_cast<const M &>(msg), record, worker);
+        }
+    });
+    size_t count = 0;
+    for (size_t n : counts) {
+        count += n;
+    }
+    return count;
+}
+
+}  // namespace bag
+}  // namespace rix
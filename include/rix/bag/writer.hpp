@@ -0,0 +1,160 @@
+#pragma once
+
+#include <sys/uio.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "rix/bag/format.hpp"
+#include "rix/msg/message.hpp"
+#include "rix/util/thread_pool.hpp"
+#include "rix/util/time.hpp"
+
+namespace rix {
+namespace bag {
+
+/**
+ * @brief Records messages to a bag file.
+ *
+ * @details Records are appended to an in-memory chunk, which is compressed
+ * and written to the file, header and records with one `writev`, once it
+ * reaches `chunk_size`. With
+ * `threads` > 0, full chunks are handed to a pool of that many workers, so
+ * `write` only ever copies the record; chunks are compressed in parallel and
+ * written in order by whichever worker finishes the oldest one. The caller
+ * only waits if more than `max_pending` bytes of chunks are still queued.
+ * A chunk that does not shrink is stored uncompressed. The index of every
+ * record is kept in memory and written, sorted by stamp, by `close`. Not
+ * thread-safe.
+ */
+class Writer {
+   public:
+    struct Options {
+        size_t chunk_size = 1 << 20;                  ///< Write a chunk once its records reach this size
+        Compression compression = Compression::NONE;  ///< How chunks are stored
+        size_t threads = 0;                           ///< Workers compressing and writing chunks (0 = the caller)
+        size_t max_pending = 64 << 20;                ///< Bytes of queued chunks before `write` waits
+    };
+
+    Writer();
+
+    /**
+     * @brief Closes the bag.
+     */
+    ~Writer();
+
+    Writer(const Writer &) = delete;
+    Writer &operator=(const Writer &) = delete;
+
+    /**
+     * @brief Creates the bag at `path`, replacing any existing file.
+     *
+     * @return true on success.
+     */
+    bool open(const std::string &path, const Options &options);
+    bool open(const std::string &path);
+
+    /**
+     * @brief Writes the last chunk, the index and the footer, and closes the
+     * file.
+     *
+     * @return true if every write succeeded.
+     */
+    bool close();
+
+    bool is_open() const;
+
+    /**
+     * @brief Records a message.
+     *
+     * @param msg The message, serialized with `Message::serialize`.
+     * @param stamp The time the message is recorded under.
+     * @return false if the bag is not open or a write failed.
+     */
+    bool write(const msg::Message &msg, const util::Time &stamp);
+
+    /**
+     * @brief Records an already serialized message.
+     */
+    bool write(const Hash &hash, const uint8_t *data, size_t size, const util::Time &stamp);
+
+    /**
+     * @brief Writes the current chunk and every queued chunk to the file.
+     */
+    bool flush();
+
+    /**
+     * @brief Returns the number of records written.
+     */
+    uint64_t count() const;
+
+   private:
+    /**
+     * @brief A chunk on its way to the file.
+     */
+    struct Job {
+        detail::ChunkHeader header;
+        std::vector<uint8_t> records;
+        std::vector<uint8_t> stored;  ///< The compressed records, if they shrank
+        bool done = false;            ///< Compressed and ready to write
+    };
+
+    /**
+     * @brief Adds a record to the current chunk and returns where its `size`
+     * bytes of data go.
+     */
+    uint8_t *append(const Hash &hash, size_t size, const util::Time &stamp);
+
+    /**
+     * @brief Hands the current chunk on if it is full.
+     */
+    bool end_record();
+
+    /**
+     * @brief Hands the current chunk to the workers, or compresses and writes
+     * it if there are none.
+     */
+    void submit_chunk();
+
+    void compress(Job &job) const;
+
+    /**
+     * @brief Writes the compressed chunks at the front of the queue, in order.
+     */
+    void write_ready();
+    void write_chunk(const Job &job);
+    bool write_all(const void *data, size_t size);
+
+    /**
+     * @brief Writes the buffers in `iov` with `writev`, resuming after short
+     * writes. Modifies `iov`.
+     */
+    bool write_all(struct iovec *iov, int count);
+
+    Options options_;
+    int fd_;
+    std::atomic<bool> ok_;
+    std::vector<uint8_t> chunk_;
+    detail::ChunkHeader chunk_header_;
+    uint32_t chunk_count_;  ///< Chunks handed on so far, i.e. the number of the current one
+    std::vector<detail::IndexEntry> index_;
+
+    std::unique_ptr<util::ThreadPool> pool_;
+    std::mutex mtx_;  ///< Guards `pending_` and `pending_bytes_`
+    std::condition_variable cv_;
+    std::deque<std::shared_ptr<Job>> pending_;
+    size_t pending_bytes_;
+
+    std::mutex io_mtx_;  ///< Held while writing chunks; guards `offset_` and `chunks_`
+    uint64_t offset_;    ///< Bytes written to the file
+    std::vector<detail::ChunkEntry> chunks_;
+};
+
+}  // namespace bag
+}  // namespace rix
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "rix/msg/frame_id.hpp"
+#include "rix/msg/geometry/Twist2DStamped.hpp"
+
+namespace rix {
+namespace msg {
+
+/**
+ * @brief A compact, lossless encoding for streams of `Twist2DStamped`
+ * messages, in which each message is encoded relative to the one before it.
+ *
+ * @details Every message starts with a flags byte that says which fields
+ * follow:
+ *
+ *     SEQ            seq - (previous seq + 1), as a zigzag varint
+ *     RAW_STAMP      sec and nsec as zigzag varints, when nsec is outside
+ *                    [0, 1e9); otherwise the stamp in nanoseconds is sent as
+ *                    the change in its delta since the previous message
+ *                    (delta of delta), as a zigzag varint
+ *     FRAME_*        frame_id: unchanged, a reference to an earlier one by
+ *                    dictionary id (varint), or a new string (varint length
+ *                    and bytes) that is added to the dictionary
+ *     VX, VY, WZ     the raw float, only if its bits changed
+ *
+ * A stream of commands at a steady rate thus costs 2-4 bytes per message
+ * while the twist is unchanged, instead of the 32 of `serialize`. Encoder and
+ * decoder keep the same state, so they must see the same messages in the same
+ * order from the last `reset`. The first message after a reset is encoded against zero
+ * values and an empty dictionary.
+ */
+class DeltaEncoder {
+   public:
+    /**
+     * @brief New frame ids beyond this many are sent as strings every time
+     * rather than added to the dictionary.
+     */
+    static constexpr size_t MAX_FRAME_IDS = 256;
+
+    DeltaEncoder();
+
+    /**
+     * @brief Appends the encoding of `msg` to `out`.
+     */
+    void encode(const geometry::Twist2DStamped &msg, std::vector<uint8_t> &out);
+
+    /**
+     * @brief Returns to the initial state.
+     */
+    void reset();
+
+   private:
+    uint32_t seq_;
+    int64_t stamp_ns_;
+    int64_t delta_ns_;
+    uint32_t frame_;  ///< Dictionary id of the previous frame_id
+    std::unordered_map<FrameId, uint32_t> frames_;
+    geometry::Twist2D twist_;
+};
+
+/**
+ * @brief Decodes a stream written by `DeltaEncoder`.
+ */
+class DeltaDecoder {
+   public:
+    DeltaDecoder();
+
+    /**
+     * @brief Decodes the next message at `offset` in `src` into `msg`.
+     * `offset` is advanced past it.
+     *
+     * @return false if the data is malformed or ends early. The decoder
+     * state is then undefined until `reset`.
+     */
+    bool decode(const uint8_t *src, size_t size, size_t &offset, geometry::Twist2DStamped &msg);
+
+    /**
+     * @brief Returns to the initial state.
+     */
+    void reset();
+
+   private:
+    uint32_t seq_;
+    int64_t stamp_ns_;
+    int64_t delta_ns_;
+    uint32_t frame_;
+    std::vector<FrameId> frames_;
+    geometry::Twist2D twist_;
+};
+
+}  // namespace msg
+}  // namespace rix
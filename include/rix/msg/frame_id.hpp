@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+
+namespace rix {
+namespace msg {
+
+namespace detail {
+
+/**
+ * @brief The string behind a `FrameId`. Interned entries live in the global
+ * intern table for the lifetime of the process and are never modified.
+ */
+struct FrameIdEntry {
+    uint64_t hash;
+    std::string str;
+    bool interned;
+};
+
+}  // namespace detail
+
+/**
+ * @brief An interned frame id, used by `standard::Header` in place of a
+ * `std::string`.
+ *
+ * @details Frame ids are drawn from a handful of values ("mbot", "odom",
+ * ...), so each distinct string is stored once in a global, lock-free intern
+ * table and a `FrameId` is a single pointer to its entry. Copies and
+ * comparisons between frame ids are pointer operations, and deserializing
+ * one looks up the received bytes by their hash without allocating.
+ *
+ * The table holds at most `MAX_INTERNED` strings of up to `MAX_INTERNED_SIZE`
+ * bytes, so that a peer sending arbitrary frame ids cannot grow it without
+ * bound. Strings beyond those limits are still valid frame ids, but each
+ * `FrameId` then owns a private copy, like a `std::string`, and compares by
+ * value.
+ *
+ * On the wire a `FrameId` is a `size_string`, so serialized messages are
+ * unchanged.
+ */
+class FrameId {
+   public:
+    static constexpr size_t MAX_INTERNED = 4096;
+    static constexpr size_t MAX_INTERNED_SIZE = 256;
+
+    /**
+     * @brief The empty frame id.
+     */
+    FrameId();
+
+    FrameId(std::string_view str);
+    FrameId(const std::string &str) : FrameId(std::string_view(str)) {}
+    FrameId(const char *str) : FrameId(std::string_view(str)) {}
+
+    FrameId(const FrameId &other);
+    FrameId(FrameId &&other) noexcept;
+    FrameId &operator=(const FrameId &other);
+    FrameId &operator=(FrameId &&other) noexcept;
+    ~FrameId();
+
+    const std::string &str() const { return entry_->str; }
+    operator const std::string &() const { return entry_->str; }
+    std::string_view view() const { return entry_->str; }
+    const char *c_str() const { return entry_->str.c_str(); }
+    size_t size() const { return entry_->str.size(); }
+    bool empty() const { return entry_->str.empty(); }
+
+    /**
+     * @brief Returns `true` if the string is in the intern table.
+     */
+    bool interned() const { return entry_->interned; }
+
+    /**
+     * @brief Returns the hash of the string, as used by the intern table.
+     */
+    uint64_t hash() const { return entry_->hash; }
+
+    /**
+     * @brief Returns the number of strings in the intern table.
+     */
+    static size_t interned_count();
+
+    friend bool operator==(const FrameId &a, const FrameId &b) {
+        // Interned strings are unique, so two different interned entries never
+        // hold the same string
+        return a.entry_ == b.entry_ || (!(a.entry_->interned && b.entry_->interned) && a.str() == b.str());
+    }
+    friend bool operator==(const FrameId &a, std::string_view b) { return a.view() == b; }
+    friend bool operator==(const FrameId &a, const std::string &b) { return a.view() == b; }
+    friend bool operator==(const FrameId &a, const char *b) { return a.view() == b; }
+
+   private:
+    static const detail::FrameIdEntry *intern(std::string_view str);
+
+    const detail::FrameIdEntry *entry_;
+};
+
+std::ostream &operator<<(std::ostream &os, const FrameId &id);
+
+}  // namespace msg
+}  // namespace rix
+
+template <>
+struct std::hash<rix::msg::FrameId> {
+    size_t operator()(const rix::msg::FrameId &id) const { return static_cast<size_t>(id.hash()); }
+};
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <type_traits>
+
+#include "rix/msg/message.hpp"
+#include "rix/msg/serialization.hpp"
+
+namespace rix {
+namespace msg {
+
+/**
+ * @brief A read-only view of a message vector serialized with
+ * `detail::serialize_indexed_message_vector`, giving O(1) access to any
+ * element.
+ *
+ * @details `parse` only reads the header and locates the offset table; no
+ * element is decoded until `get` asks for it. Large payloads such as particle
+ * sets or scan batches can thus be decoded partially, or in any order. The
+ * view points into the source buffer, which must outlive it.
+ *
+ * Table entries are checked when an element is accessed, so a corrupt entry
+ * makes that element fail to decode rather than the whole vector.
+ */
+template <typename T>
+class MessageVectorView {
+    static_assert(std::is_base_of<Message, T>::value, "T must derive from Message");
+
+   public:
+    MessageVectorView() = default;
+
+    /**
+     * @brief Locates the indexed vector at `offset` in `src`. `offset` is
+     * advanced past it, as by `deserialize_indexed_message_vector`.
+     *
+     * @return false if the data is shorter than the header claims.
+     */
+    bool parse(const uint8_t *src, size_t size, size_t &offset) {
+        size_t pos = offset;
+        uint32_t len, bytes;
+        if (!detail::deserialize_number(len, src, size, pos) || !detail::deserialize_number(bytes, src, size, pos)) {
+            return false;
+        }
+        if (size - pos < bytes || (size - pos - bytes) / 4 < len) {
+            return false;
+        }
+        elements_ = src + pos;
+        bytes_ = bytes;
+        table_ = elements_ + bytes;
+        len_ = len;
+        offset = pos + bytes + 4 * static_cast<size_t>(len);
+        return true;
+    }
+
+    size_t size() const { return len_; }
+    bool empty() const { return len_ == 0; }
+
+    /**
+     * @brief Returns the serialized bytes of element `i`, or an empty span if
+     * `i` is out of range or its table entry is out of bounds.
+     */
+    std::span<const uint8_t> bytes(size_t i) const {
+        uint32_t begin, end;
+        if (!extent(i, begin, end)) {
+            return {};
+        }
+        return {elements_ + begin, end - begin};
+    }
+
+    /**
+     * @brief Decodes element `i` into `dst`.
+     *
+     * @return false if `i` is out of range or the element does not decode to
+     * exactly its extent.
+     */
+    bool get(size_t i, T &dst) const {
+        uint32_t begin, end;
+        if (!extent(i, begin, end)) {
+            return false;
+        }
+        size_t pos = 0;
+        return dst.deserialize(elements_ + begin, end - begin, pos) && pos == end - begin;
+    }
+
+   private:
+    /**
+     * @brief Finds where element `i` starts and ends in the elements, from
+     * its table entry and the next one.
+     */
+    bool extent(size_t i, uint32_t &begin, uint32_t &end) const {
+        if (i >= len_) {
+            return false;
+        }
+        begin = entry(i);
+        end = i + 1 < len_ ? entry(i + 1) : bytes_;
+        return begin <= end && end <= bytes_;
+    }
+
+    uint32_t entry(size_t i) const {
+        uint32_t value;
+        std::memcpy(&value, table_ + 4 * i, sizeof(value));
+        return value;
+    }
+
+    const uint8_t *elements_ = nullptr;
+    const uint8_t *table_ = nullptr;
+    uint32_t bytes_ = 0;
+    uint32_t len_ = 0;
+};
+
+}  // namespace msg
+}  // namespace rix
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "rix/msg/geometry/Twist2D.hpp"
+
+namespace rix {
+namespace msg {
+
+/**
+ * @brief Maps floats in a fixed range onto 16-bit codes with a fixed
+ * resolution, for compact wire representations of bounded quantities such as
+ * velocities and poses.
+ *
+ * @details Code `c` stands for `min + c * resolution`. A value within
+ * [`min`, `max`] is encoded as the nearest code, so it decodes to within
+ * `resolution / 2` of itself (plus float rounding). Values outside the range
+ * are clamped to it, and NaN is encoded as the code nearest zero so that a
+ * corrupt command decodes to "stop" rather than full speed.
+ *
+ * The range may hold at most 65535 steps of `resolution`. `max` is rounded up
+ * to a whole number of steps.
+ */
+class Quantizer {
+   public:
+    /**
+     * @brief Throws `std::invalid_argument` if `resolution` is not positive,
+     * `max` is not above `min`, or the range needs more than 16 bits.
+     */
+    Quantizer(float min, float max, float resolution);
+
+    float min() const { return min_; }
+    float max() const { return min_ + steps_ * resolution_; }
+    float resolution() const { return resolution_; }
+    uint16_t steps() const { return static_cast<uint16_t>(steps_); }
+
+    uint16_t encode(float value) const { return encode_one(value); }
+    float decode(uint16_t code) const { return min_ + static_cast<float>(code) * resolution_; }
+
+    /**
+     * @brief Encodes `n` values. Gives the same codes as `encode` one at a
+     * time; the loop is written to be auto-vectorized.
+     */
+    void encode(const float *src, size_t n, uint16_t *dst) const;
+
+    /**
+     * @brief Decodes `n` codes. Gives the same values as `decode` one at a
+     * time; the loop is written to be auto-vectorized.
+     */
+    void decode(const uint16_t *src, size_t n, float *dst) const;
+
+   private:
+    uint16_t clamp_one(float value) const {
+        float q = (value - min_) * scale_;
+        q = q > 0.0f ? q : 0.0f;  // Also maps NaN to 0; `encode` fixes that up
+        q = q < steps_ ? q : steps_;
+        return static_cast<uint16_t>(static_cast<int32_t>(q + 0.5f));
+    }
+
+    static bool is_nan(float value) {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return (bits & 0x7fffffff) > 0x7f800000;
+    }
+
+    uint16_t encode_one(float value) const { return is_nan(value) ? zero_ : clamp_one(value); }
+
+    float min_;
+    float resolution_;
+    float scale_;    ///< 1 / resolution
+    float steps_;    ///< The largest code
+    uint16_t zero_;  ///< The code nearest zero
+};
+
+/**
+ * @brief An opt-in quantized wire representation of `geometry::Twist2D`:
+ * `vx`, `vy` and `wz` as three 16-bit codes, 6 bytes instead of 12.
+ *
+ * @details Both ends must agree on the quantizers; the representation carries
+ * no description of them. The defaults cover +/-4 m/s and +/-16 rad/s at a
+ * resolution of 1 mm/s and 1 mrad/s, beyond anything the MBot can drive.
+ */
+struct Twist2DQuantization {
+    static constexpr size_t SIZE = 3 * sizeof(uint16_t);
+
+    Quantizer linear{-4.0f, 4.0f, 0.001f};    ///< vx and vy, in m/s
+    Quantizer angular{-16.0f, 16.0f, 0.001f};  ///< wz, in rad/s
+
+    void serialize(const geometry::Twist2D &src, uint8_t *dst, size_t &offset) const;
+
+    /**
+     * @return false if fewer than `SIZE` bytes remain at `offset`.
+     */
+    bool deserialize(geometry::Twist2D &dst, const uint8_t *src, size_t size, size_t &offset) const;
+
+    /**
+     * @brief Serializes `n` twists back to back into `dst`, which must hold
+     * `n * SIZE` bytes.
+     */
+    void serialize(const geometry::Twist2D *src, size_t n, uint8_t *dst) const;
+
+    /**
+     * @brief Deserializes `n` twists written by the batch `serialize`.
+     */
+    void deserialize(const uint8_t *src, size_t n, geometry::Twist2D *dst) const;
+};
+
+}  // namespace msg
+}  // namespace rix
@@ -5,8 +5,11 @@
 #include <cstring>
 #include <map>
 #include <string>
+#include <string_view>
+#include <type_traits>
 #include <vector>
 
+#include "rix/msg/frame_id.hpp"
 #include "rix/msg/message.hpp"
 
 namespace rix {
@@ -19,6 +22,11 @@ inline uint32_t size_number(const T &src) {
     return sizeof(T);
 }
 inline uint32_t size_string(const std::string &src) { return 4 + src.size(); }
+// The FrameId overloads are templates so that string literals still pick the
+// std::string ones instead of being ambiguous
+template <typename T>
+    requires std::is_same_v<T, FrameId>
+inline uint32_t size_string(const T &src) { return 4 + src.size(); }
 inline uint32_t size_message(const Message &src) { return src.size(); }
 template <typename T, size_t N>
 inline uint32_t size_number_array(const std::array<T, N> &src) {
@@ -55,6 +63,13 @@ inline uint32_t size_message_vector(const std::vector<T> &src) {
     for (const auto &m : src) size += size_message(m);
     return size;
 }
+template <typename T>
+inline uint32_t size_indexed_message_vector(const std::vector<T> &src) {
+    static_assert(std::is_base_of<Message, T>::value, "T must derive from Message");
+    uint32_t size = 8 + 4 * src.size();
+    for (const auto &m : src) size += size_message(m);
+    return size;
+}
 
 /**
  * @brief Serializes a number `src` and stores it in the byte array `dst` at
@@ -93,6 +108,20 @@ inline void serialize_string(uint8_t *dst, size_t &offset, const std::string &sr
     offset += src.size();
 }
 
+/**
+ * @brief Serializes a frame id `src` with the same layout as a string.
+ *
+ * @param dst The destination byte array
+ * @param offset The offset in the byte array at which to write (incremented by
+ * number of bytes written)
+ * @param src The source frame id to be serialized
+ */
+template <typename T>
+    requires std::is_same_v<T, FrameId>
+inline void serialize_string(uint8_t *dst, size_t &offset, const T &src) {
+    serialize_string(dst, offset, src.str());
+}
+
 /**
  * @brief Serializes a message `src` and stores it in the byte array `dst` at
  * `offset`. `offset` is incremented by the number of bytes written to `dst`.
@@ -235,6 +264,45 @@ inline void serialize_message_vector(uint8_t *dst, size_t &offset,
     }
 }
 
+/**
+ * @brief Serializes a message vector `src` in the indexed layout and stores it
+ * in the byte array `dst` at `offset`. `offset` is incremented by the number
+ * of bytes written to `dst`.
+ *
+ * @details The layout is the element count and the byte length of the
+ * elements (both uint32_t), the elements, then a table with the uint32_t
+ * offset of each element from the start of the elements. The table lets
+ * `MessageVectorView` reach any element without parsing the ones before it.
+ *
+ * @tparam T The type of the source array (must derive from Message)
+ * @param dst The destination byte array
+ * @param offset The offset in the byte array at which to write (incremented by
+ * number of bytes written)
+ * @param src The source message vector to be serialized
+ */
+template <typename T>
+inline void serialize_indexed_message_vector(uint8_t *dst, size_t &offset,
+                                             const std::vector<T> &src) {
+    static_assert(std::is_base_of<Message, T>::value, "T must derive from Message");
+    uint32_t len = static_cast<uint32_t>(src.size());
+    uint32_t bytes = 0;
+    for (const auto &m : src) {
+        bytes += size_message(m);
+    }
+    serialize_number(dst, offset, len);
+    serialize_number(dst, offset, bytes);
+
+    // Serialize each message, filling in the table behind the elements as
+    // they are written
+    const size_t start = offset;
+    size_t table = start + bytes;
+    for (const auto &m : src) {
+        serialize_number(dst, table, static_cast<uint32_t>(offset - start));
+        serialize_message(dst, offset, m);
+    }
+    offset = table;
+}
+
 /**
  * @brief Deserializes a number from the byte array `src` at `offset` and stores
  * it into `dst`. `src` must be at least `size` bytes long.
@@ -296,6 +364,33 @@ inline bool deserialize_string(std::string &dst, const uint8_t *src, size_t size
     return true;
 }
 
+/**
+ * @brief Deserializes a string from the byte array `src` at `offset` and
+ * stores it into the frame id `dst`. `src` must be at least `size` bytes long.
+ * Frame ids already in the intern table are found by the hash of the bytes
+ * without allocating.
+ *
+ * @param dst The destination frame id
+ * @param src The source byte array
+ * @param size The size of the byte array
+ * @param offset The position in the source byte array to deserialize data from
+ * @return `false` if the number of bytes needed to deserialize the string is
+ * greater than the number of bytes available in the source byte array. `true`
+ * otherwise.
+ */
+inline bool deserialize_string(FrameId &dst, const uint8_t *src, size_t size, size_t &offset) {
+    uint32_t len;
+    if (!deserialize_number(len, src, size, offset)) {
+        return false;
+    }
+    if (offset + len > size) {
+        return false;
+    }
+    dst = FrameId(std::string_view(reinterpret_cast<const char *>(src + offset), len));
+    offset += len;
+    return true;
+}
+
 /**
  * @brief Deserializes a message from the byte array `src` at `offset` and
  * stores it into `dst`. `src` must be at least `size` bytes long.
@@ -498,6 +593,51 @@ inline bool deserialize_message_vector(std::vector<T> &dst, const uint8_t *src,
 
     return true;
 }
+
+/**
+ * @brief Deserializes a message vector in the indexed layout (see
+ * `serialize_indexed_message_vector`) from the byte array `src` at `offset`
+ * and stores it into `dst`. `src` must be at least `size` bytes long.
+ *
+ * @tparam T The type of the destination array (must derive from Message)
+ * @param dst The destination message vector
+ * @param src The source byte array
+ * @param size The size of the byte array
+ * @param offset The position in the source byte array to deserialize data from
+ * @return `false` if the data is shorter than its header claims, or if an
+ * element does not start at its offset in the table. `true` otherwise.
+ */
+template <typename T>
+inline bool deserialize_indexed_message_vector(std::vector<T> &dst, const uint8_t *src,
+                                               size_t size, size_t &offset) {
+    static_assert(std::is_base_of<Message, T>::value, "T must derive from Message");
+    uint32_t len, bytes;
+    if (!deserialize_number(len, src, size, offset) || !deserialize_number(bytes, src, size, offset)) {
+        return false;
+    }
+    if (size - offset < bytes || (size - offset - bytes) / 4 < len) {
+        return false;
+    }
+
+    // The elements may not run into the table
+    const size_t start = offset;
+    const size_t end = start + bytes;
+    size_t table = end;
+    dst.resize(len);
+    for (auto &m : dst) {
+        uint32_t element;
+        if (!deserialize_number(element, src, size, table) || offset - start != element ||
+            !deserialize_message(m, src, end, offset)) {
+            return false;
+        }
+    }
+    if (offset != end) {
+        return false;
+    }
+    offset = table;
+    return true;
+}
+
 }  // namespace detail
 }  // namespace msg
-}  // namespace rix
\ No newline at end of file
+}  // namespace rix
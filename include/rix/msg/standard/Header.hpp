@@ -7,6 +7,7 @@
 #include <string>
 #include <cstring>
 
+#include "rix/msg/frame_id.hpp"
 #include "rix/msg/serialization.hpp"
 #include "rix/msg/message.hpp"
 #include "rix/msg/standard/Time.hpp"
@@ -19,7 +20,7 @@ class Header : public Message {
   public:
     uint32_t seq{};
     standard::Time stamp{};
-    std::string frame_id{};
+    FrameId frame_id{};
 
     Header() = default;
     Header(const Header &other) = default;
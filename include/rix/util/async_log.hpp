@@ -0,0 +1,330 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "rix/util/time.hpp"
+
+namespace rix {
+namespace util {
+namespace detail {
+
+/**
+ * @brief LogRing class. A single-producer, single-consumer ring of bytes.
+ * Each logging thread owns one ring and publishes complete records into it;
+ * the AsyncLogWriter thread is the only consumer. Records are published
+ * atomically with respect to the consumer, so it never sees a partial record.
+ *
+ */
+class LogRing {
+   public:
+    explicit LogRing(size_t capacity);
+
+    /**
+     * @brief Appends a record. Never blocks: if the ring does not have room
+     * the record is dropped and counted.
+     *
+     * @return true if the record was appended.
+     */
+    bool push(const char *data, size_t len);
+
+    /**
+     * @brief Appends every published byte to `out` and frees the space.
+     *
+     * @return The number of bytes drained.
+     */
+    size_t drain(std::string &out);
+
+    /**
+     * @brief Returns the number of dropped records and resets the count.
+     */
+    uint64_t take_dropped();
+
+    void close();
+    bool closed() const;
+    bool empty() const;
+
+   private:
+    std::unique_ptr<char[]> buf_;
+    const size_t mask_;
+    alignas(64) std::atomic<uint64_t> head_;  ///< Consumer position
+    alignas(64) std::atomic<uint64_t> tail_;  ///< Producer position
+    std::atomic<uint64_t> dropped_;
+    std::atomic<bool> closed_;
+};
+
+inline size_t log_ring_capacity(size_t n) {
+    size_t capacity = 1;
+    while (capacity < n) {
+        capacity <<= 1;
+    }
+    return capacity;
+}
+
+inline LogRing::LogRing(size_t capacity)
+    : buf_(new char[log_ring_capacity(capacity)]),
+      mask_(log_ring_capacity(capacity) - 1),
+      head_(0),
+      tail_(0),
+      dropped_(0),
+      closed_(false) {}
+
+inline bool LogRing::push(const char *data, size_t len) {
+    uint64_t tail = tail_.load(std::memory_order_relaxed);
+    uint64_t head = head_.load(std::memory_order_acquire);
+    if (len > mask_ + 1 - (tail - head)) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    size_t pos = tail & mask_;
+    size_t first = std::min(len, mask_ + 1 - pos);
+    std::memcpy(buf_.get() + pos, data, first);
+    std::memcpy(buf_.get(), data + first, len - first);
+    tail_.store(tail + len, std::memory_order_release);
+    return true;
+}
+
+inline size_t LogRing::drain(std::string &out) {
+    uint64_t head = head_.load(std::memory_order_relaxed);
+    uint64_t tail = tail_.load(std::memory_order_acquire);
+    size_t len = tail - head;
+    size_t pos = head & mask_;
+    size_t first = std::min(len, mask_ + 1 - pos);
+    out.append(buf_.get() + pos, first);
+    out.append(buf_.get(), len - first);
+    head_.store(tail, std::memory_order_release);
+    return len;
+}
+
+inline uint64_t LogRing::take_dropped() { return dropped_.exchange(0, std::memory_order_relaxed); }
+
+inline void LogRing::close() { closed_.store(true, std::memory_order_release); }
+
+inline bool LogRing::closed() const { return closed_.load(std::memory_order_acquire); }
+
+inline bool LogRing::empty() const {
+    return head_.load(std::memory_order_relaxed) == tail_.load(std::memory_order_acquire);
+}
+
+/**
+ * @brief AsyncLogWriter class. Owns the per-thread LogRings and a background
+ * thread that periodically drains them into one batch, which is written to
+ * the target stream buffer with a single `sputn`. Logging threads only copy
+ * bytes into their own ring; they never take a lock or touch the target.
+ *
+ */
+class AsyncLogWriter {
+   public:
+    /**
+     * @brief Called with each drained batch and the number of records dropped
+     * since the last batch, before the batch is written. The default appends
+     * a text line reporting dropped records.
+     */
+    using Finisher = std::function<void(std::string &batch, uint64_t dropped)>;
+
+    AsyncLogWriter() = default;
+    explicit AsyncLogWriter(Finisher finisher);
+    ~AsyncLogWriter();
+
+    /**
+     * @brief Starts the writer thread. Does nothing if already running.
+     *
+     * @param target The stream buffer to write batches to.
+     * @param ring_capacity The capacity of each thread's ring in bytes.
+     * @param interval How often the writer thread drains the rings.
+     */
+    void start(std::streambuf *target, size_t ring_capacity = 1 << 16, const Duration &interval = Duration(0.001));
+
+    /**
+     * @brief Drains all rings and stops the writer thread.
+     */
+    void stop();
+
+    bool running() const;
+
+    /**
+     * @brief Returns the calling thread's ring, creating and registering it
+     * on first use.
+     */
+    LogRing &ring();
+
+    /**
+     * @brief Drains all rings into the target now.
+     *
+     * @return The number of bytes written.
+     */
+    size_t flush();
+
+   private:
+    /**
+     * @brief A thread's ring for one writer. Lookups compare only `id` and
+     * `generation`; `writer` expires when the writer is destroyed and is only
+     * checked on a miss, to prune entries of writers that are gone.
+     */
+    struct RingHandle {
+        uint64_t id;
+        uint64_t generation;
+        std::weak_ptr<const char> writer;
+        std::shared_ptr<LogRing> ring;
+    };
+
+    /**
+     * @brief Closes its rings when the owning thread exits. Each writer keeps
+     * its ring alive until it has been drained.
+     */
+    struct RingHandles {
+        std::vector<RingHandle> rings;
+        ~RingHandles() {
+            for (auto &entry : rings) {
+                entry.ring->close();
+            }
+        }
+    };
+
+    void run();
+
+    static uint64_t next_id() {
+        static std::atomic<uint64_t> next{1};
+        return next.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    Finisher finisher_;
+    const uint64_t id_ = next_id();  ///< Unique across writers, even at a reused address
+    const std::shared_ptr<const char> token_ = std::make_shared<const char>();  ///< Expires RingHandles of this writer
+    std::atomic<uint64_t> generation_{0};  ///< Bumped when the ring capacity changes, retiring every ring
+    std::streambuf *target_ = nullptr;
+    std::atomic<size_t> ring_capacity_{1 << 16};
+    Duration interval_;
+    std::atomic<bool> running_{false};
+    std::atomic<bool> stop_{false};
+    std::mutex wake_mtx_;  ///< Pairs with `wake_cv_`, which `stop` notifies
+    std::condition_variable wake_cv_;
+    std::thread thr_;
+
+    std::mutex rings_mtx_;  ///< Guards `rings_`; taken once per thread, not per record
+    std::vector<std::shared_ptr<LogRing>> rings_;
+    std::mutex drain_mtx_;  ///< Serializes draining between the writer thread and `flush`
+    std::string batch_;
+};
+
+inline AsyncLogWriter::AsyncLogWriter(Finisher finisher) : finisher_(std::move(finisher)) {}
+
+inline AsyncLogWriter::~AsyncLogWriter() { stop(); }
+
+inline void AsyncLogWriter::start(std::streambuf *target, size_t ring_capacity, const Duration &interval) {
+    if (running_) {
+        return;
+    }
+    target_ = target;
+    if (ring_capacity != ring_capacity_.load(std::memory_order_relaxed)) {
+        // Threads replace their rings on their next record; the old ones are
+        // drained and then forgotten
+        ring_capacity_.store(ring_capacity, std::memory_order_relaxed);
+        generation_.fetch_add(1, std::memory_order_release);
+    }
+    interval_ = interval;
+    stop_ = false;
+    running_ = true;
+    thr_ = std::thread(&AsyncLogWriter::run, this);
+}
+
+inline void AsyncLogWriter::stop() {
+    if (!running_) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> guard(wake_mtx_);
+        stop_ = true;
+    }
+    wake_cv_.notify_all();
+    if (thr_.joinable()) {
+        thr_.join();
+    }
+    running_ = false;
+    flush();
+}
+
+inline bool AsyncLogWriter::running() const { return running_.load(std::memory_order_relaxed); }
+
+inline LogRing &AsyncLogWriter::ring() {
+    thread_local RingHandles handles;
+    uint64_t generation = generation_.load(std::memory_order_acquire);
+    for (auto &entry : handles.rings) {
+        if (entry.id == id_ && entry.generation == generation) {
+            return *entry.ring;
+        }
+    }
+
+    // Miss: drop rings this writer has retired or whose writer is gone
+    for (auto it = handles.rings.begin(); it != handles.rings.end();) {
+        if (it->id == id_ || it->writer.expired()) {
+            it->ring->close();
+            it = handles.rings.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    auto ring = std::make_shared<LogRing>(ring_capacity_.load(std::memory_order_relaxed));
+    {
+        std::lock_guard<std::mutex> guard(rings_mtx_);
+        rings_.push_back(ring);
+    }
+    handles.rings.push_back({id_, generation, token_, ring});
+    return *ring;
+}
+
+inline size_t AsyncLogWriter::flush() {
+    std::lock_guard<std::mutex> drain_guard(drain_mtx_);
+    uint64_t dropped = 0;
+    {
+        std::lock_guard<std::mutex> guard(rings_mtx_);
+        for (auto &ring : rings_) {
+            ring->drain(batch_);
+            dropped += ring->take_dropped();
+        }
+        // Forget rings whose threads have exited once they are empty
+        rings_.erase(std::remove_if(rings_.begin(), rings_.end(),
+                                    [](const std::shared_ptr<LogRing> &r) { return r->closed() && r->empty(); }),
+                     rings_.end());
+    }
+    if (finisher_) {
+        finisher_(batch_, dropped);
+    } else if (dropped > 0) {
+        batch_ += "[rix::util::Log] " + std::to_string(dropped) + " records dropped\n";
+    }
+    if (!batch_.empty() && target_) {
+        target_->sputn(batch_.data(), batch_.size());
+        target_->pubsync();
+    }
+    size_t written = batch_.size();
+    batch_.clear();
+    return written;
+}
+
+inline void AsyncLogWriter::run() {
+    // Keep draining while there is a backlog; otherwise poll at `interval_`.
+    // The wait is in real time, not on `Time`, so that the writer keeps
+    // draining and can be stopped while a SimulatedClock runs.
+    const auto interval = std::chrono::nanoseconds(interval_.to_nanoseconds());
+    while (!stop_) {
+        if (flush() == 0) {
+            std::unique_lock<std::mutex> lock(wake_mtx_);
+            wake_cv_.wait_for(lock, interval, [this] { return stop_.load(); });
+        }
+    }
+}
+
+}  // namespace detail
+}  // namespace util
+}  // namespace rix
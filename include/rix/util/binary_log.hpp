@@ -0,0 +1,345 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "rix/util/async_log.hpp"
+#include "rix/util/log.hpp"
+#include "rix/util/time.hpp"
+
+/**
+ * @brief Logs a message in the binary format. `fmt` must be a string literal
+ * with one `{}` placeholder per argument; this is checked at compile time.
+ * Statements below RIX_UTIL_LOG_LEVEL compile to nothing.
+ *
+ *     RIX_BINLOG_INFO("sent {} bytes to {}", n, name);
+ */
+#define RIX_BINLOG(level, fmt, ...)                                                                  \
+    ::rix::util::BinaryLog::write([] { return ::rix::util::BinaryLogSite{level, fmt, __FILE__, __LINE__}; } \
+                                  __VA_OPT__(, ) __VA_ARGS__)
+#define RIX_BINLOG_DEBUG(fmt, ...) RIX_BINLOG(::rix::util::Log::Level::DEBUG, fmt __VA_OPT__(, ) __VA_ARGS__)
+#define RIX_BINLOG_INFO(fmt, ...) RIX_BINLOG(::rix::util::Log::Level::INFO, fmt __VA_OPT__(, ) __VA_ARGS__)
+#define RIX_BINLOG_WARN(fmt, ...) RIX_BINLOG(::rix::util::Log::Level::WARN, fmt __VA_OPT__(, ) __VA_ARGS__)
+#define RIX_BINLOG_ERROR(fmt, ...) RIX_BINLOG(::rix::util::Log::Level::ERROR, fmt __VA_OPT__(, ) __VA_ARGS__)
+#define RIX_BINLOG_FATAL(fmt, ...) RIX_BINLOG(::rix::util::Log::Level::FATAL, fmt __VA_OPT__(, ) __VA_ARGS__)
+
+namespace rix {
+namespace util {
+
+/**
+ * @brief The static description of a binary log statement. It is written to
+ * the log once, in a dictionary entry, so records only carry its ID.
+ */
+struct BinaryLogSite {
+    Log::Level level;
+    const char *format;
+    const char *file;
+    int line;
+};
+
+namespace detail {
+
+/**
+ * @brief Type tags of binary log arguments. Values are part of the file
+ * format.
+ */
+enum class BinaryArgType : uint8_t {
+    BOOL,
+    CHAR,
+    INT8,
+    UINT8,
+    INT16,
+    UINT16,
+    INT32,
+    UINT32,
+    INT64,
+    UINT64,
+    FLOAT,
+    DOUBLE,
+    STRING,
+};
+
+template <typename T>
+inline constexpr bool dependent_false = false;
+
+template <typename T>
+constexpr BinaryArgType binary_arg_type() {
+    using U = std::decay_t<T>;
+    if constexpr (std::is_same_v<U, bool>) {
+        return BinaryArgType::BOOL;
+    } else if constexpr (std::is_same_v<U, char>) {
+        return BinaryArgType::CHAR;
+    } else if constexpr (std::is_enum_v<U>) {
+        return binary_arg_type<std::underlying_type_t<U>>();
+    } else if constexpr (std::is_integral_v<U>) {
+        constexpr bool s = std::is_signed_v<U>;
+        switch (sizeof(U)) {
+            case 1:
+                return s ? BinaryArgType::INT8 : BinaryArgType::UINT8;
+            case 2:
+                return s ? BinaryArgType::INT16 : BinaryArgType::UINT16;
+            case 4:
+                return s ? BinaryArgType::INT32 : BinaryArgType::UINT32;
+            default:
+                return s ? BinaryArgType::INT64 : BinaryArgType::UINT64;
+        }
+    } else if constexpr (std::is_same_v<U, float>) {
+        return BinaryArgType::FLOAT;
+    } else if constexpr (std::is_floating_point_v<U>) {
+        return BinaryArgType::DOUBLE;
+    } else if constexpr (std::is_convertible_v<const U &, std::string_view>) {
+        return BinaryArgType::STRING;
+    } else {
+        static_assert(dependent_false<T>, "Unsupported binary log argument type");
+    }
+}
+
+/**
+ * @brief Returns the number of bytes an argument of the given type occupies,
+ * excluding the payload of strings.
+ */
+constexpr size_t binary_arg_width(BinaryArgType type) {
+    switch (type) {
+        case BinaryArgType::BOOL:
+        case BinaryArgType::CHAR:
+        case BinaryArgType::INT8:
+        case BinaryArgType::UINT8:
+            return 1;
+        case BinaryArgType::INT16:
+        case BinaryArgType::UINT16:
+            return 2;
+        case BinaryArgType::INT32:
+        case BinaryArgType::UINT32:
+        case BinaryArgType::FLOAT:
+        case BinaryArgType::STRING:  // Length prefix
+            return 4;
+        case BinaryArgType::INT64:
+        case BinaryArgType::UINT64:
+        case BinaryArgType::DOUBLE:
+            return 8;
+    }
+    return 0;
+}
+
+constexpr size_t count_placeholders(const char *fmt) {
+    size_t n = 0;
+    for (; *fmt != '\0'; fmt++) {
+        if (fmt[0] == '{' && fmt[1] == '}') {
+            n++;
+            fmt++;
+        }
+    }
+    return n;
+}
+
+template <typename T>
+size_t binary_arg_size(const T &val) {
+    constexpr BinaryArgType type = binary_arg_type<T>();
+    if constexpr (type == BinaryArgType::STRING) {
+        return binary_arg_width(type) + std::string_view(val).size();
+    } else {
+        return binary_arg_width(type);
+    }
+}
+
+template <typename T>
+char *write_binary_arg(char *dst, const T &val) {
+    constexpr BinaryArgType type = binary_arg_type<T>();
+    if constexpr (type == BinaryArgType::STRING) {
+        std::string_view str(val);
+        uint32_t len = static_cast<uint32_t>(str.size());
+        std::memcpy(dst, &len, sizeof(len));
+        std::memcpy(dst + sizeof(len), str.data(), len);
+        return dst + sizeof(len) + len;
+    } else if constexpr (type == BinaryArgType::DOUBLE) {
+        double v = static_cast<double>(val);
+        std::memcpy(dst, &v, sizeof(v));
+        return dst + sizeof(v);
+    } else {
+        std::memcpy(dst, &val, sizeof(val));
+        return dst + sizeof(val);
+    }
+}
+
+}  // namespace detail
+
+/**
+ * @brief Binary structured logger. Instead of formatting text at runtime,
+ * each log statement is registered once, on first use, and assigned an ID.
+ * The site's level, format string, source location and argument types are
+ * written once to the log as a dictionary entry; after that each call only
+ * copies the ID, a timestamp and the raw argument bytes into the calling
+ * thread's LogRing. The rings are drained to the file by a background thread.
+ * Use `rix_logcat` to decode a log to text.
+ *
+ * File format (native byte order):
+ *
+ *     header:     "RIXLOG\0" version:u8 name_len:u16 name
+ *     dictionary: 'D' id:u32 level:u8 line:u32 file_len:u16 file fmt_len:u16 fmt nargs:u8 types:u8[nargs]
+ *     record:     'R' id:u32 nanoseconds:i64 args...
+ *     dropped:    'X' count:u64
+ *
+ * Strings in records are encoded as len:u32 bytes.
+ */
+class BinaryLog {
+   public:
+    static constexpr char MAGIC[8] = {'R', 'I', 'X', 'L', 'O', 'G', '\0', 1};
+    static constexpr char DICTIONARY = 'D';
+    static constexpr char RECORD = 'R';
+    static constexpr char DROPPED = 'X';
+
+    /**
+     * @brief Opens ~/.rix/log/<name>_<ns>.rixlog and starts the writer.
+     *
+     * @return true on success.
+     */
+    static bool init(const std::string &name);
+
+    /**
+     * @brief Opens `path` and starts the writer. Any log already open is
+     * closed first.
+     *
+     * @return true on success.
+     */
+    static bool open(const std::string &path, const std::string &name);
+
+    /**
+     * @brief Writes out all queued records, stops the writer and closes the
+     * file.
+     */
+    static void close();
+
+    /**
+     * @brief Writes out all queued records.
+     */
+    static void flush();
+
+    static bool is_open();
+
+    /**
+     * @brief Logs a record. Called through the RIX_BINLOG macros, which pass
+     * a lambda returning the call site so that every statement instantiates
+     * its own copy with its own ID.
+     */
+    template <typename SiteFn, typename... Args>
+    static void write(SiteFn site_fn, const Args &...args);
+
+   private:
+    static uint32_t register_site(const BinaryLogSite &site, const detail::BinaryArgType *types, size_t n);
+    static void finish(std::string &batch, uint64_t dropped);
+    static void append_dictionary_entry(std::string &out, uint32_t id);
+
+    struct Entry {
+        BinaryLogSite site;
+        std::vector<detail::BinaryArgType> types;
+    };
+
+    static std::mutex mutex_;         ///< Guards `sites_` and `dictionary_`
+    static std::vector<Entry> sites_;
+    static std::string dictionary_;   ///< Dictionary entries not yet written
+    static std::filebuf file_;
+    static detail::AsyncLogWriter writer_;
+};
+
+template <typename SiteFn, typename... Args>
+void BinaryLog::write(SiteFn /*site*/, const Args &...args) {
+    static constexpr BinaryLogSite site = SiteFn{}();
+    static_assert(detail::count_placeholders(site.format) == sizeof...(Args),
+                  "Binary log format does not match its number of arguments");
+    if constexpr (site.level >= RIX_UTIL_LOG_LEVEL) {
+        if (!writer_.running()) {
+            return;
+        }
+        static constexpr detail::BinaryArgType types[sizeof...(Args) + 1] = {detail::binary_arg_type<Args>()...};
+        static const uint32_t id = register_site(site, types, sizeof...(Args));
+
+        int64_t ns = Time::now().to_nanoseconds();
+        size_t size = 1 + sizeof(id) + sizeof(ns) + (detail::binary_arg_size(args) + ... + 0);
+
+        char stack[256];
+        std::string heap;
+        char *data = stack;
+        if (size > sizeof(stack)) {
+            heap.resize(size);
+            data = heap.data();
+        }
+
+        char *p = data;
+        *p++ = RECORD;
+        std::memcpy(p, &id, sizeof(id));
+        p += sizeof(id);
+        std::memcpy(p, &ns, sizeof(ns));
+        p += sizeof(ns);
+        ((p = detail::write_binary_arg(p, args)), ...);
+
+        writer_.ring().push(data, size);
+    }
+}
+
+/**
+ * @brief A decoded binary log record.
+ */
+struct BinaryLogRecord {
+    Time stamp;
+    Log::Level level;
+    std::string file;
+    int line;
+    std::string message;
+};
+
+/**
+ * @brief Reads a log written by BinaryLog and formats its records.
+ */
+class BinaryLogReader {
+   public:
+    /**
+     * @brief Reads the log at `path`.
+     *
+     * @return true if the file exists and has a valid header.
+     */
+    bool open(const std::string &path);
+
+    /**
+     * @brief Decodes the next record, applying any dictionary entries that
+     * precede it. Dropped-record markers are returned as WARN records.
+     *
+     * @return false at the end of the log, or if the rest of it is truncated
+     * or corrupt.
+     */
+    bool next(BinaryLogRecord &record);
+
+    /**
+     * @brief The name the log was opened with.
+     */
+    const std::string &name() const;
+
+   private:
+    struct Entry {
+        bool valid = false;
+        Log::Level level;
+        int line;
+        std::string file;
+        std::string format;
+        std::vector<detail::BinaryArgType> types;
+    };
+
+    bool read(void *dst, size_t n);
+    bool read_string(std::string &dst, size_t n);
+    bool read_dictionary_entry();
+    bool read_record(BinaryLogRecord &record);
+
+    std::string data_;
+    size_t pos_ = 0;
+    std::string name_;
+    std::vector<Entry> entries_;
+    Time last_stamp_;
+};
+
+}  // namespace util
+}  // namespace rix
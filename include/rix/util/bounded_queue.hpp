@@ -0,0 +1,266 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+namespace rix {
+namespace util {
+
+/**
+ * @brief What `BoundedQueue::push` does when the queue is full.
+ */
+enum class OverflowPolicy {
+    BLOCK,        ///< Wait for the consumer to make room
+    DROP_NEWEST,  ///< Discard the element being pushed
+    DROP_OLDEST,  ///< Discard the oldest queued element to make room
+    KEEP_LATEST   ///< Discard every queued element so only the newest is kept
+};
+
+/**
+ * @brief A bounded, lock-free queue for passing elements between pipeline
+ * stages.
+ *
+ * @details The ring follows Dmitry Vyukov's bounded queue: every cell carries
+ * a sequence number that tells producers and consumers whether it is free or
+ * full, so neither side ever reads a cell the other is writing. This also
+ * lets a producer evict the oldest element (acting as a second consumer),
+ * which is how the `DROP_OLDEST` and `KEEP_LATEST` overflow policies are
+ * implemented without locks. The queue is intended for a single producer and
+ * a single consumer, but remains correct with more of either.
+ *
+ * A consumer may block in `wait_pop` until an element arrives or the queue is
+ * closed.
+ *
+ * @tparam T The element type. Must be default constructible and movable.
+ */
+template <typename T>
+class BoundedQueue {
+   public:
+    /**
+     * @brief Constructs a queue. The capacity is rounded up to a power of two
+     * (at least 2).
+     *
+     * @param capacity The maximum number of queued elements.
+     * @param policy The overflow policy used by `push`.
+     */
+    explicit BoundedQueue(size_t capacity, OverflowPolicy policy = OverflowPolicy::BLOCK);
+
+    BoundedQueue(const BoundedQueue &other) = delete;
+    BoundedQueue &operator=(const BoundedQueue &other) = delete;
+
+    /**
+     * @brief Attempts to enqueue `value` without applying the overflow
+     * policy.
+     *
+     * @return true if the value was enqueued, false if the queue was full.
+     */
+    bool try_push(T &&value);
+
+    /**
+     * @brief Enqueues `value`, applying the overflow policy if the queue is
+     * full, and wakes a waiting consumer.
+     *
+     * @return false if the value was dropped (`DROP_NEWEST`) or the queue is
+     * closed.
+     */
+    bool push(T value);
+
+    /**
+     * @brief Attempts to dequeue the oldest element into `value`.
+     *
+     * @return true if an element was dequeued.
+     */
+    bool try_pop(T &value);
+
+    /**
+     * @brief Dequeues the oldest element into `value`, blocking while the
+     * queue is empty.
+     *
+     * @return false once the queue is closed and empty.
+     */
+    bool wait_pop(T &value);
+
+    /**
+     * @brief Closes the queue. Further pushes fail, and consumers return from
+     * `wait_pop` once the remaining elements have been drained.
+     */
+    void close();
+
+    bool closed() const;
+    size_t capacity() const;
+
+    /**
+     * @brief Returns the number of elements discarded by the overflow policy.
+     */
+    uint64_t dropped() const;
+
+   private:
+    struct Cell {
+        std::atomic<size_t> seq;
+        T value;
+    };
+
+    static size_t round_up(size_t n);
+
+    const size_t mask_;
+    const OverflowPolicy policy_;
+    std::unique_ptr<Cell[]> cells_;
+
+    alignas(64) std::atomic<size_t> tail_;  ///< Next position to push
+    alignas(64) std::atomic<size_t> head_;  ///< Next position to pop
+    alignas(64) std::atomic<uint32_t> epoch_;  ///< Bumped on every push and on close
+    std::atomic<bool> closed_;
+    std::atomic<uint64_t> dropped_;
+};
+
+template <typename T>
+BoundedQueue<T>::BoundedQueue(size_t capacity, OverflowPolicy policy)
+    : mask_(round_up(capacity) - 1),
+      policy_(policy),
+      cells_(new Cell[mask_ + 1]),
+      tail_(0),
+      head_(0),
+      epoch_(0),
+      closed_(false),
+      dropped_(0) {
+    for (size_t i = 0; i <= mask_; i++) {
+        cells_[i].seq.store(i, std::memory_order_relaxed);
+    }
+}
+
+template <typename T>
+bool BoundedQueue<T>::try_push(T &&value) {
+    size_t pos = tail_.load(std::memory_order_relaxed);
+    while (true) {
+        Cell &cell = cells_[pos & mask_];
+        size_t seq = cell.seq.load(std::memory_order_acquire);
+        intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+        if (diff == 0) {
+            // The cell is free; claim it
+            if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                cell.value = std::move(value);
+                cell.seq.store(pos + 1, std::memory_order_release);
+                return true;
+            }
+        } else if (diff < 0) {
+            // The cell still holds an element from the previous lap
+            return false;
+        } else {
+            pos = tail_.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+template <typename T>
+bool BoundedQueue<T>::push(T value) {
+    if (closed()) {
+        return false;
+    }
+
+    T evicted;
+    if (policy_ == OverflowPolicy::KEEP_LATEST) {
+        while (try_pop(evicted)) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    while (!try_push(std::move(value))) {
+        switch (policy_) {
+            case OverflowPolicy::DROP_NEWEST:
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            case OverflowPolicy::DROP_OLDEST:
+            case OverflowPolicy::KEEP_LATEST:
+                if (try_pop(evicted)) {
+                    dropped_.fetch_add(1, std::memory_order_relaxed);
+                }
+                break;
+            case OverflowPolicy::BLOCK:
+            default:
+                if (closed()) {
+                    return false;
+                }
+                std::this_thread::yield();
+                break;
+        }
+    }
+
+    epoch_.fetch_add(1, std::memory_order_release);
+    epoch_.notify_all();
+    return true;
+}
+
+template <typename T>
+bool BoundedQueue<T>::try_pop(T &value) {
+    size_t pos = head_.load(std::memory_order_relaxed);
+    while (true) {
+        Cell &cell = cells_[pos & mask_];
+        size_t seq = cell.seq.load(std::memory_order_acquire);
+        intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+        if (diff == 0) {
+            // The cell is full; claim it
+            if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                value = std::move(cell.value);
+                cell.seq.store(pos + mask_ + 1, std::memory_order_release);
+                return true;
+            }
+        } else if (diff < 0) {
+            // Empty
+            return false;
+        } else {
+            pos = head_.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+template <typename T>
+bool BoundedQueue<T>::wait_pop(T &value) {
+    while (true) {
+        uint32_t epoch = epoch_.load(std::memory_order_acquire);
+        if (try_pop(value)) {
+            return true;
+        }
+        if (closed()) {
+            // A push may have completed just before the close
+            return try_pop(value);
+        }
+        epoch_.wait(epoch, std::memory_order_acquire);
+    }
+}
+
+template <typename T>
+void BoundedQueue<T>::close() {
+    closed_.store(true, std::memory_order_release);
+    epoch_.fetch_add(1, std::memory_order_release);
+    epoch_.notify_all();
+}
+
+template <typename T>
+bool BoundedQueue<T>::closed() const {
+    return closed_.load(std::memory_order_acquire);
+}
+
+template <typename T>
+size_t BoundedQueue<T>::capacity() const {
+    return mask_ + 1;
+}
+
+template <typename T>
+uint64_t BoundedQueue<T>::dropped() const {
+    return dropped_.load(std::memory_order_relaxed);
+}
+
+template <typename T>
+size_t BoundedQueue<T>::round_up(size_t n) {
+    size_t capacity = 2;  // A single cell cannot distinguish full from free
+    while (capacity < n) {
+        capacity <<= 1;
+    }
+    return capacity;
+}
+
+}  // namespace util
+}  // namespace rix
\ No newline at end of file
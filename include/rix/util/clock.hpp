@@ -0,0 +1,202 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include "rix/util/time.hpp"
+
+/**
+ * @brief The clock source `Time::now` starts with. One of SYSTEM,
+ * MONOTONIC, MONOTONIC_RAW, REALTIME_COARSE, TSC or SIMULATED. The source can
+ * also be changed at startup with `set_clock_source`.
+ */
+#ifndef RIX_UTIL_CLOCK_SOURCE
+#define RIX_UTIL_CLOCK_SOURCE SYSTEM
+#endif
+
+namespace rix {
+namespace util {
+
+/**
+ * @brief The clocks `Time::now` can read. Every source reports time since the
+ * Unix epoch, so Time values from different sources are comparable.
+ *
+ * @details
+ *     SYSTEM:          std::chrono::system_clock (CLOCK_REALTIME). Follows
+ *                      every adjustment of the system time, including steps.
+ *     MONOTONIC:       CLOCK_MONOTONIC anchored to the realtime clock. Never
+ *                      goes backwards; slewed by NTP.
+ *     MONOTONIC_RAW:   CLOCK_MONOTONIC_RAW anchored to the realtime clock.
+ *                      Never goes backwards. Between re-anchors it is not
+ *                      slewed, so it drifts at the rate of the local
+ *                      oscillator.
+ *     REALTIME_COARSE: CLOCK_REALTIME_COARSE. The cheapest read, with the
+ *                      resolution of the scheduler tick (typically 1-4 ms).
+ *     TSC:             The CPU timestamp counter (rdtsc on x86-64, cntvct_el0
+ *                      on AArch64), calibrated against CLOCK_MONOTONIC_RAW.
+ *                      Avoids the vDSO call entirely. Only available when the
+ *                      counter is invariant.
+ *     SIMULATED:       Time that only moves when `SimulatedClock` advances
+ *                      it. `sleep_for`, `sleep_until`, `Rate` and the IO wait
+ *                      timeouts all wait for simulated time, so replays and
+ *                      tests run as fast as they are driven and with
+ *                      repeatable timing.
+ *
+ * The anchored sources (MONOTONIC, MONOTONIC_RAW and TSC) are periodically
+ * re-anchored to the realtime clock, and never go backwards. Small errors are
+ * slewed out over the next interval. When the realtime clock is ahead by over
+ * a millisecond (the system time was stepped forward) they jump forward to
+ * it at once. When it is behind (stepped back), they instead run up to 500 ppm
+ * slow until it catches up, so after a large step back they keep reporting
+ * later times than SYSTEM for a long while. Waits for their deadlines use
+ * CLOCK_MONOTONIC, so they are not lengthened by the difference.
+ */
+enum class ClockSource { SYSTEM, MONOTONIC, MONOTONIC_RAW, REALTIME_COARSE, TSC, SIMULATED };
+
+/**
+ * @brief Selects the source read by `Time::now`. Intended to be called once at
+ * startup, but safe to call at any time. Selecting SIMULATED starts the
+ * simulated clock at the current time; selecting another source while it runs
+ * wakes every thread waiting on it.
+ *
+ * @param source The clock to read.
+ * @param reanchor_interval How often anchored sources are re-anchored to the
+ * realtime clock. Zero disables re-anchoring.
+ * @return false if the source is not available on this machine, in which case
+ * the current source is kept.
+ */
+bool set_clock_source(ClockSource source, const Duration &reanchor_interval = Duration(1.0));
+
+/**
+ * @brief Returns the source currently read by `Time::now`.
+ */
+ClockSource clock_source();
+
+/**
+ * @brief Returns `true` if the source can be used on this machine.
+ */
+bool clock_source_available(ClockSource source);
+
+/**
+ * @brief Returns the name of a source, e.g. "MONOTONIC_RAW".
+ */
+const char *clock_source_name(ClockSource source);
+
+/**
+ * @brief Drives the SIMULATED clock source.
+ *
+ * @details Simulated time starts when the source is selected and afterwards
+ * only moves forward, when the driver calls `set`, `advance` or `step`. A
+ * driver thread can advance it in proportion to real time (e.g. to replay at
+ * 10x), or advance it event by event: `step` jumps straight to the earliest
+ * deadline any thread is waiting for, and `waiting` tells the driver how many
+ * threads have reached a wait.
+ */
+class SimulatedClock {
+   public:
+    /**
+     * @brief Selects the SIMULATED source, starting at `time`.
+     */
+    static void start(const Time &time);
+
+    /**
+     * @brief Returns to the source that was selected before the simulation
+     * started and wakes every waiting thread.
+     */
+    static void stop();
+
+    /**
+     * @brief Returns `true` while SIMULATED is the selected source.
+     */
+    static bool running();
+
+    /**
+     * @brief Moves simulated time to `time`. Ignored if `time` is in the
+     * simulated past.
+     */
+    static void set(const Time &time);
+
+    /**
+     * @brief Moves simulated time forward by `duration`.
+     */
+    static void advance(const Duration &duration);
+
+    /**
+     * @brief Moves simulated time to the earliest deadline a thread is waiting
+     * for, waking that thread.
+     *
+     * @return false if no thread is waiting.
+     */
+    static bool step();
+
+    /**
+     * @brief Returns the number of threads waiting for simulated time.
+     */
+    static size_t waiting();
+
+    /**
+     * @brief Blocks until simulated time reaches `deadline` or the simulation
+     * stops.
+     *
+     * @return false, without waiting, if the simulation is not running.
+     */
+    static bool wait_until(const Time &deadline);
+
+    /**
+     * @brief A simulated deadline for a thread blocked in `poll`: while the
+     * alarm exists, `fd` becomes readable once simulated time reaches the
+     * deadline or the simulation stops.
+     */
+    class Alarm {
+       public:
+        explicit Alarm(const Time &deadline);
+        ~Alarm();
+
+        Alarm(const Alarm &) = delete;
+        Alarm &operator=(const Alarm &) = delete;
+
+        /**
+         * @brief Returns the descriptor to poll for POLLIN, or -1 if the
+         * simulation is not running.
+         */
+        int fd() const;
+
+       private:
+        int64_t deadline_;
+        int fd_;
+    };
+};
+
+namespace detail {
+
+/**
+ * @brief Reads the current clock source, in nanoseconds since the epoch.
+ */
+int64_t clock_now_ns();
+
+/**
+ * @brief Returns `true` if the current source reads CLOCK_REALTIME directly
+ * (SYSTEM and REALTIME_COARSE), so its deadlines can be waited for on
+ * `Clock`. The anchored sources can run ahead of the realtime clock after the
+ * system time steps back, so their deadlines are waited for with
+ * `steady_deadline` instead.
+ */
+bool clock_is_realtime();
+
+/**
+ * @brief Converts a deadline on the current source to a steady_clock
+ * (CLOCK_MONOTONIC) deadline the same distance away.
+ */
+std::chrono::steady_clock::time_point steady_deadline(const Time &deadline);
+
+/**
+ * @brief Shifts the realtime clock as seen by the anchored sources when they
+ * re-anchor, as if the system time had been stepped by `offset`. For tests.
+ */
+void offset_realtime(const Duration &offset);
+
+}  // namespace detail
+
+}  // namespace util
+}  // namespace rix
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include "rix/util/time.hpp"
+
+namespace rix {
+namespace util {
+
+/**
+ * @brief A lock-free, fixed-size histogram of non-negative integer values
+ * (typically latencies in nanoseconds).
+ *
+ * @details Values are binned log-linearly in the style of HdrHistogram: each
+ * power of two is split into `2^SUB_BUCKET_BITS` equal sub-buckets, so every
+ * recorded value is resolved to within about 3% over the full 64-bit range
+ * without any allocation. Recording is a handful of relaxed atomic
+ * operations and may be called concurrently from any number of threads.
+ * Queries may run concurrently with recording and see a consistent-enough
+ * snapshot for monitoring.
+ */
+class Histogram {
+   public:
+    static constexpr int SUB_BUCKET_BITS = 5;
+    static constexpr size_t SUB_BUCKETS = size_t(1) << SUB_BUCKET_BITS;
+    static constexpr size_t BUCKETS = (64 - SUB_BUCKET_BITS) * SUB_BUCKETS;
+
+    Histogram();
+
+    Histogram(const Histogram &other) = delete;
+    Histogram &operator=(const Histogram &other) = delete;
+
+    /**
+     * @brief Records a value. Negative values are counted as zero.
+     */
+    void record(int64_t value);
+
+    /**
+     * @brief Records a duration in nanoseconds.
+     */
+    void record(const Duration &duration);
+
+    /**
+     * @brief Returns the number of recorded values.
+     */
+    uint64_t count() const;
+
+    /**
+     * @brief Returns the smallest recorded value, or 0 if empty.
+     */
+    int64_t min() const;
+
+    /**
+     * @brief Returns the largest recorded value, or 0 if empty.
+     */
+    int64_t max() const;
+
+    /**
+     * @brief Returns the exact mean of the recorded values, or 0 if empty.
+     */
+    double mean() const;
+
+    /**
+     * @brief Returns the value at the given percentile (0 to 100). The result
+     * is the midpoint of the bin containing the percentile, clamped to the
+     * recorded min and max. The 100th percentile is exactly the max.
+     */
+    int64_t percentile(double p) const;
+
+    /**
+     * @brief Discards all recorded values. Not atomic with respect to
+     * concurrent recording.
+     */
+    void reset();
+
+    /**
+     * @brief Returns a one-line summary (count, min, mean, p50, p99, p99.9,
+     * max) with values formatted as durations.
+     */
+    std::string summary() const;
+
+   private:
+    static size_t index(uint64_t value);
+    static uint64_t lowest(size_t index);
+    static uint64_t highest(size_t index);
+
+    std::array<std::atomic<uint64_t>, BUCKETS> counts_;
+    std::atomic<uint64_t> count_;
+    std::atomic<uint64_t> sum_;
+    std::atomic<int64_t> min_;
+    std::atomic<int64_t> max_;
+};
+
+}  // namespace util
+}  // namespace rix
\ No newline at end of file
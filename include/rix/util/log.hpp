@@ -9,15 +9,23 @@
 #include <sys/types.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <map>
+#include <memory>
 #include <sstream>
 #include <string>
 #include <mutex>
+#include <vector>
 
+#include "rix/util/async_log.hpp"
+#include "rix/util/rotating_file.hpp"
 #include "rix/util/time.hpp"
+#include "rix/util/timestamp.hpp"
 
 namespace rix {
 namespace util {
@@ -35,6 +43,7 @@ class TeeBuffer : public std::streambuf {
     TeeBuffer(std::vector<std::streambuf *> targets);
 
     int overflow(int c) override;
+    std::streamsize xsputn(const char *s, std::streamsize n) override;
     int sync() override;
     void add(std::streambuf *target);
 
@@ -53,6 +62,14 @@ inline int TeeBuffer::overflow(int c) {
     }
     return 0;
 }
+inline std::streamsize TeeBuffer::xsputn(const char *s, std::streamsize n) {
+    for (auto target : targets_) {
+        if (target->sputn(s, n) != n) {
+            return 0;
+        }
+    }
+    return n;
+}
 inline int TeeBuffer::sync() {
     int result = 0;
     for (auto target : targets_) {
@@ -81,16 +98,65 @@ class TeeStream : public std::ostream {
 inline TeeStream::TeeStream(const TeeBuffer &tee_buffer) : std::ostream(&tee_buffer_), tee_buffer_(tee_buffer) {}
 
 /**
- * @brief NullBuffer class. This is used as a fake stream that writes
- * no data to stdout/stderr without accumulating data in a stream.
+ * @brief RecordBuffer class. A growable stream buffer that a log record is
+ * formatted into before it is written out in one piece. Flushes (e.g. from
+ * `std::endl`) are recorded rather than forwarded so that they can be applied
+ * after the record has been committed.
  *
  */
-class NullBuffer : public std::streambuf {
+class RecordBuffer : public std::streambuf {
    public:
+    RecordBuffer();
+
+    void clear();
+    const char *data() const;
+    size_t size() const;
+    bool flush_requested() const;
+
+   protected:
     int overflow(int c) override;
+    int sync() override;
+
+   private:
+    std::string storage_;
+    bool flush_requested_;
 };
 
-inline int NullBuffer::overflow(int c) { return c; }
+inline RecordBuffer::RecordBuffer() : storage_(256, '\0'), flush_requested_(false) { clear(); }
+inline void RecordBuffer::clear() {
+    setp(storage_.data(), storage_.data() + storage_.size());
+    flush_requested_ = false;
+}
+inline const char *RecordBuffer::data() const { return pbase(); }
+inline size_t RecordBuffer::size() const { return pptr() - pbase(); }
+inline bool RecordBuffer::flush_requested() const { return flush_requested_; }
+inline int RecordBuffer::overflow(int c) {
+    size_t used = size();
+    storage_.resize(storage_.size() * 2);
+    setp(storage_.data(), storage_.data() + storage_.size());
+    pbump(static_cast<int>(used));
+    if (c != EOF) {
+        *pptr() = static_cast<char>(c);
+        pbump(1);
+        return c;
+    }
+    return 0;
+}
+inline int RecordBuffer::sync() {
+    flush_requested_ = true;
+    return 0;
+}
+
+/**
+ * @brief RecordBuilder struct. A RecordBuffer and the stream that formats into
+ * it. Each thread owns one, so building a record never takes a lock.
+ *
+ */
+struct RecordBuilder {
+    RecordBuffer buffer;
+    std::ostream stream{&buffer};
+    bool in_use = false;
+};
 
 }  // namespace detail
 
@@ -109,16 +175,84 @@ class Log {
     enum Level { DEBUG, INFO, WARN, ERROR, FATAL };
 
    private:
+    inline static RotatingFile log_file{};
+    inline static detail::TeeBuffer tee_buffer{std::vector<std::streambuf *>{std::cout.rdbuf()}};
+    inline static std::mutex mutex{};
+
     /**
-     * @brief static declaration of NullBuffer used by LogStream objects to
-     * "write" to when the RIX_UTIL_LOG_LEVEL < level.
+     * @brief Background writer used in asynchronous mode. Declared after the
+     * buffers it writes to so that it is destroyed (and drained) first.
      *
      */
-    inline static detail::NullBuffer null_buffer{};
-    inline static std::ofstream logFile{};
-    inline static detail::TeeBuffer tee_buffer{std::vector<std::streambuf *>{std::cout.rdbuf()}};
-    inline static std::mutex mutex{};
+    inline static detail::AsyncLogWriter async_writer{};
 
+    template <Level level>
+    class LogStream;
+
+   public:
+    /**
+     * @brief Record class. Returned by `LogStream::operator<<`, it collects the
+     * header and every value streamed in the same statement into the calling
+     * thread's RecordBuilder. When the statement ends the record is destroyed
+     * and the whole line is committed with a single write, so lines from
+     * different threads never interleave.
+     *
+     */
+    class Record {
+       public:
+        ~Record();
+        Record(Record &&other) noexcept;
+        Record(const Record &) = delete;
+        Record &operator=(const Record &) = delete;
+        Record &operator=(Record &&) = delete;
+
+        template <typename T>
+        Record &operator<<(const T &val);
+        Record &operator<<(std::ostream &(*manip)(std::ostream &));
+        Record &operator<<(std::ios_base &(*manip)(std::ios_base &));
+
+       private:
+        friend class Log;
+        template <Level>
+        friend class LogStream;
+
+        /**
+         * @brief Constructs a record. A disabled record discards everything
+         * streamed into it.
+         */
+        explicit Record(bool enabled);
+
+        detail::RecordBuilder *builder_;
+        std::unique_ptr<detail::RecordBuilder> owned_;  ///< Used when a record is built while another is in progress
+    };
+
+    /**
+     * @brief Module class. A named group of log statements whose level can be
+     * changed at runtime with `set_level`. Checking whether a level is enabled
+     * costs one relaxed atomic load. Levels below RIX_UTIL_LOG_LEVEL are
+     * compiled out and cannot be enabled at runtime.
+     *
+     */
+    class Module {
+       public:
+        explicit Module(const std::string &name);
+        ~Module();
+        Module(const Module &) = delete;
+        Module &operator=(const Module &) = delete;
+
+        bool enabled(Level level) const { return level >= level_.load(std::memory_order_relaxed); }
+        Level level() const { return static_cast<Level>(level_.load(std::memory_order_relaxed)); }
+        const std::string &name() const { return name_; }
+
+       private:
+        friend class Log;
+
+        const std::string name_;
+        std::atomic<int> level_;
+        bool overridden_;  ///< Guarded by the registry mutex
+    };
+
+   private:
     /**
      * @brief LogStream class. This class has a << operator that will append
      * header information to the data that is input to the stream. The level
@@ -132,18 +266,69 @@ class Log {
     class LogStream {
        public:
         template <typename T>
-        std::ostream &operator<<(const T &val);
-
-        inline static std::ostream null_stream{&Log::null_buffer};
-        inline static std::ostream tee_stream{&Log::tee_buffer};
-        inline static std::mutex &mutex{Log::mutex};
+        Record operator<<(const T &val);
 
-        inline static std::string create_header(const Time &t);
+        inline static void write_header(std::ostream &os, const Time &t);
         inline static std::string create_plain_header(const Time &t);
     };
 
    public:
-    inline static void init(const std::string &name, bool logToFile = false);
+    /**
+     * @brief Initializes the logger.
+     *
+     * @param name The name printed in each header and used for the log file.
+     * @param logToFile If true, also write to ~/.rix/log/<name>_<ns>_<seq>.log,
+     * rotating to a new file as set by `file_options`.
+     * @param async If true, log calls only format the line and copy it into a
+     * per-thread ring; a background thread writes lines out in batches.
+     * @param file_options Rotation, retention and durability of the log files.
+     */
+    inline static void init(const std::string &name, bool logToFile = false, bool async = false,
+                            const RotatingFile::Options &file_options = RotatingFile::Options());
+
+    /**
+     * @brief Writes out all queued lines and waits for the log file, if any,
+     * to reach the disk.
+     *
+     */
+    inline static void flush();
+
+    /**
+     * @brief Sets the runtime level of every module without an override,
+     * including the default module used by `Log::info` and friends.
+     *
+     */
+    inline static void set_level(Level level);
+
+    /**
+     * @brief Overrides the runtime level of the named module. The override
+     * also applies to modules with that name registered later.
+     *
+     */
+    inline static void set_level(const std::string &module, Level level);
+
+    /**
+     * @brief Removes the override for the named module, returning it to the
+     * level set by `set_level(Level)`.
+     *
+     */
+    inline static void clear_level(const std::string &module);
+
+    /**
+     * @brief Starts a record at the given level. Used by the RIX_LOG macros,
+     * which check the level before calling it so that disabled statements
+     * never evaluate their arguments.
+     *
+     */
+    template <Level level>
+    inline static Record record();
+
+    /**
+     * @brief The module used by `Log::info` and friends, and by the RIX_LOG
+     * macros unless RIX_LOG_MODULE names another one.
+     *
+     */
+    inline static Module default_module{"default"};
 
     /**
      * The public LogStream objects. These are used to log inforamtion at the
@@ -162,41 +347,64 @@ class Log {
     inline static const std::string bold = "\x1b[1m";
     inline static const std::string unbold = "\x1b[22m";
     inline static std::string name;
+    inline static std::string name_field;
     inline static bool is_init{false};
 
     inline static std::string get_color_code(Level level);
     inline static std::string get_level_string(Level level);
+    inline static void commit(const detail::RecordBuffer &buffer);
+
+    struct Registry {
+        std::mutex mutex;
+        std::vector<Module *> modules;
+        std::map<std::string, Level> overrides;
+        Level level = static_cast<Level>(RIX_UTIL_LOG_LEVEL);
+    };
+    inline static Registry &registry();
 };
 
 template <Log::Level level>
 template <typename T>
-inline std::ostream &Log::LogStream<level>::operator<<(const T &val) {
-    if (level < RIX_UTIL_LOG_LEVEL) {
-        return null_stream;
+inline Log::Record Log::LogStream<level>::operator<<(const T &val) {
+    if (level < RIX_UTIL_LOG_LEVEL || !default_module.enabled(level)) {
+        return Record(false);
     }
 
-    std::lock_guard<std::mutex> guard(mutex);
-    std::string header = create_header(Time::now());
-    return tee_stream << header << val;
+    Record record = Log::record<level>();
+    record << val;
+    return record;
 }
 
 template <Log::Level level>
-inline std::string Log::LogStream<level>::create_header(const Time &t) {
-    std::stringstream ss;
+inline Log::Record Log::record() {
+    Record record(true);
+    LogStream<level>::write_header(record.builder_->stream, Time::now());
+    return record;
+}
+
+template <Log::Level level>
+inline void Log::LogStream<level>::write_header(std::ostream &os, const Time &t) {
+    // The level field never changes, so it is rendered and padded once
+    static const std::string level_field = [] {
+        std::string level_str = "[" + bold + get_color_code(level) + get_level_string(level) + reset_color + "] ";
+        level_str.resize(std::max<size_t>(level_str.size(), 21), ' ');
+        return level_str;
+    }();
 
     // Date field
-    ss << "[" << t.to_string() << "] ";
+    char stamp[TimestampFormatter::MAX_SIZE];
+    size_t len = TimestampFormatter::utc().format(t, stamp);
+    os.put('[');
+    os.write(stamp, len);
+    os.write("] ", 2);
 
     // Level field
-    std::string level_str = "[" + bold + get_color_code(level) + get_level_string(level) + reset_color + "] ";
-    ss << std::setw(21) << std::left << level_str;
+    os.write(level_field.data(), level_field.size());
 
     // Name field
     if (is_init) {
-        ss << "[" << bold << name << unbold << "] ";
+        os.write(name_field.data(), name_field.size());
     }
-
-    return ss.str();
 }
 
 template <Log::Level level>
@@ -218,11 +426,13 @@ inline std::string Log::LogStream<level>::create_plain_header(const Time &t) {
     return ss.str();
 }
 
-inline void Log::init(const std::string &name, bool logToFile) {
+inline void Log::init(const std::string &name, bool logToFile, bool async,
+                      const RotatingFile::Options &file_options) {
     if (is_init) {
         return;
     }
     Log::name = name;
+    Log::name_field = "[" + bold + name + unbold + "] ";
     if (logToFile) {
         const char *homeDir;
         if ((homeDir = getenv("HOME")) == NULL) {
@@ -230,20 +440,153 @@ inline void Log::init(const std::string &name, bool logToFile) {
         }
         std::string dirName = std::string(homeDir) + "/.rix/log/";
         struct stat st;
-        if (stat(dirName.c_str(), &st) < 0) {
-            if (mkdir(dirName.c_str(), S_IRWXU) < 0) {
-                std::string err = strerror(errno);
-                logToFile = false;
-                is_init = true;
-                return;
-            }
+        if (stat(dirName.c_str(), &st) < 0 && mkdir(dirName.c_str(), S_IRWXU) < 0) {
+            logToFile = false;
+        }
+        if (logToFile && log_file.open(dirName, name, file_options)) {
+            tee_buffer.add(&log_file);
         }
-        logFile.open(dirName + name + "_" + std::to_string(Time::now().to_nanoseconds()) + ".log");
-        tee_buffer.add(logFile.rdbuf());
+    }
+    if (async) {
+        async_writer.start(&tee_buffer);
     }
     is_init = true;
 }
 
+inline void Log::flush() {
+    if (async_writer.running()) {
+        async_writer.flush();
+    } else {
+        std::lock_guard<std::mutex> guard(mutex);
+        tee_buffer.pubsync();
+    }
+    if (log_file.is_open()) {
+        log_file.flush();
+    }
+}
+
+inline Log::Registry &Log::registry() {
+    static Registry registry;
+    return registry;
+}
+
+inline Log::Module::Module(const std::string &name) : name_(name), level_(RIX_UTIL_LOG_LEVEL), overridden_(false) {
+    Registry &r = registry();
+    std::lock_guard<std::mutex> guard(r.mutex);
+    auto it = r.overrides.find(name_);
+    overridden_ = it != r.overrides.end();
+    level_ = overridden_ ? it->second : r.level;
+    r.modules.push_back(this);
+}
+
+inline Log::Module::~Module() {
+    Registry &r = registry();
+    std::lock_guard<std::mutex> guard(r.mutex);
+    std::erase(r.modules, this);
+}
+
+inline void Log::set_level(Level level) {
+    Registry &r = registry();
+    std::lock_guard<std::mutex> guard(r.mutex);
+    r.level = level;
+    for (Module *module : r.modules) {
+        if (!module->overridden_) {
+            module->level_.store(level, std::memory_order_relaxed);
+        }
+    }
+}
+
+inline void Log::set_level(const std::string &name, Level level) {
+    Registry &r = registry();
+    std::lock_guard<std::mutex> guard(r.mutex);
+    r.overrides[name] = level;
+    for (Module *module : r.modules) {
+        if (module->name_ == name) {
+            module->overridden_ = true;
+            module->level_.store(level, std::memory_order_relaxed);
+        }
+    }
+}
+
+inline void Log::clear_level(const std::string &name) {
+    Registry &r = registry();
+    std::lock_guard<std::mutex> guard(r.mutex);
+    r.overrides.erase(name);
+    for (Module *module : r.modules) {
+        if (module->name_ == name) {
+            module->overridden_ = false;
+            module->level_.store(r.level, std::memory_order_relaxed);
+        }
+    }
+}
+
+inline void Log::commit(const detail::RecordBuffer &buffer) {
+    if (buffer.size() == 0) {
+        return;
+    }
+    if (async_writer.running()) {
+        async_writer.ring().push(buffer.data(), buffer.size());
+        return;
+    }
+    std::lock_guard<std::mutex> guard(mutex);
+    tee_buffer.sputn(buffer.data(), buffer.size());
+    if (buffer.flush_requested()) {
+        tee_buffer.pubsync();
+    }
+}
+
+inline Log::Record::Record(bool enabled) : builder_(nullptr) {
+    if (!enabled) {
+        return;
+    }
+    thread_local detail::RecordBuilder builder;
+    if (builder.in_use) {
+        owned_ = std::make_unique<detail::RecordBuilder>();
+        builder_ = owned_.get();
+    } else {
+        builder_ = &builder;
+    }
+    builder_->in_use = true;
+    builder_->buffer.clear();
+    builder_->stream.clear();
+    builder_->stream.flags(std::ios_base::dec | std::ios_base::skipws);
+    builder_->stream.precision(6);
+    builder_->stream.fill(' ');
+}
+
+inline Log::Record::Record(Record &&other) noexcept : builder_(other.builder_), owned_(std::move(other.owned_)) {
+    other.builder_ = nullptr;
+}
+
+inline Log::Record::~Record() {
+    if (builder_) {
+        commit(builder_->buffer);
+        builder_->in_use = false;
+    }
+}
+
+template <typename T>
+inline Log::Record &Log::Record::operator<<(const T &val) {
+    if (builder_) {
+        builder_->stream << val;
+    }
+    return *this;
+}
+
+inline Log::Record &Log::Record::operator<<(std::ostream &(*manip)(std::ostream &)) {
+    if (builder_) {
+        builder_->stream << manip;
+    }
+    return *this;
+}
+
+inline Log::Record &Log::Record::operator<<(std::ios_base &(*manip)(std::ios_base &)) {
+    if (builder_) {
+        builder_->stream << manip;
+    }
+    return *this;
+}
+
 inline std::string Log::get_color_code(Level level) {
     switch (level) {
         case Level::DEBUG:
@@ -279,4 +622,37 @@ inline std::string Log::get_level_string(Level level) {
 }
 
 }  // namespace util
-}  // namespace rix
\ No newline at end of file
+}  // namespace rix
+
+/**
+ * @brief The module checked by the RIX_LOG_<LEVEL> macros. To give a file its
+ * own runtime level, define a module and point this macro at it:
+ *
+ *     RIX_LOG_DEFINE_MODULE(mbot_log, "mbot");
+ *     #undef RIX_LOG_MODULE
+ *     #define RIX_LOG_MODULE mbot_log
+ */
+#ifndef RIX_LOG_MODULE
+#define RIX_LOG_MODULE ::rix::util::Log::default_module
+#endif
+
+#define RIX_LOG_DEFINE_MODULE(var, name) static ::rix::util::Log::Module var { name }
+
+/**
+ * @brief Logs a record if `level` is enabled in `module`. Statements below
+ * RIX_UTIL_LOG_LEVEL generate no code, and the streamed values are only
+ * evaluated when the record is emitted:
+ *
+ *     RIX_LOG_DEBUG << "state: " << expensive_dump() << std::endl;
+ */
+#define RIX_LOG(level, module)                   \
+    if constexpr ((level) < RIX_UTIL_LOG_LEVEL) { \
+    } else if (!(module).enabled(level)) {       \
+    } else                                       \
+        ::rix::util::Log::record<level>()
+
+#define RIX_LOG_DEBUG RIX_LOG(::rix::util::Log::Level::DEBUG, RIX_LOG_MODULE)
+#define RIX_LOG_INFO RIX_LOG(::rix::util::Log::Level::INFO, RIX_LOG_MODULE)
+#define RIX_LOG_WARN RIX_LOG(::rix::util::Log::Level::WARN, RIX_LOG_MODULE)
+#define RIX_LOG_ERROR RIX_LOG(::rix::util::Log::Level::ERROR, RIX_LOG_MODULE)
+#define RIX_LOG_FATAL RIX_LOG(::rix::util::Log::Level::FATAL, RIX_LOG_MODULE)
\ No newline at end of file
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "rix/util/histogram.hpp"
+#include "rix/util/time.hpp"
+
+/**
+ * @brief Set to 0 to compile every RIX_PROFILE_SCOPE out.
+ */
+#ifndef RIX_UTIL_PROFILE
+#define RIX_UTIL_PROFILE 1
+#endif
+
+#define RIX_PROFILE_CONCAT_(a, b) a##b
+#define RIX_PROFILE_CONCAT(a, b) RIX_PROFILE_CONCAT_(a, b)
+
+/**
+ * @brief Records the time until the end of the enclosing scope in the probe
+ * `name`, e.g. `RIX_PROFILE_SCOPE("mbot.drive");`.
+ *
+ * @details The probe is looked up once per call site; after that a
+ * measurement costs two reads of `Time::now` and a lock-free
+ * `Histogram::record`.
+ */
+#if RIX_UTIL_PROFILE
+#define RIX_PROFILE_SCOPE(name)                                                                  \
+    static ::rix::util::Histogram &RIX_PROFILE_CONCAT(rix_probe_histogram_, __LINE__) =          \
+        ::rix::util::Profiler::probe(name);                                                      \
+    ::rix::util::ScopedProbe RIX_PROFILE_CONCAT(rix_probe_, __LINE__)(                           \
+        RIX_PROFILE_CONCAT(rix_probe_histogram_, __LINE__))
+#else
+#define RIX_PROFILE_SCOPE(name) \
+    do {                        \
+    } while (0)
+#endif
+
+namespace rix {
+namespace util {
+
+/**
+ * @brief A registry of named latency histograms ("probes").
+ *
+ * @details Probes are created on first use and live until the program exits,
+ * so the references returned by `probe` stay valid and may be cached.
+ */
+class Profiler {
+   public:
+    /**
+     * @brief Returns the histogram of the probe `name`, creating it if needed.
+     */
+    static Histogram &probe(const std::string &name);
+
+    /**
+     * @brief Returns the names of all probes, sorted.
+     */
+    static std::vector<std::string> names();
+
+    /**
+     * @brief Writes one summary line per probe that has recorded values,
+     * sorted by name.
+     */
+    static void dump(std::ostream &os);
+
+    /**
+     * @brief Dumps every probe to stderr when the program exits.
+     */
+    static void dump_at_exit();
+
+    /**
+     * @brief Discards the values recorded by every probe.
+     */
+    static void reset();
+
+   private:
+    struct Entry {
+        std::string name;
+        std::unique_ptr<Histogram> histogram;
+    };
+
+    static std::mutex mutex_;
+    static std::vector<Entry> probes_;
+};
+
+/**
+ * @brief Records the lifetime of the object in a histogram.
+ */
+class ScopedProbe {
+   public:
+    explicit ScopedProbe(Histogram &histogram) : timer_(histogram) { timer_.start(); }
+    ~ScopedProbe() { timer_.stop(); }
+
+    ScopedProbe(const ScopedProbe &) = delete;
+    ScopedProbe &operator=(const ScopedProbe &) = delete;
+
+   private:
+    Timer timer_;
+};
+
+}  // namespace util
+}  // namespace rix
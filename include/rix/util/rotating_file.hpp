@@ -0,0 +1,138 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <streambuf>
+#include <string>
+#include <thread>
+
+#include "rix/util/time.hpp"
+
+namespace rix {
+namespace util {
+
+/**
+ * @brief A stream buffer that writes to a series of size- and age-capped
+ * files, `<directory>/<name>_<ns>_<seq>.log`, where `ns` is the realtime
+ * clock when the file was opened and `seq` counts the files this instance
+ * has opened.
+ *
+ * @details Writers only append to an in-memory batch under a mutex. A
+ * background thread writes each batch to disk with one `write`, rotates to a
+ * new file when the current one would exceed `max_bytes` or is older than
+ * `max_age`, deletes the oldest files beyond `max_files`, and calls
+ * `fdatasync` according to the durability policy. Each batch goes to a single
+ * file, so a record committed with one `sputn` is never split across files.
+ * If the disk falls behind by more than `max_pending` bytes, new data is
+ * dropped and counted instead of blocking the caller.
+ */
+class RotatingFile : public std::streambuf {
+   public:
+    struct Options {
+        size_t max_bytes = 16 << 20;               ///< Rotate before a file exceeds this size (0 = never)
+        Duration max_age = Duration(0.0);          ///< Rotate files older than this (0 = never)
+        size_t max_files = 8;                      ///< Files kept, including the current one (0 = all)
+        bool preallocate = true;                   ///< Reserve `max_bytes` with fallocate when a file is opened
+        Duration sync_interval = Duration(1.0);    ///< fdatasync unsynced data at least this often (0 = never)
+        size_t sync_bytes = 1 << 20;               ///< fdatasync after this many unsynced bytes (0 = never)
+        Duration write_interval = Duration(0.01);  ///< How often the background thread writes batches
+        size_t max_pending = 4 << 20;              ///< Bytes buffered in memory before new data is dropped
+    };
+
+    RotatingFile();
+
+    /**
+     * @brief Writes out all buffered data and closes the current file.
+     */
+    ~RotatingFile();
+
+    RotatingFile(const RotatingFile &) = delete;
+    RotatingFile &operator=(const RotatingFile &) = delete;
+
+    /**
+     * @brief Opens the first file and starts the background thread. Creates
+     * `directory` if it does not exist.
+     *
+     * @return true on success.
+     */
+    bool open(const std::string &directory, const std::string &name, const Options &options);
+    bool open(const std::string &directory, const std::string &name);
+
+    /**
+     * @brief Writes out all buffered data, syncs and closes the current file
+     * and stops the background thread.
+     */
+    void close();
+
+    bool is_open() const;
+
+    /**
+     * @brief Writes out all buffered data and waits for it to reach the disk.
+     *
+     * @return true if every write and sync succeeded.
+     */
+    bool flush();
+
+    /**
+     * @brief Returns the path of the file currently written to.
+     */
+    std::string path() const;
+
+    uint64_t bytes_written() const;
+    uint64_t rotations() const;
+    uint64_t syncs() const;
+    uint64_t dropped() const;
+
+   protected:
+    int overflow(int c) override;
+    std::streamsize xsputn(const char *s, std::streamsize n) override;
+
+    /**
+     * @brief Wakes the background thread. Does not wait for the disk; use
+     * `flush` for that.
+     */
+    int sync() override;
+
+   private:
+    void run();
+
+    /**
+     * @brief Writes `batch_` to disk, rotating and syncing as needed. Only
+     * called with `io_mtx_` held.
+     */
+    bool write_batch();
+    bool open_file();
+    void close_file();
+    void remove_old_files();
+
+    Options options_;
+    std::string directory_;
+    std::string name_;
+
+    mutable std::mutex mtx_;  ///< Guards `pending_`, `stop_` and `path_`
+    std::condition_variable cv_;
+    std::string pending_;
+    bool stop_;
+    bool wake_;
+    std::string path_;
+
+    std::mutex io_mtx_;  ///< Serializes disk I/O between the background thread and `flush`
+    std::string batch_;
+    int fd_;
+    uint64_t sequence_;  ///< Appended to file names so that none is ever reused
+    size_t file_bytes_;
+    Time file_opened_;
+    size_t unsynced_bytes_;
+    Time last_sync_;
+
+    std::atomic<uint64_t> bytes_written_;
+    std::atomic<uint64_t> rotations_;
+    std::atomic<uint64_t> syncs_;
+    std::atomic<uint64_t> dropped_;
+    std::thread thr_;
+};
+
+}  // namespace util
+}  // namespace rix
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "rix/util/time.hpp"
+
+namespace rix {
+namespace util {
+
+/**
+ * @brief Runs periodic jobs on a single background thread.
+ *
+ * @details Jobs are kept in a heap ordered by their next deadline. The worker
+ * thread waits on a condition variable until the earliest deadline, so adding
+ * or cancelling a job and stopping the scheduler take effect immediately
+ * rather than after the current period elapses. Deadlines advance by whole
+ * periods; if a job overruns, the missed periods are skipped.
+ *
+ * While a `SimulatedClock` is running, deadlines are simulated times: the
+ * worker waits on a `SimulatedClock::Alarm` and an eventfd that add, cancel
+ * and stop signal, instead of on the condition variable.
+ */
+class Scheduler {
+   public:
+    using JobId = uint64_t;
+
+    /**
+     * @brief Constructs a Scheduler and starts its worker thread.
+     */
+    Scheduler();
+
+    /**
+     * @brief Stops the worker thread. Blocks only while a job is running.
+     */
+    ~Scheduler();
+
+    Scheduler(const Scheduler &other) = delete;
+    Scheduler &operator=(const Scheduler &other) = delete;
+
+    /**
+     * @brief Adds a periodic job.
+     *
+     * @param period The period of the job.
+     * @param job The function to call every period.
+     * @param delay The delay before the first call.
+     * @return JobId The identifier used to cancel the job.
+     */
+    JobId add(const Duration &period, std::function<void()> job, const Duration &delay = Duration(0.0));
+
+    /**
+     * @brief Cancels a job. The job will not be called again, but a call
+     * already in progress on the worker thread is not interrupted. Jobs may
+     * cancel themselves.
+     *
+     * @return true if the job existed.
+     */
+    bool cancel(JobId id);
+
+    /**
+     * @brief Cancels every job and joins the worker thread.
+     */
+    void stop();
+
+    /**
+     * @brief Returns the number of scheduled jobs.
+     */
+    size_t size() const;
+
+   private:
+    struct Job {
+        Duration period;
+        std::function<void()> fn;
+    };
+
+    struct Deadline {
+        Time time;
+        JobId id;
+        bool operator>(const Deadline &other) const { return time > other.time; }
+    };
+
+    void run();
+
+    /**
+     * @brief Waits until simulated time reaches `deadline` or the worker is
+     * woken. Called with `lock` held, which is released while waiting.
+     *
+     * @return false if the simulation is not running.
+     */
+    bool wait_simulated(std::unique_lock<std::mutex> &lock, const Time &deadline);
+
+    /**
+     * @brief Wakes the worker whichever way it is waiting. Called with `mtx_`
+     * held.
+     */
+    void wake();
+
+    mutable std::mutex mtx_;
+    std::condition_variable cv_;
+    std::priority_queue<Deadline, std::vector<Deadline>, std::greater<Deadline>> deadlines_;
+    std::unordered_map<JobId, Job> jobs_;
+    JobId next_id_;
+    bool stop_;
+    int wake_fd_;  ///< eventfd signalled by `wake` for a worker waiting on simulated time
+    std::thread thr_;
+};
+
+}  // namespace util
+}  // namespace rix
\ No newline at end of file
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace rix {
+namespace util {
+
+/**
+ * @brief A fixed set of worker threads with work stealing.
+ *
+ * @details Every worker has its own task queue. Tasks submitted from outside
+ * the pool are dealt to the workers in turn, and tasks submitted by a worker
+ * go to its own queue. A worker takes the oldest task of its own queue and,
+ * once that is empty, steals the newest task of another worker's queue, so
+ * uneven tasks keep every worker busy without a single shared queue.
+ *
+ * Submitting, taking and finishing a task only lock the queue involved and
+ * update atomic counts. The pool-wide mutex is only taken to park a worker
+ * that found nothing to do, to wake parked workers, and to wait for the pool
+ * to go idle.
+ */
+class ThreadPool {
+   public:
+    /**
+     * @brief Starts `threads` workers (at least one).
+     */
+    explicit ThreadPool(size_t threads);
+
+    /**
+     * @brief Runs every task already submitted, then joins the workers.
+     */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    /**
+     * @brief Queues a task to run on a worker.
+     */
+    void submit(std::function<void()> task);
+
+    /**
+     * @brief Calls `fn(i)` for every i in [0, n) on the workers and returns
+     * once all calls have finished. Called from one of the pool's own
+     * workers, runs every call on that worker instead.
+     */
+    void parallel_for(size_t n, const std::function<void(size_t)> &fn);
+
+    /**
+     * @brief Blocks until every submitted task has finished.
+     */
+    void wait();
+
+    /**
+     * @brief Returns the number of workers.
+     */
+    size_t size() const;
+
+    /**
+     * @brief Returns the index, in [0, size()), of the worker calling it, or
+     * `size()` if the caller is not one of this pool's workers.
+     */
+    size_t worker() const;
+
+   private:
+    struct Queue {
+        std::mutex mtx;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    void run(size_t index);
+
+    /**
+     * @brief Takes a task from worker `index`'s queue, or steals one.
+     */
+    bool take(size_t index, std::function<void()> &task);
+
+    /**
+     * @brief Wakes a parked worker if there is one.
+     */
+    void wake_one();
+
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::mutex mtx_;                   ///< Held to park, wake and wait for idle
+    std::condition_variable cv_;       ///< Signals parked workers that a task is queued or the pool stops
+    std::condition_variable idle_cv_;  ///< Signals `wait` that the pool went idle
+    std::atomic<ptrdiff_t> queued_;    ///< Tasks in the queues, less any just pushed and not yet counted
+    std::atomic<size_t> pending_;      ///< Tasks submitted and not finished
+    std::atomic<size_t> next_;         ///< The queue the next outside task goes to
+    std::atomic<size_t> parked_;       ///< Workers parked on `cv_`, or about to be
+    std::atomic<bool> stop_;
+    std::vector<std::thread> threads_;
+};
+
+}  // namespace util
+}  // namespace rix
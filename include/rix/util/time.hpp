@@ -2,6 +2,7 @@
 
 #include <chrono>
 #include <cmath>
+#include <cstdint>
 #include <string>
 
 #include "rix/msg/standard/Duration.hpp"
@@ -12,7 +13,8 @@ namespace util {
 
 using Clock = std::chrono::system_clock;
 
-class Duration;  // Forward declaration
+class Duration;   // Forward declaration
+class Histogram;  // Forward declaration
 
 class Time {
    public:
@@ -141,6 +143,12 @@ class Timer {
      */
     Timer();
 
+    /**
+     * @brief Constructs a Timer that records every start/stop interval in
+     * `histogram`.
+     */
+    explicit Timer(Histogram &histogram);
+
     Timer(const Timer &other);
     Timer &operator=(const Timer &other);
 
@@ -150,7 +158,8 @@ class Timer {
     void start();
 
     /**
-     * @brief Stops the timer.
+     * @brief Stops the timer, recording the interval if the timer has a
+     * histogram.
      */
     void stop();
 
@@ -161,8 +170,9 @@ class Timer {
     Duration get() const;
 
    private:
-    Time start_;  //< The start time.
-    Time end_;    //< The end time.
+    Time start_;                      //< The start time.
+    Time end_;                        //< The end time.
+    Histogram *histogram_ = nullptr;  //< Where intervals are recorded, if anywhere.
 };
 
 /**
@@ -182,6 +192,42 @@ class Rate {
     static inline Duration min_period() { return Duration(0, 1); }
     static inline Duration max_period() { return Duration(std::chrono::nanoseconds::max()); }
 
+    /**
+     * @brief How `sleep` waits for the end of a period.
+     *
+     * @details
+     *     SLEEP:   Sleeps until one period after the previous wakeup. Oversleep
+     *              accumulates as drift, and the wakeup is only as precise as
+     *              the scheduler.
+     *     PRECISE: Keeps a fixed schedule of deadlines, `period` apart. Sleeps
+     *              with `clock_nanosleep(TIMER_ABSTIME)` until `spin` before the
+     *              deadline, then spins on `Time::now` for the rest. Costs up to
+     *              `spin` of CPU per cycle in exchange for microsecond jitter.
+     */
+    enum class Mode { SLEEP, PRECISE };
+
+    /**
+     * @brief What a PRECISE rate does after a cycle overruns its deadline.
+     *
+     * @details
+     *     CATCH_UP: Keeps every deadline; the missed cycles run back to back
+     *               until the loop is on schedule again.
+     *     SKIP:     Drops the missed deadlines and waits for the next one
+     *               still in the future, keeping the original phase.
+     */
+    enum class Overrun { CATCH_UP, SKIP };
+
+    struct Stats {
+        uint64_t cycles = 0;          ///< Calls to `sleep`
+        uint64_t overruns = 0;        ///< Cycles that reached `sleep` after their deadline
+        uint64_t skipped = 0;         ///< Deadlines dropped by Overrun::SKIP
+        Duration last_lateness;       ///< Wakeup minus deadline of the last cycle
+        Duration max_lateness;        ///< Largest wakeup minus deadline
+        Duration total_lateness;      ///< Sum of wakeup minus deadline, for the mean
+
+        Duration mean_lateness() const { return cycles > 0 ? total_lateness / static_cast<double>(cycles) : Duration(); }
+    };
+
     Rate();
     /**
      * @brief Constructs a Rate object.
@@ -190,6 +236,12 @@ class Rate {
     explicit Rate(double frequency);  //(Done By Waj) Handle case of 0 frequency (infinite duration)
     explicit Rate(Duration period);   //(Done By Waj) Handle case of 0 duration (infinite frequency)
 
+    /**
+     * @brief Constructs a Rate object with a wait mode and overrun policy.
+     */
+    Rate(double frequency, Mode mode, Overrun overrun = Overrun::SKIP);
+    Rate(Duration period, Mode mode, Overrun overrun = Overrun::SKIP);
+
     Rate(const Rate &other);
     Rate &operator=(const Rate &other);
 
@@ -199,14 +251,42 @@ class Rate {
      */
     bool sleep();
 
+    /**
+     * @brief Restarts the schedule from now, e.g. after the loop was paused.
+     * The statistics are kept.
+     */
+    void reset();
+
     Duration period() const;
     void set_period(const Duration &period);
     double frequency() const;
     void set_frequency(double frequency);
 
+    Mode mode() const;
+    void set_mode(Mode mode);
+    Overrun overrun() const;
+    void set_overrun(Overrun overrun);
+
+    /**
+     * @brief How long before each deadline a PRECISE rate stops sleeping and
+     * starts spinning. Should cover the scheduler's wakeup latency.
+     */
+    Duration spin() const;
+    void set_spin(const Duration &spin);
+
+    const Stats &stats() const;
+    void reset_stats();
+
    private:
+    bool sleep_precise();
+    void record(const Duration &lateness);
+
     Duration period_;
-    Time start_;
+    Time start_;  ///< Previous wakeup (SLEEP) or the next deadline (PRECISE)
+    Mode mode_;
+    Overrun overrun_;
+    Duration spin_;
+    Stats stats_;
 };
 
 }  // namespace util
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "rix/util/time.hpp"
+
+namespace rix {
+namespace util {
+
+/**
+ * @brief Tracks large numbers of one-shot deadlines (timeouts, watchdogs,
+ * keep-alives) on a single thread.
+ *
+ * @details A hierarchical timing wheel: time is divided into ticks of
+ * `resolution`, and each of the `LEVELS` wheels has `SLOTS` slots covering
+ * `SLOTS` times the span of a slot in the wheel below. Timers are kept in
+ * intrusive lists, so scheduling and cancelling are O(1). Each tick of
+ * `advance` fires one slot of the lowest wheel and, every `SLOTS` ticks,
+ * redistributes one slot of the wheel above; every timer is moved at most
+ * once per level. Timers never fire early and fire at most one tick late.
+ *
+ * The wheel is not thread-safe. It is meant to be owned by an event loop,
+ * which uses `time_until_next` as its wait timeout:
+ *
+ *     while (running) {
+ *         if (io.wait_for_readable(wheel.time_until_next())) {
+ *             ...
+ *         }
+ *         wheel.advance();
+ *     }
+ *
+ * Callbacks run on the thread calling `advance` and may schedule or cancel
+ * timers, including themselves.
+ */
+class TimerWheel {
+   public:
+    using TimerId = uint64_t;
+    using Callback = std::function<void()>;
+
+    static constexpr int LEVELS = 4;
+    static constexpr int SLOT_BITS = 8;
+    static constexpr size_t SLOTS = size_t(1) << SLOT_BITS;
+
+    /**
+     * @brief Constructs an empty wheel.
+     *
+     * @param resolution The length of a tick. Deadlines are rounded up to a
+     * whole tick.
+     * @param start The time of tick zero.
+     */
+    explicit TimerWheel(const Duration &resolution = Duration(0.001), const Time &start = Time::now());
+
+    TimerWheel(const TimerWheel &other) = delete;
+    TimerWheel &operator=(const TimerWheel &other) = delete;
+
+    /**
+     * @brief Calls `callback` from the first `advance` at or after `deadline`.
+     *
+     * @return The identifier used to cancel or reschedule the timer. Never 0.
+     */
+    TimerId schedule_at(const Time &deadline, Callback callback);
+
+    /**
+     * @brief Calls `callback` once `delay` has passed from now.
+     */
+    TimerId schedule_after(const Duration &delay, Callback callback);
+
+    /**
+     * @brief Moves a pending timer to a new deadline, e.g. to kick a watchdog.
+     *
+     * @return false if the timer has already fired or been cancelled.
+     */
+    bool reschedule(TimerId id, const Time &deadline);
+
+    /**
+     * @brief Cancels a pending timer.
+     *
+     * @return false if the timer has already fired or been cancelled.
+     */
+    bool cancel(TimerId id);
+
+    /**
+     * @brief Fires every timer whose deadline is at or before `now`.
+     *
+     * @return The number of timers fired.
+     */
+    size_t advance(const Time &now = Time::now());
+
+    /**
+     * @brief Returns how long the owner may wait before the next timer is
+     * due: exact when the next timer is within `SLOTS` ticks, otherwise a
+     * lower bound. Zero if a timer is already due, `Duration::max()` if no
+     * timer is pending.
+     */
+    Duration time_until_next(const Time &now = Time::now()) const;
+
+    /**
+     * @brief Returns the number of pending timers.
+     */
+    size_t size() const;
+
+    bool empty() const;
+
+    Duration resolution() const;
+
+   private:
+    static constexpr uint32_t NONE = UINT32_MAX;
+    static constexpr uint32_t FIRING = LEVELS * SLOTS;  ///< List of timers being fired by `advance`
+
+    struct Node {
+        int64_t expires = 0;     ///< Deadline in ticks
+        Callback callback;
+        uint32_t prev = NONE;
+        uint32_t next = NONE;
+        uint32_t list = NONE;    ///< The list the node is linked into, or NONE if free
+        uint32_t generation = 0;
+    };
+
+    /**
+     * @brief Returns the first tick at or after `time`.
+     */
+    int64_t deadline_tick(const Time &time) const;
+
+    /**
+     * @brief Returns the last tick at or before `time`.
+     */
+    int64_t current_tick(const Time &time) const;
+
+    /**
+     * @brief Links a node into the slot for its deadline.
+     */
+    void place(uint32_t index);
+    void link(uint32_t index, uint32_t list);
+    void unlink(uint32_t index);
+    void release(uint32_t index);
+    uint32_t allocate();
+    Node *find(TimerId id);
+
+    /**
+     * @brief Moves the timers of a slot into the wheels below.
+     */
+    void cascade(int level, size_t slot);
+
+    int64_t resolution_ns_;
+    int64_t start_ns_;
+    int64_t current_;  ///< The last tick processed by `advance`
+    size_t size_;
+    std::vector<Node> nodes_;
+    std::vector<uint32_t> free_;
+    std::array<uint32_t, LEVELS * SLOTS + 1> heads_;  ///< First node of each slot's list, and of FIRING
+    std::array<size_t, LEVELS> level_sizes_;         ///< Timers in each wheel
+};
+
+}  // namespace util
+}  // namespace rix
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "rix/util/time.hpp"
+
+namespace rix {
+namespace util {
+
+/**
+ * @brief Formats times as `MM/DD/YY HH:MM:SS.uuuuuu <zone>`, the layout of
+ * `Time::to_string` and log headers.
+ *
+ * @details Calendar conversion is the expensive part of formatting a time, and
+ * consecutive timestamps almost always fall in the same second. The formatter
+ * caches the rendered `MM/DD/YY HH:MM:SS.` prefix and the zone suffix, and
+ * only renders the six microsecond digits on each call, two at a time from a
+ * lookup table. A formatter is not thread-safe; use `utc()` or `local()` for a
+ * per-thread instance.
+ */
+class TimestampFormatter {
+   public:
+    /**
+     * @brief Enough room for any formatted timestamp.
+     */
+    static constexpr size_t MAX_SIZE = 64;
+
+    explicit TimestampFormatter(bool local_time = false);
+
+    /**
+     * @brief Writes the formatted time to `out`, which must hold at least
+     * MAX_SIZE characters. The output is not null-terminated.
+     *
+     * @return The number of characters written.
+     */
+    size_t format(const Time &t, char *out);
+
+    std::string format(const Time &t);
+
+    /**
+     * @brief The calling thread's UTC formatter.
+     */
+    static TimestampFormatter &utc();
+
+    /**
+     * @brief The calling thread's local time formatter.
+     */
+    static TimestampFormatter &local();
+
+   private:
+    void render_prefix(int64_t second);
+
+    const bool local_time_;
+    int64_t cached_second_;
+    char prefix_[MAX_SIZE];
+    size_t prefix_len_;
+    char suffix_[MAX_SIZE];
+    size_t suffix_len_;
+};
+
+namespace detail {
+
+/**
+ * @brief Writes `value` (< 1,000,000) as exactly six decimal digits.
+ */
+void format_micros(uint32_t value, char *out);
+
+}  // namespace detail
+
+}  // namespace util
+}  // namespace rix
@@ -8,6 +8,7 @@
 #include "rix/msg/geometry/Twist2DStamped.hpp"
 #include "rix/msg/standard/UInt32.hpp"
 #include "rix/util/argument_parser.hpp"
+#include "rix/util/profile.hpp"
 #include "rix/util/time.hpp"
 
 using namespace rix::ipc;
@@ -1,6 +1,40 @@
 #include "mbot/mbot.hpp"
 
-MBot::MBot() : file("/dev/mbot_lcm", O_RDWR | O_NOCTTY | O_NDELAY, 0) {
+#include "rix/util/profile.hpp"
+
+namespace {
+
+constexpr int64_t BAUD_RATE = 115200;
+constexpr int64_t BITS_PER_BYTE = 10;  // 8 data bits, 1 start bit, 1 stop bit
+
+// Time needed to clock `bytes` out of the UART. A packet can never arrive
+// sooner than this after the board stamped it.
+int64_t transit_us(size_t bytes) { return static_cast<int64_t>(bytes) * BITS_PER_BYTE * 1'000'000 / BAUD_RATE; }
+
+// Topics the board sends whose struct begins with `int64_t utime`, the board
+// time at which the message was created. Others, such as serial_particle_t
+// and serial_joy_t, start with other fields.
+bool stamped_by_board(uint16_t topic) {
+    switch (topic) {
+        case MBOT_TIMESYNC:   // serial_timestamp_t
+        case MBOT_ODOMETRY:   // serial_pose2D_t
+        case MBOT_IMU:        // serial_mbot_imu_t
+        case MBOT_ENCODERS:   // serial_mbot_encoders_t
+        case MBOT_MOTOR_VEL:  // serial_mbot_motor_vel_t
+        case MBOT_MOTOR_PWM:  // serial_mbot_motor_pwm_t
+        case MBOT_VEL:        // serial_twist2D_t
+            return true;
+        default:
+            return false;
+    }
+}
+
+}  // namespace
+
+MBot::MBot(const rix::util::Duration &watchdog_timeout)
+    : wake_pipe(rix::ipc::Pipe::create()),
+      watchdog_timeout(watchdog_timeout),
+      file("/dev/mbot_lcm", O_RDWR | O_NOCTTY | O_NDELAY, 0) {
     if (!file.ok()) {
         perror("open");
         return;
@@ -24,24 +58,42 @@ MBot::MBot() : file("/dev/mbot_lcm", O_RDWR | O_NOCTTY | O_NDELAY, 0) {
         return;
     }
 
-    timesync_thr = std::thread(std::bind(&MBot::timesync, this));
+    // Periodic jobs share the scheduler thread; timesync runs at 2 Hz
+    scheduler.add(rix::util::Duration(0.5), std::bind(&MBot::timesync, this));
+    if (this->watchdog_timeout > rix::util::Duration(0.0)) {
+        scheduler.add(this->watchdog_timeout / 4, std::bind(&MBot::watchdog, this));
+    }
+    receive_thr = std::thread(std::bind(&MBot::receive, this));
 }
 
 MBot::~MBot() {
-    // Set the stop flag for the time synchronization thread
-    stop_timesync_flag = 1;
+    // Cancel the periodic jobs. This returns as soon as any job in progress
+    // finishes rather than waiting out the period.
+    scheduler.stop();
 
-    // Join the time synchronization thread
-    if (timesync_thr.joinable()) {
-        timesync_thr.join();
+    // Wake and join the receive thread
+    stop_flag = true;
+    uint8_t byte = 1;
+    wake_pipe[1].write(&byte, 1);
+    if (receive_thr.joinable()) {
+        receive_thr.join();
     }
 }
 
 bool MBot::ok() const { return file.ok(); }
 
+const TimeSync &MBot::clock() const { return clock_; }
+
+const rix::util::Histogram &MBot::write_latency() const { return write_latency_; }
+
+const rix::util::Histogram &MBot::end_to_end_latency() const { return end_to_end_latency_; }
+
 void MBot::drive(const Twist2DStamped &cmd) const {
+    RIX_PROFILE_SCOPE("mbot.drive");
     serial_twist2D_t mbot_cmd;
-    mbot_cmd.utime = rix::util::Time(cmd.header.stamp).to_microseconds();
+    // Express the command stamp in the board's clock so it can be related to
+    // the board's own timestamps
+    mbot_cmd.utime = clock_.host_to_board(rix::util::Time(cmd.header.stamp).to_microseconds());
     mbot_cmd.vx = cmd.twist.vx;
     mbot_cmd.vy = cmd.twist.vy;
     mbot_cmd.wz = cmd.twist.wz;
@@ -53,37 +105,136 @@ void MBot::drive(const Twist2DStamped &cmd) const {
 
     // Send the drive command
     mtx.lock();
+    rix::util::Time write_start = rix::util::Time::now();
     file.write(msg, sizeof(msg));
+    rix::util::Time write_end = rix::util::Time::now();
     mtx.unlock();
+
+    write_latency_.record(write_end - write_start);
+    if (cmd.header.stamp.sec != 0 || cmd.header.stamp.nsec != 0) {
+        end_to_end_latency_.record(write_end - rix::util::Time(cmd.header.stamp));
+    }
+
+    last_drive_ns = write_end.to_nanoseconds();
+    moving = cmd.twist.vx != 0.0f || cmd.twist.vy != 0.0f || cmd.twist.wz != 0.0f;
 }
 
 void MBot::timesync() {
-    int status;
-
-    // Time synchronization loop
-    while (!stop_timesync_flag) {
-        // Encode the timesync message
-        serial_timestamp_t msg = {0};
-        struct timespec ts;
-        clock_gettime(CLOCK_REALTIME, &ts);
-        msg.utime = ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
-        const size_t msg_size = sizeof(serial_timestamp_t) + ROS_PKG_LENGTH;
-        uint8_t rospkt[msg_size];
-        if (encode_msg((uint8_t *)&msg, sizeof(serial_timestamp_t), MBOT_TIMESYNC, rospkt, msg_size) < 0) {
-            perror("encode_msg");
-            break;
+    // Encode the timesync message
+    serial_timestamp_t msg = {0};
+    msg.utime = rix::util::Time::now().to_microseconds();
+    const size_t msg_size = sizeof(serial_timestamp_t) + ROS_PKG_LENGTH;
+    uint8_t rospkt[msg_size];
+    if (encode_msg((uint8_t *)&msg, sizeof(serial_timestamp_t), MBOT_TIMESYNC, rospkt, msg_size) < 0) {
+        perror("encode_msg");
+        return;
+    }
+
+    // Send the timesync message
+    mtx.lock();
+    int status = file.write(rospkt, msg_size);
+    mtx.unlock();
+    if (status < 0) {
+        perror("write");
+        return;
+    }
+    timesync_tx_us = msg.utime;
+}
+
+void MBot::watchdog() {
+    // Stop the MBot if commands have stopped arriving while it is moving
+    int64_t elapsed_ns = rix::util::Time::now().to_nanoseconds() - last_drive_ns;
+    if (moving && elapsed_ns > watchdog_timeout.to_nanoseconds()) {
+        Twist2DStamped stop_cmd;
+        stop_cmd.header.stamp = rix::util::Time::now().to_msg();
+        drive(stop_cmd);
+    }
+}
+
+void MBot::receive() {
+    std::vector<uint8_t> buffer;
+    uint8_t chunk[256];
+
+    struct pollfd fds[2];
+    fds[0].fd = file.fd();
+    fds[0].events = POLLIN;
+    fds[1].fd = wake_pipe[0].fd();
+    fds[1].events = POLLIN;
+
+    while (!stop_flag) {
+        // Block until data arrives or the destructor wakes us
+        fds[0].revents = 0;
+        fds[1].revents = 0;
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("poll");
+            return;
+        }
+        if (!(fds[0].revents & POLLIN)) {
+            // A hang-up or error without data means the serial adapter is
+            // gone; polling again would return at once, forever
+            if (fds[0].revents & (POLLHUP | POLLERR | POLLNVAL)) {
+                fprintf(stderr, "MBot serial port disconnected\n");
+                return;
+            }
+            continue;
         }
+        int64_t host_rx_us = rix::util::Time::now().to_microseconds();
+        ssize_t bytes_read = file.read(chunk, sizeof(chunk));
+        if (bytes_read < 0 && (errno == EINTR || errno == EAGAIN)) {
+            continue;
+        }
+        if (bytes_read < 0) {
+            perror("read");
+            return;
+        }
+        if (bytes_read == 0) {
+            fprintf(stderr, "MBot serial port disconnected\n");
+            return;
+        }
+        buffer.insert(buffer.end(), chunk, chunk + bytes_read);
 
-        // Send the timesync message
-        mtx.lock();
-        status = file.write(rospkt, msg_size);
-        mtx.unlock();
-        if (status < 0) {
-            perror("write");
-            break;
+        // Extract every complete packet, resynchronizing on the sync flags
+        // whenever a header or checksum does not match
+        size_t pos = 0;
+        while (buffer.size() - pos >= ROS_PKG_LENGTH) {
+            uint8_t *pkt = buffer.data() + pos;
+            if (pkt[0] != SYNC_FLAG || pkt[1] != VERSION_FLAG || checksum(&pkt[2], 2) != pkt[4]) {
+                pos++;
+                continue;
+            }
+            size_t msg_len = pkt[2] | (pkt[3] << 8);
+            if (buffer.size() - pos < msg_len + ROS_PKG_LENGTH) {
+                break;
+            }
+            if (checksum(&pkt[5], msg_len + 2) != pkt[ROS_HEADER_LENGTH + msg_len]) {
+                pos++;
+                continue;
+            }
+            uint16_t topic = pkt[5] | (pkt[6] << 8);
+            handle_packet(topic, &pkt[ROS_HEADER_LENGTH], msg_len, host_rx_us);
+            pos += msg_len + ROS_PKG_LENGTH;
         }
+        buffer.erase(buffer.begin(), buffer.begin() + pos);
+    }
+}
 
-        // Run at 2 Hz
-        usleep(500000);
+void MBot::handle_packet(uint16_t topic, const uint8_t *data, size_t len, int64_t host_rx_us) {
+    int64_t board_us;
+    if (!stamped_by_board(topic) || len < sizeof(board_us)) {
+        return;
+    }
+    memcpy(&board_us, data, sizeof(board_us));
+
+    int64_t min_transit_us = transit_us(len + ROS_PKG_LENGTH);
+    if (topic == MBOT_TIMESYNC) {
+        int64_t host_tx_us = timesync_tx_us.exchange(0);
+        if (host_tx_us != 0) {
+            clock_.add_round_trip(host_tx_us, board_us, host_rx_us, min_transit_us);
+            return;
+        }
     }
+    clock_.add_one_way(board_us, host_rx_us, min_transit_us);
 }
\ No newline at end of file
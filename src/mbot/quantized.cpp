@@ -0,0 +1,126 @@
+#include "mbot/quantized.hpp"
+
+#include <algorithm>
+
+using rix::msg::Quantizer;
+
+namespace {
+
+constexpr size_t BLOCK = 64;
+
+// Batches are converted one field at a time: the field is gathered into a
+// block of contiguous values for the vectorized `Quantizer` loops, then
+// scattered into the output structs
+template <typename From, typename To, typename Get, typename Set>
+void encode_field(const Quantizer &quantizer, const From *src, size_t n, To *dst, Get get, Set set) {
+    float values[BLOCK];
+    uint16_t codes[BLOCK];
+    for (size_t start = 0; start < n; start += BLOCK) {
+        const size_t count = std::min(BLOCK, n - start);
+        for (size_t i = 0; i < count; i++) {
+            values[i] = get(src[start + i]);
+        }
+        quantizer.encode(values, count, codes);
+        for (size_t i = 0; i < count; i++) {
+            set(dst[start + i], codes[i]);
+        }
+    }
+}
+
+template <typename From, typename To, typename Get, typename Set>
+void decode_field(const Quantizer &quantizer, const From *src, size_t n, To *dst, Get get, Set set) {
+    uint16_t codes[BLOCK];
+    float values[BLOCK];
+    for (size_t start = 0; start < n; start += BLOCK) {
+        const size_t count = std::min(BLOCK, n - start);
+        for (size_t i = 0; i < count; i++) {
+            codes[i] = get(src[start + i]);
+        }
+        quantizer.decode(codes, count, values);
+        for (size_t i = 0; i < count; i++) {
+            set(dst[start + i], values[i]);
+        }
+    }
+}
+
+}  // namespace
+
+serial_quantized_pose2D_t SerialPose2DQuantization::encode(const serial_pose2D_t &src) const {
+    serial_quantized_pose2D_t dst;
+    dst.utime = src.utime;
+    dst.x = position.encode(src.x);
+    dst.y = position.encode(src.y);
+    dst.theta = angle.encode(src.theta);
+    return dst;
+}
+
+serial_pose2D_t SerialPose2DQuantization::decode(const serial_quantized_pose2D_t &src) const {
+    serial_pose2D_t dst;
+    dst.utime = src.utime;
+    dst.x = position.decode(src.x);
+    dst.y = position.decode(src.y);
+    dst.theta = angle.decode(src.theta);
+    return dst;
+}
+
+void SerialPose2DQuantization::encode(const serial_pose2D_t *src, size_t n, serial_quantized_pose2D_t *dst) const {
+    for (size_t i = 0; i < n; i++) {
+        dst[i].utime = src[i].utime;
+    }
+    using From = serial_pose2D_t;
+    using To = serial_quantized_pose2D_t;
+    encode_field(position, src, n, dst, [](const From &p) { return p.x; }, [](To &q, uint16_t c) { q.x = c; });
+    encode_field(position, src, n, dst, [](const From &p) { return p.y; }, [](To &q, uint16_t c) { q.y = c; });
+    encode_field(angle, src, n, dst, [](const From &p) { return p.theta; }, [](To &q, uint16_t c) { q.theta = c; });
+}
+
+void SerialPose2DQuantization::decode(const serial_quantized_pose2D_t *src, size_t n, serial_pose2D_t *dst) const {
+    for (size_t i = 0; i < n; i++) {
+        dst[i].utime = src[i].utime;
+    }
+    using From = serial_quantized_pose2D_t;
+    using To = serial_pose2D_t;
+    decode_field(position, src, n, dst, [](const From &q) { return q.x; }, [](To &p, float v) { p.x = v; });
+    decode_field(position, src, n, dst, [](const From &q) { return q.y; }, [](To &p, float v) { p.y = v; });
+    decode_field(angle, src, n, dst, [](const From &q) { return q.theta; }, [](To &p, float v) { p.theta = v; });
+}
+
+serial_quantized_twist2D_t SerialTwist2DQuantization::encode(const serial_twist2D_t &src) const {
+    serial_quantized_twist2D_t dst;
+    dst.utime = src.utime;
+    dst.vx = linear.encode(src.vx);
+    dst.vy = linear.encode(src.vy);
+    dst.wz = angular.encode(src.wz);
+    return dst;
+}
+
+serial_twist2D_t SerialTwist2DQuantization::decode(const serial_quantized_twist2D_t &src) const {
+    serial_twist2D_t dst;
+    dst.utime = src.utime;
+    dst.vx = linear.decode(src.vx);
+    dst.vy = linear.decode(src.vy);
+    dst.wz = angular.decode(src.wz);
+    return dst;
+}
+
+void SerialTwist2DQuantization::encode(const serial_twist2D_t *src, size_t n, serial_quantized_twist2D_t *dst) const {
+    for (size_t i = 0; i < n; i++) {
+        dst[i].utime = src[i].utime;
+    }
+    using From = serial_twist2D_t;
+    using To = serial_quantized_twist2D_t;
+    encode_field(linear, src, n, dst, [](const From &t) { return t.vx; }, [](To &q, uint16_t c) { q.vx = c; });
+    encode_field(linear, src, n, dst, [](const From &t) { return t.vy; }, [](To &q, uint16_t c) { q.vy = c; });
+    encode_field(angular, src, n, dst, [](const From &t) { return t.wz; }, [](To &q, uint16_t c) { q.wz = c; });
+}
+
+void SerialTwist2DQuantization::decode(const serial_quantized_twist2D_t *src, size_t n, serial_twist2D_t *dst) const {
+    for (size_t i = 0; i < n; i++) {
+        dst[i].utime = src[i].utime;
+    }
+    using From = serial_quantized_twist2D_t;
+    using To = serial_twist2D_t;
+    decode_field(linear, src, n, dst, [](const From &q) { return q.vx; }, [](To &t, float v) { t.vx = v; });
+    decode_field(linear, src, n, dst, [](const From &q) { return q.vy; }, [](To &t, float v) { t.vy = v; });
+    decode_field(angular, src, n, dst, [](const From &q) { return q.wz; }, [](To &t, float v) { t.wz = v; });
+}
@@ -0,0 +1,157 @@
+#include "mbot/timesync.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+TimeSync::TimeSync(size_t window, size_t buckets, double max_drift_ppm)
+    : window_(std::max<size_t>(window, 1)),
+      buckets_(std::max<size_t>(buckets, 1)),
+      max_drift_(std::abs(max_drift_ppm) * 1e-6),
+      synchronized_(false),
+      ref_us_(0),
+      offset_us_(0.0),
+      drift_(0.0) {}
+
+void TimeSync::add_round_trip(int64_t host_tx_us, int64_t board_us, int64_t host_rx_us, int64_t min_transit_us) {
+    if (host_rx_us < host_tx_us) {
+        return;
+    }
+    // The board stamped the reply after the request arrived and before the
+    // reply left, so the offset lies between these two bounds.
+    Sample sample;
+    sample.host_us = host_tx_us + (host_rx_us - host_tx_us) / 2;
+    sample.lower = static_cast<double>(board_us - host_rx_us + min_transit_us);
+    sample.upper = static_cast<double>(board_us - host_tx_us - min_transit_us);
+    if (sample.upper < sample.lower) {
+        sample.upper = std::numeric_limits<double>::infinity();
+    }
+    add(sample);
+}
+
+void TimeSync::add_one_way(int64_t board_us, int64_t host_rx_us, int64_t min_transit_us) {
+    Sample sample;
+    sample.host_us = host_rx_us - min_transit_us;
+    sample.lower = static_cast<double>(board_us - host_rx_us + min_transit_us);
+    sample.upper = std::numeric_limits<double>::infinity();
+    add(sample);
+}
+
+bool TimeSync::synchronized() const {
+    std::lock_guard<std::mutex> guard(mtx_);
+    return synchronized_;
+}
+
+double TimeSync::offset(int64_t host_us) const {
+    std::lock_guard<std::mutex> guard(mtx_);
+    return offset_us_ + drift_ * static_cast<double>(host_us - ref_us_);
+}
+
+double TimeSync::drift_ppm() const {
+    std::lock_guard<std::mutex> guard(mtx_);
+    return drift_ * 1e6;
+}
+
+int64_t TimeSync::host_to_board(int64_t host_us) const {
+    std::lock_guard<std::mutex> guard(mtx_);
+    if (!synchronized_) {
+        return host_us;
+    }
+    double h = static_cast<double>(host_us - ref_us_);
+    return ref_us_ + std::llround(h + offset_us_ + drift_ * h);
+}
+
+int64_t TimeSync::board_to_host(int64_t board_us) const {
+    std::lock_guard<std::mutex> guard(mtx_);
+    if (!synchronized_) {
+        return board_us;
+    }
+    double b = static_cast<double>(board_us - ref_us_);
+    return ref_us_ + std::llround((b - offset_us_) / (1.0 + drift_));
+}
+
+void TimeSync::reset() {
+    std::lock_guard<std::mutex> guard(mtx_);
+    samples_.clear();
+    synchronized_ = false;
+    ref_us_ = 0;
+    offset_us_ = 0.0;
+    drift_ = 0.0;
+}
+
+void TimeSync::add(const Sample &sample) {
+    std::lock_guard<std::mutex> guard(mtx_);
+    samples_.push_back(sample);
+    while (samples_.size() > window_) {
+        samples_.pop_front();
+    }
+    update();
+}
+
+void TimeSync::update() {
+    // Fit one kind of sample only. A round trip contributes the midpoint of
+    // its bounds and a one-way sample its lower bound, which differ by about
+    // half the round-trip delay, so mixing them would put a step into the
+    // fit. Round trips are preferred whenever the window holds any.
+    std::vector<const Sample *> kind;
+    kind.reserve(samples_.size());
+    for (const Sample &s : samples_) {
+        if (std::isfinite(s.upper)) {
+            kind.push_back(&s);
+        }
+    }
+    const bool round_trips = !kind.empty();
+    if (!round_trips) {
+        for (const Sample &s : samples_) {
+            kind.push_back(&s);
+        }
+    }
+
+    // Reduce each bucket to its best sample. For round trips this is the one
+    // with the smallest delay (tightest bounds), as in NTP. For one-way
+    // samples it is the one with the largest lower bound, i.e. the packet
+    // that suffered the least queuing delay.
+    const size_t n = kind.size();
+    const size_t nb = std::min(buckets_, n);
+    const size_t per_bucket = (n + nb - 1) / nb;
+
+    std::vector<int64_t> t;
+    std::vector<double> v;
+    t.reserve(nb);
+    v.reserve(nb);
+    for (size_t begin = 0; begin < n; begin += per_bucket) {
+        size_t end = std::min(begin + per_bucket, n);
+        const Sample *best = kind[begin];
+        for (size_t i = begin + 1; i < end; i++) {
+            const Sample *s = kind[i];
+            if (round_trips ? s->upper - s->lower < best->upper - best->lower : s->lower > best->lower) {
+                best = s;
+            }
+        }
+        t.push_back(best->host_us);
+        v.push_back(round_trips ? (best->lower + best->upper) / 2.0 : best->lower);
+    }
+
+    // Fit offset(t) = offset_us_ + drift_ * (t - ref_us_)
+    const int64_t t0 = t.front();
+    double t_mean = 0.0, v_mean = 0.0;
+    for (size_t i = 0; i < t.size(); i++) {
+        t_mean += static_cast<double>(t[i] - t0);
+        v_mean += v[i];
+    }
+    t_mean /= t.size();
+    v_mean /= v.size();
+
+    double cov = 0.0, var = 0.0;
+    for (size_t i = 0; i < t.size(); i++) {
+        double dt = static_cast<double>(t[i] - t0) - t_mean;
+        cov += dt * (v[i] - v_mean);
+        var += dt * dt;
+    }
+
+    drift_ = (var > 0.0) ? std::clamp(cov / var, -max_drift_, max_drift_) : 0.0;
+    ref_us_ = t0 + std::llround(t_mean);
+    offset_us_ = v_mean;
+    synchronized_ = true;
+}
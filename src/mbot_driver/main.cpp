@@ -9,19 +9,67 @@
 #include "rix/ipc/signal.hpp"
 #include "rix/msg/geometry/Twist2DStamped.hpp"
 #include "rix/msg/standard/UInt32.hpp"
+#include "rix/util/argument_parser.hpp"
+#include "rix/util/profile.hpp"
 
 using namespace rix::ipc;
 using namespace rix::msg;
+using namespace rix::util;
+
+int main(int argc, char **argv) {
+    ArgumentParser parser("mbot_driver", "Drives the MBot with commands read from stdin.");
+    parser.add<double>("keep_alive", "Period after which an unchanged command is sent again (s)", 'k', 0.5);
+    parser.add<bool>("pipelined", "Read, decode and drive on separate threads", 'p', false);
+    parser.add<std::vector<int>>("cpus", "CPUs to pin the input, decode and drive threads to (pipelined only)", 'c',
+                                 std::vector<int>{});
+
+    if (!parser.parse(argc, argv)) {
+        std::cerr << parser.help() << std::endl;
+        return 1;
+    }
+
+    double keep_alive;
+    if (!parser.get<double>("keep_alive", keep_alive)) {
+        std::cerr << "Failed to get keep_alive argument." << std::endl;
+        return 1;
+    }
+
+    bool pipelined;
+    std::vector<int> cpus;
+    if (!parser.get<bool>("pipelined", pipelined) || !parser.get<std::vector<int>>("cpus", cpus)) {
+        std::cerr << "Failed to get pipeline arguments." << std::endl;
+        return 1;
+    }
 
-int main() {
     auto mbot = std::make_unique<MBot>();
     if (!mbot->ok()) {
         return 1;
     }
+    const MBot &mbot_ref = *mbot;
 
     auto input = std::make_unique<File>(STDIN_FILENO);
     auto sig = std::make_unique<Signal>(SIGINT);
 
-    MBotDriver driver(std::move(input), std::move(mbot));
-    driver.spin(std::move(sig)); 
+    MBotDriver driver(std::move(input), std::move(mbot), Duration(keep_alive));
+    if (pipelined) {
+        MBotDriver::PipelineOptions options;
+        int *stage_cpus[] = {&options.input_cpu, &options.decode_cpu, &options.drive_cpu};
+        for (size_t i = 0; i < cpus.size() && i < 3; i++) {
+            *stage_cpus[i] = cpus[i];
+        }
+        driver.spin_pipelined(std::move(sig), options);
+    } else {
+        driver.spin(std::move(sig));
+    }
+
+    const MBotDriver::Stats &stats = driver.stats();
+    std::cerr << "Commands received: " << stats.received << ", coalesced: " << stats.coalesced
+              << ", dropped: " << stats.dropped << ", suppressed: " << stats.suppressed << ", sent: " << stats.sent
+              << ", frames dropped: " << stats.dropped_frames << std::endl;
+
+    const MBotDriver::Latency &latency = driver.latency();
+    std::cerr << "transit:      " << latency.transit.summary() << std::endl;
+    std::cerr << "serial write: " << mbot_ref.write_latency().summary() << std::endl;
+    std::cerr << "end to end:   " << mbot_ref.end_to_end_latency().summary() << std::endl;
+    Profiler::dump(std::cerr);
 }
\ No newline at end of file
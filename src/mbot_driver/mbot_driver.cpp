@@ -1,68 +1,275 @@
 #include "mbot_driver/mbot_driver.hpp"
 
+#include <pthread.h>
+#include <sched.h>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
 using namespace rix::ipc;
 using namespace rix::msg;
 
-MBotDriver::MBotDriver(std::unique_ptr<interfaces::IO> input, std::unique_ptr<MBotBase> mbot)
-    : input(std::move(input)), mbot(std::move(mbot)) {}
+namespace {
 
-void MBotDriver::spin(std::unique_ptr<interfaces::Notification> notif) {
-    // Allocate buffer for reading messages (max message size)
-    uint8_t buffer[4096];
+// Pins the calling thread to `cpu`; a negative value leaves it unpinned
+void pin_to_cpu(int cpu) {
+    if (cpu < 0) {
+        return;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0) {
+        perror("pthread_setaffinity_np");
+    }
+}
+
+}  // namespace
+
+MBotDriver::MBotDriver(std::unique_ptr<interfaces::IO> input, std::unique_ptr<MBotBase> mbot,
+                       const rix::util::Duration &keep_alive)
+    : input(std::move(input)), mbot(std::move(mbot)), keep_alive(keep_alive), has_last_sent(false) {}
 
+void MBotDriver::spin(std::unique_ptr<interfaces::Notification> notif) {
     while (true) {
         // Check if SIGINT received
         if (notif->is_ready()) {
-            // Send stop command before exiting
-            geometry::Twist2DStamped stop_cmd;
-            stop_cmd.twist.vx = 0.0;
-            stop_cmd.twist.vy = 0.0;
-            stop_cmd.twist.wz = 0.0;
-            mbot->drive(stop_cmd);
+            stop();
             return;
         }
 
-        // Read 4-byte message size
-        ssize_t size_bytes_read = input->read(buffer, 4);
-
-        // Check for EOF (0 bytes read)
-        if (size_bytes_read == 0) {
-            // Send stop command before exiting
-            geometry::Twist2DStamped stop_cmd;
-            stop_cmd.twist.vx = 0.0;
-            stop_cmd.twist.vy = 0.0;
-            stop_cmd.twist.wz = 0.0;
-            mbot->drive(stop_cmd);
+        // Block until the next command arrives
+        geometry::Twist2DStamped cmd;
+        ReadStatus status = read_command(cmd);
+        if (status == ReadStatus::END) {
+            stop();
             return;
         }
-
-        // Error reading size
-        if (size_bytes_read != 4) {
+        if (status == ReadStatus::ERROR) {
             continue;
         }
+        stats_.received++;
 
-        // Deserialize size
-        size_t offset = 0;
-        standard::UInt32 size_msg;
-        if (!size_msg.deserialize(buffer, 4, offset)) {
-            continue;
+        // Time each wakeup from the first command to the end of forwarding
+        RIX_PROFILE_SCOPE("mbot_driver.spin");
+
+        // Drain every command that is already waiting and keep only the newest
+        bool end = false;
+        while (input->is_readable()) {
+            geometry::Twist2DStamped next;
+            status = read_command(next);
+            if (status == ReadStatus::END) {
+                end = true;
+                break;
+            }
+            if (status == ReadStatus::ERROR) {
+                break;
+            }
+            stats_.received++;
+            stats_.coalesced++;
+            cmd = next;
         }
-        uint32_t msg_size = size_msg.data;
 
-        // Read message data
-        ssize_t msg_bytes_read = input->read(buffer, msg_size);
-        if (msg_bytes_read != (ssize_t)msg_size) {
-            continue;
+        forward(cmd);
+
+        if (end) {
+            stop();
+            return;
         }
+    }
+}
+
+void MBotDriver::spin_pipelined(std::unique_ptr<interfaces::Notification> notif, const PipelineOptions &options) {
+    rix::util::BoundedQueue<Frame> frames(options.frame_capacity, options.frame_policy);
+    rix::util::BoundedQueue<geometry::Twist2DStamped> commands(options.command_capacity, options.command_policy);
+    std::atomic<bool> stop_flag{false};
+    std::atomic<bool> done{false};
 
-        // Deserialize Twist2DStamped
-        offset = 0;
+    // Input stage: framed reads. Reads poll in short slices so they notice
+    // shutdown while the input is idle or a frame is only partly written.
+    std::thread input_thr([&] {
+        pin_to_cpu(options.input_cpu);
+        while (!stop_flag) {
+            uint32_t size;
+            ReadStatus status = read_size(size, &stop_flag);
+            Frame frame;
+            if (status == ReadStatus::OK) {
+                frame.data.resize(size);
+                status = read_body(frame.data.data(), size, &stop_flag);
+            }
+            if (status == ReadStatus::END) {
+                break;
+            }
+            if (status == ReadStatus::ERROR) {
+                continue;
+            }
+            frame.read_end = rix::util::Time::now();
+            frames.push(std::move(frame));
+            stats_.dropped_frames = frames.dropped();
+        }
+        frames.close();
+    });
+
+    // Decode stage
+    std::thread decode_thr([&] {
+        pin_to_cpu(options.decode_cpu);
+        Frame frame;
+        uint64_t lost = 0;  // Pushed after the queue closed on shutdown
+        while (frames.wait_pop(frame)) {
+            geometry::Twist2DStamped cmd;
+            if (!decode(frame.data.data(), frame.data.size(), frame.read_end, cmd)) {
+                continue;
+            }
+            stats_.received++;
+            if (!commands.push(std::move(cmd)) && commands.closed()) {
+                lost++;
+            }
+            stats_.dropped = commands.dropped() + lost;
+        }
+        commands.close();
+    });
+
+    // Drive stage
+    std::thread drive_thr([&] {
+        pin_to_cpu(options.drive_cpu);
         geometry::Twist2DStamped cmd;
-        if (!cmd.deserialize(buffer, msg_size, offset)) {
-            continue;
+        while (commands.wait_pop(cmd)) {
+            forward(cmd);
         }
+        done = true;
+    });
+
+    // Wait for SIGINT or for the pipeline to drain after the end of input
+    while (!done && !notif->wait(rix::util::Duration(0.01))) {
+    }
+
+    stop_flag = true;
+    frames.close();
+    commands.close();
+    input_thr.join();
+    decode_thr.join();
+    drive_thr.join();
+
+    stop();
+}
 
-        // Send command to Mbot
+const MBotDriver::Stats &MBotDriver::stats() const { return stats_; }
+
+const MBotDriver::Latency &MBotDriver::latency() const { return latency_; }
+
+MBotDriver::ReadStatus MBotDriver::read_exact(uint8_t *dst, size_t size, const std::atomic<bool> *stop) {
+    // A pipe may deliver a message in several pieces
+    size_t total = 0;
+    while (total < size) {
+        if (stop) {
+            while (!input->wait_for_readable(rix::util::Duration(0.01))) {
+                if (*stop) {
+                    return ReadStatus::ERROR;
+                }
+            }
+        }
+        ssize_t bytes_read = input->read(dst + total, size - total);
+        if (bytes_read == 0) {
+            return total == 0 ? ReadStatus::END : ReadStatus::ERROR;
+        }
+        if (bytes_read < 0) {
+            return ReadStatus::ERROR;
+        }
+        total += bytes_read;
+    }
+    return ReadStatus::OK;
+}
+
+MBotDriver::ReadStatus MBotDriver::read_size(uint32_t &size, const std::atomic<bool> *stop) {
+    // Read 4-byte message size
+    uint8_t prefix[4];
+    ReadStatus status = read_exact(prefix, sizeof(prefix), stop);
+    if (status != ReadStatus::OK) {
+        return status;
+    }
+
+    // Deserialize size
+    size_t offset = 0;
+    standard::UInt32 size_msg;
+    if (!size_msg.deserialize(prefix, sizeof(prefix), offset)) {
+        return ReadStatus::ERROR;
+    }
+    size = size_msg.data;
+    if (size <= sizeof(buffer)) {
+        return ReadStatus::OK;
+    }
+
+    // Skip the oversized body so the next read starts at a size prefix
+    uint8_t discard[256];
+    for (uint32_t left = size; left > 0;) {
+        uint32_t n = std::min<uint32_t>(left, sizeof(discard));
+        if (read_exact(discard, n, stop) != ReadStatus::OK) {
+            break;
+        }
+        left -= n;
+    }
+    return ReadStatus::ERROR;
+}
+
+MBotDriver::ReadStatus MBotDriver::read_body(uint8_t *dst, uint32_t size, const std::atomic<bool> *stop) {
+    ReadStatus status = read_exact(dst, size, stop);
+    return status == ReadStatus::END ? ReadStatus::ERROR : status;
+}
+
+bool MBotDriver::decode(const uint8_t *src, uint32_t size, const rix::util::Time &read_end,
+                        geometry::Twist2DStamped &cmd) {
+    // Deserialize Twist2DStamped
+    {
+        RIX_PROFILE_SCOPE("mbot_driver.deserialize");
+        size_t offset = 0;
+        if (!cmd.deserialize(src, size, offset)) {
+            return false;
+        }
+    }
+    latency_.transit.record(read_end - rix::util::Time(cmd.header.stamp));
+    return true;
+}
+
+MBotDriver::ReadStatus MBotDriver::read_command(geometry::Twist2DStamped &cmd) {
+    uint32_t size;
+    ReadStatus status = read_size(size);
+    if (status == ReadStatus::OK) {
+        status = read_body(buffer, size);
+    }
+    if (status != ReadStatus::OK) {
+        return status;
+    }
+    return decode(buffer, size, rix::util::Time::now(), cmd) ? ReadStatus::OK : ReadStatus::ERROR;
+}
+
+void MBotDriver::forward(const geometry::Twist2DStamped &cmd) {
+    // Suppress repeats of the last command unless the keep-alive has expired
+    rix::util::Time now = rix::util::Time::now();
+    bool unchanged = has_last_sent && cmd.twist.vx == last_sent.vx && cmd.twist.vy == last_sent.vy &&
+                     cmd.twist.wz == last_sent.wz;
+    if (unchanged && now - last_sent_time < keep_alive) {
+        stats_.suppressed++;
+        return;
+    }
+
+    // Send command to Mbot
+    {
+        RIX_PROFILE_SCOPE("mbot_driver.drive");
         mbot->drive(cmd);
     }
+    stats_.sent++;
+    has_last_sent = true;
+    last_sent = cmd.twist;
+    last_sent_time = now;
+}
+
+void MBotDriver::stop() {
+    // Send stop command before exiting
+    geometry::Twist2DStamped stop_cmd;
+    stop_cmd.twist.vx = 0.0;
+    stop_cmd.twist.vy = 0.0;
+    stop_cmd.twist.wz = 0.0;
+    mbot->drive(stop_cmd);
+    stats_.sent++;
 }
\ No newline at end of file
@@ -0,0 +1,175 @@
+#include "rix/bag/column_file.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+namespace rix {
+namespace bag {
+
+namespace {
+
+bool write_all(int fd, const void *data, size_t size) {
+    const char *bytes = static_cast<const char *>(data);
+    size_t written = 0;
+    while (written < size) {
+        ssize_t n = ::write(fd, bytes + written, size - written);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        written += n;
+    }
+    return true;
+}
+
+uint64_t align(uint64_t offset) {
+    return (offset + detail::COLUMN_ALIGNMENT - 1) / detail::COLUMN_ALIGNMENT * detail::COLUMN_ALIGNMENT;
+}
+
+}  // namespace
+
+size_t column_type_size(ColumnType type) {
+    switch (type) {
+        case ColumnType::INT64:
+        case ColumnType::FLOAT64:
+            return 8;
+        case ColumnType::UINT32:
+        case ColumnType::FLOAT32:
+            return 4;
+    }
+    return 0;
+}
+
+bool write_column_file(const std::string &path, const std::vector<Column> &columns) {
+    const size_t rows = columns.empty() ? 0 : columns.front().rows;
+    std::vector<detail::ColumnEntry> entries(columns.size());
+    uint64_t offset = sizeof(detail::ColumnFileHeader) + entries.size() * sizeof(detail::ColumnEntry);
+    for (size_t i = 0; i < columns.size(); i++) {
+        const Column &column = columns[i];
+        if (column.rows != rows || column.name.empty() || column.name.size() >= sizeof(entries[i].name) ||
+            column_type_size(column.type) == 0) {
+            return false;
+        }
+        std::memcpy(entries[i].name, column.name.data(), column.name.size());
+        entries[i].type = static_cast<uint32_t>(column.type);
+        offset = align(offset);
+        entries[i].offset = offset;
+        offset += rows * column_type_size(column.type);
+    }
+
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    detail::ColumnFileHeader header{};
+    std::memcpy(header.magic, detail::COLUMN_MAGIC, sizeof(header.magic));
+    header.version = detail::COLUMN_VERSION;
+    header.column_count = static_cast<uint32_t>(columns.size());
+    header.row_count = rows;
+    bool ok = write_all(fd, &header, sizeof(header)) &&
+              write_all(fd, entries.data(), entries.size() * sizeof(detail::ColumnEntry));
+    uint64_t written = sizeof(header) + entries.size() * sizeof(detail::ColumnEntry);
+    static const uint8_t padding[detail::COLUMN_ALIGNMENT] = {};
+    for (size_t i = 0; ok && i < columns.size(); i++) {
+        ok = write_all(fd, padding, entries[i].offset - written) &&
+             write_all(fd, columns[i].data, rows * column_type_size(columns[i].type));
+        written = entries[i].offset + rows * column_type_size(columns[i].type);
+    }
+    return ::close(fd) == 0 && ok;
+}
+
+ColumnFile::ColumnFile() : map_(nullptr), map_size_(0), rows_(0), columns_(0) {}
+
+ColumnFile::~ColumnFile() { close(); }
+
+bool ColumnFile::open(const std::string &path) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0 || static_cast<size_t>(st.st_size) < sizeof(detail::ColumnFileHeader)) {
+        ::close(fd);
+        return false;
+    }
+    map_size_ = static_cast<size_t>(st.st_size);
+    void *map = mmap(nullptr, map_size_, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);  // The mapping keeps the file open
+    if (map == MAP_FAILED) {
+        map_size_ = 0;
+        return false;
+    }
+    map_ = static_cast<const uint8_t *>(map);
+
+    detail::ColumnFileHeader header;
+    std::memcpy(&header, map_, sizeof(header));
+    if (std::memcmp(header.magic, detail::COLUMN_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != detail::COLUMN_VERSION ||
+        header.column_count > (map_size_ - sizeof(header)) / sizeof(detail::ColumnEntry)) {
+        close();
+        return false;
+    }
+    rows_ = header.row_count;
+    columns_ = header.column_count;
+
+    // Every column must be aligned and lie within the file
+    for (size_t i = 0; i < columns_; i++) {
+        detail::ColumnEntry column = entry(i);
+        size_t element = column_type_size(static_cast<ColumnType>(column.type));
+        if (element == 0 || column.offset % detail::COLUMN_ALIGNMENT != 0 || column.offset > map_size_ ||
+            rows_ > (map_size_ - column.offset) / element || column.name[sizeof(column.name) - 1] != '\0') {
+            close();
+            return false;
+        }
+    }
+    return true;
+}
+
+void ColumnFile::close() {
+    if (map_) {
+        munmap(const_cast<uint8_t *>(map_), map_size_);
+    }
+    map_ = nullptr;
+    map_size_ = 0;
+    rows_ = 0;
+    columns_ = 0;
+}
+
+bool ColumnFile::is_open() const { return map_ != nullptr; }
+
+size_t ColumnFile::rows() const { return rows_; }
+
+size_t ColumnFile::columns() const { return columns_; }
+
+std::string ColumnFile::name(size_t i) const { return i < columns_ ? std::string(entry(i).name) : std::string(); }
+
+ColumnType ColumnFile::type(size_t i) const {
+    return i < columns_ ? static_cast<ColumnType>(entry(i).type) : ColumnType::INT64;
+}
+
+const void *ColumnFile::find(const std::string &name, ColumnType type) const {
+    for (size_t i = 0; i < columns_; i++) {
+        detail::ColumnEntry column = entry(i);
+        if (column.type == static_cast<uint32_t>(type) && name == column.name) {
+            return map_ + column.offset;
+        }
+    }
+    return nullptr;
+}
+
+detail::ColumnEntry ColumnFile::entry(size_t i) const {
+    detail::ColumnEntry column;
+    std::memcpy(&column, map_ + sizeof(detail::ColumnFileHeader) + i * sizeof(detail::ColumnEntry), sizeof(column));
+    return column;
+}
+
+}  // namespace bag
+}  // namespace rix
@@ -0,0 +1,155 @@
+#include "rix/bag/columns.hpp"
+
+#include <algorithm>
+#include <numeric>
+
+namespace rix {
+namespace bag {
+
+namespace {
+
+template <typename T>
+void append_all(std::vector<T> &dst, const std::vector<T> &src) {
+    dst.insert(dst.end(), src.begin(), src.end());
+}
+
+template <typename T>
+void permute(std::vector<T> &values, const std::vector<size_t> &order) {
+    std::vector<T> sorted(values.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        sorted[i] = values[order[i]];
+    }
+    values.swap(sorted);
+}
+
+}  // namespace
+
+size_t Twist2DColumns::size() const { return stamp_ns.size(); }
+
+bool Twist2DColumns::empty() const { return stamp_ns.empty(); }
+
+void Twist2DColumns::reserve(size_t n) {
+    stamp_ns.reserve(n);
+    seq.reserve(n);
+    header_stamp_ns.reserve(n);
+    vx.reserve(n);
+    vy.reserve(n);
+    wz.reserve(n);
+}
+
+void Twist2DColumns::clear() {
+    stamp_ns.clear();
+    seq.clear();
+    header_stamp_ns.clear();
+    vx.clear();
+    vy.clear();
+    wz.clear();
+}
+
+void Twist2DColumns::push_back(const msg::geometry::Twist2DStamped &msg, const util::Time &stamp) {
+    stamp_ns.push_back(stamp.to_nanoseconds());
+    seq.push_back(msg.header.seq);
+    header_stamp_ns.push_back(util::Time(msg.header.stamp).to_nanoseconds());
+    vx.push_back(msg.twist.vx);
+    vy.push_back(msg.twist.vy);
+    wz.push_back(msg.twist.wz);
+}
+
+void Twist2DColumns::append(const Twist2DColumns &other) {
+    append_all(stamp_ns, other.stamp_ns);
+    append_all(seq, other.seq);
+    append_all(header_stamp_ns, other.header_stamp_ns);
+    append_all(vx, other.vx);
+    append_all(vy, other.vy);
+    append_all(wz, other.wz);
+}
+
+void Twist2DColumns::sort() {
+    auto before = [this](size_t a, size_t b) {
+        return stamp_ns[a] != stamp_ns[b] ? stamp_ns[a] < stamp_ns[b] : seq[a] < seq[b];
+    };
+    std::vector<size_t> order(size());
+    std::iota(order.begin(), order.end(), 0);
+    if (std::is_sorted(order.begin(), order.end(), before)) {
+        return;
+    }
+    std::stable_sort(order.begin(), order.end(), before);
+    permute(stamp_ns, order);
+    permute(seq, order);
+    permute(header_stamp_ns, order);
+    permute(vx, order);
+    permute(vy, order);
+    permute(wz, order);
+}
+
+Twist2DColumns Twist2DColumns::load(const Reader &reader, const util::Time &start, const util::Time &end) {
+    // Each worker fills its own columns; they are joined and put back in
+    // stamp order afterwards
+    std::vector<Twist2DColumns> parts(reader.workers());
+    reader.for_each<msg::geometry::Twist2DStamped>(
+        start, end, [&](const msg::geometry::Twist2DStamped &msg, const Record &record, size_t worker) {
+            parts[worker].push_back(msg, record.stamp);
+        });
+    Twist2DColumns columns;
+    size_t total = 0;
+    for (const auto &part : parts) {
+        total += part.size();
+    }
+    columns.reserve(total);
+    for (const auto &part : parts) {
+        columns.append(part);
+    }
+    columns.sort();
+    return columns;
+}
+
+std::vector<Column> Twist2DColumns::columns() const {
+    return {Column::of("stamp_ns", stamp_ns), Column::of("seq", seq), Column::of("header_stamp_ns", header_stamp_ns),
+            Column::of("vx", vx),             Column::of("vy", vy),   Column::of("wz", wz)};
+}
+
+bool Twist2DColumns::write(const std::string &path) const { return write_column_file(path, columns()); }
+
+Summary summarize(std::span<const float> values) {
+    Summary summary;
+    summary.count = values.size();
+    if (values.empty()) {
+        return summary;
+    }
+
+    constexpr size_t LANES = 8;
+    float lo[LANES], hi[LANES];
+    double sum[LANES] = {};
+    for (size_t l = 0; l < LANES; l++) {
+        lo[l] = hi[l] = values[0];
+    }
+    size_t i = 0;
+    for (; i + LANES <= values.size(); i += LANES) {
+        for (size_t l = 0; l < LANES; l++) {
+            float v = values[i + l];
+            lo[l] = v < lo[l] ? v : lo[l];
+            hi[l] = v > hi[l] ? v : hi[l];
+            sum[l] += v;
+        }
+    }
+    for (; i < values.size(); i++) {
+        float v = values[i];
+        lo[0] = v < lo[0] ? v : lo[0];
+        hi[0] = v > hi[0] ? v : hi[0];
+        sum[0] += v;
+    }
+
+    double total = 0.0;
+    summary.min = lo[0];
+    summary.max = hi[0];
+    for (size_t l = 0; l < LANES; l++) {
+        summary.min = std::min<double>(summary.min, lo[l]);
+        summary.max = std::max<double>(summary.max, hi[l]);
+        total += sum[l];
+    }
+    summary.mean = total / values.size();
+    return summary;
+}
+
+}  // namespace bag
+}  // namespace rix
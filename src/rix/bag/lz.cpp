@@ -0,0 +1,183 @@
+#include "rix/bag/lz.hpp"
+
+#include <cstring>
+
+namespace rix {
+namespace bag {
+namespace lz {
+
+namespace {
+
+constexpr size_t MIN_MATCH = 4;
+constexpr size_t MAX_OFFSET = 65535;
+constexpr int HASH_BITS = 12;
+
+uint32_t read32(const uint8_t *p) {
+    uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+uint32_t hash(uint32_t value) { return (value * 2654435761u) >> (32 - HASH_BITS); }
+
+/**
+ * @brief Appends to a fixed buffer, remembering whether anything overflowed.
+ */
+class Output {
+   public:
+    Output(uint8_t *dst, size_t capacity) : dst_(dst), capacity_(capacity), size_(0), ok_(true) {}
+
+    void byte(uint8_t value) {
+        if (size_ >= capacity_) {
+            ok_ = false;
+            return;
+        }
+        dst_[size_++] = value;
+    }
+
+    void bytes(const uint8_t *src, size_t n) {
+        if (capacity_ - size_ < n) {
+            ok_ = false;
+            return;
+        }
+        std::memcpy(dst_ + size_, src, n);
+        size_ += n;
+    }
+
+    /**
+     * @brief Writes the part of a length that did not fit in its nibble.
+     */
+    void length(size_t n) {
+        for (; n >= 255; n -= 255) {
+            byte(255);
+        }
+        byte(static_cast<uint8_t>(n));
+    }
+
+    size_t size() const { return ok_ ? size_ : 0; }
+
+   private:
+    uint8_t *dst_;
+    size_t capacity_;
+    size_t size_;
+    bool ok_;
+};
+
+void sequence(Output &out, const uint8_t *literals, size_t literal_count, size_t offset, size_t match_length) {
+    size_t match_code = match_length - MIN_MATCH;
+    out.byte(static_cast<uint8_t>((literal_count < 15 ? literal_count : 15) << 4 | (match_code < 15 ? match_code : 15)));
+    if (literal_count >= 15) {
+        out.length(literal_count - 15);
+    }
+    out.bytes(literals, literal_count);
+    out.byte(static_cast<uint8_t>(offset));
+    out.byte(static_cast<uint8_t>(offset >> 8));
+    if (match_code >= 15) {
+        out.length(match_code - 15);
+    }
+}
+
+void last_sequence(Output &out, const uint8_t *literals, size_t literal_count) {
+    out.byte(static_cast<uint8_t>((literal_count < 15 ? literal_count : 15) << 4));
+    if (literal_count >= 15) {
+        out.length(literal_count - 15);
+    }
+    out.bytes(literals, literal_count);
+}
+
+/**
+ * @brief Reads an extended length, returning false if the input ends first.
+ */
+bool read_length(const uint8_t *&ip, const uint8_t *end, size_t &n) {
+    uint8_t b;
+    do {
+        if (ip == end) {
+            return false;
+        }
+        b = *ip++;
+        n += b;
+    } while (b == 255);
+    return true;
+}
+
+}  // namespace
+
+size_t compress(const uint8_t *src, size_t size, uint8_t *dst, size_t capacity) {
+    Output out(dst, capacity);
+    uint32_t table[1 << HASH_BITS] = {};  // Last position seen for each hash
+
+    size_t anchor = 0;  // Start of the pending literals
+    size_t pos = 0;
+    while (size >= MIN_MATCH && pos <= size - MIN_MATCH) {
+        uint32_t window = read32(src + pos);
+        uint32_t &slot = table[hash(window)];
+        size_t candidate = slot;
+        slot = static_cast<uint32_t>(pos);
+        if (candidate >= pos || pos - candidate > MAX_OFFSET || read32(src + candidate) != window) {
+            // Step faster through data that does not compress
+            pos += 1 + ((pos - anchor) >> 6);
+            continue;
+        }
+        size_t length = MIN_MATCH;
+        while (pos + length < size && src[candidate + length] == src[pos + length]) {
+            length++;
+        }
+        sequence(out, src + anchor, pos - anchor, pos - candidate, length);
+        pos += length;
+        anchor = pos;
+    }
+    last_sequence(out, src + anchor, size - anchor);
+    return out.size();
+}
+
+bool decompress(const uint8_t *src, size_t size, uint8_t *dst, size_t raw_size) {
+    const uint8_t *ip = src;
+    const uint8_t *end = src + size;
+    size_t op = 0;
+    // Every block ends with a sequence of literals only
+    while (ip < end) {
+        uint8_t token = *ip++;
+        size_t literal_count = token >> 4;
+        if (literal_count == 15 && !read_length(ip, end, literal_count)) {
+            return false;
+        }
+        if (static_cast<size_t>(end - ip) < literal_count || raw_size - op < literal_count) {
+            return false;
+        }
+        std::memcpy(dst + op, ip, literal_count);
+        ip += literal_count;
+        op += literal_count;
+        if (ip == end) {
+            return op == raw_size;
+        }
+
+        if (end - ip < 2) {
+            return false;
+        }
+        size_t offset = ip[0] | static_cast<size_t>(ip[1]) << 8;
+        ip += 2;
+        size_t length = token & 0x0f;
+        if (length == 15 && !read_length(ip, end, length)) {
+            return false;
+        }
+        length += MIN_MATCH;
+        if (offset == 0 || offset > op || raw_size - op < length) {
+            return false;
+        }
+        const uint8_t *match = dst + op - offset;
+        if (offset >= length) {
+            std::memcpy(dst + op, match, length);
+        } else {
+            // The match overlaps the bytes it produces, e.g. a run
+            for (size_t i = 0; i < length; i++) {
+                dst[op + i] = match[i];
+            }
+        }
+        op += length;
+    }
+    return false;
+}
+
+}  // namespace lz
+}  // namespace bag
+}  // namespace rix
@@ -0,0 +1,577 @@
+#include "rix/bag/reader.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <thread>
+
+#include "rix/bag/lz.hpp"
+#include "rix/msg/delta_codec.hpp"
+#include "rix/msg/geometry/Twist2DStamped.hpp"
+
+namespace rix {
+namespace bag {
+
+namespace {
+
+// Structures in the file are not aligned, so they are always copied out
+template <typename T>
+T load(const uint8_t *src) {
+    T value;
+    std::memcpy(&value, src, sizeof(value));
+    return value;
+}
+
+/**
+ * @brief Restores the records of a DELTA_LZ chunk from their delta-encoded
+ * form, appending them to `out`. Fails as soon as `out` grows past `limit`.
+ */
+bool delta_decode(const uint8_t *records, size_t size, size_t limit, std::vector<uint8_t> &out) {
+    msg::DeltaDecoder decoder;
+    msg::geometry::Twist2DStamped cmd;
+    size_t pos = 0;
+    while (size - pos >= sizeof(detail::RecordHeader)) {
+        detail::RecordHeader header = load<detail::RecordHeader>(records + pos);
+        const uint8_t *data = records + pos + sizeof(header);
+        pos += sizeof(header);
+        if (header.size > size - pos) {
+            return false;
+        }
+        pos += header.size;
+
+        size_t header_at = out.size();
+        out.resize(header_at + sizeof(header));
+        if (header.flags & detail::RECORD_DELTA) {
+            size_t offset = 0;
+            if (!decoder.decode(data, header.size, offset, cmd) || offset != header.size) {
+                return false;
+            }
+            header.size = static_cast<uint32_t>(cmd.size());
+            header.flags = 0;
+            out.resize(out.size() + header.size);
+            offset = header_at + sizeof(header);
+            cmd.serialize(out.data(), offset);
+        } else {
+            out.insert(out.end(), data, data + header.size);
+        }
+        std::memcpy(out.data() + header_at, &header, sizeof(header));
+        if (out.size() > limit) {
+            return false;
+        }
+    }
+    return pos == size;
+}
+
+/**
+ * @brief Decompresses an LZ or DELTA_LZ chunk's records into `buffer`.
+ */
+bool decompress_into(const detail::ChunkHeader &header, const uint8_t *data, std::vector<uint8_t> &buffer) {
+    // An LZ block expands at most about 255 times; refuse sizes that could
+    // only come from a corrupt header
+    if (header.compression == static_cast<uint32_t>(Compression::LZ)) {
+        if (header.raw_size / 256 > header.stored_size) {
+            return false;
+        }
+        buffer.resize(header.raw_size);
+        return lz::decompress(data, header.stored_size, buffer.data(), buffer.size());
+    }
+    // Restoring a record can grow it without bound (a repeated frame id costs
+    // nothing in the delta form), so `raw_size` is only checked against what
+    // the records actually decode to, stopping as soon as they exceed it
+    if (header.encoded_size / 256 > header.stored_size) {
+        return false;
+    }
+    std::vector<uint8_t> encoded(header.encoded_size);
+    if (!lz::decompress(data, header.stored_size, encoded.data(), encoded.size())) {
+        return false;
+    }
+    buffer.clear();
+    return delta_decode(encoded.data(), encoded.size(), header.raw_size, buffer) && buffer.size() == header.raw_size;
+}
+
+}  // namespace
+
+bool Record::deserialize(msg::Message &msg) const {
+    if (!data || msg.hash() != hash) {
+        return false;
+    }
+    size_t offset = 0;
+    return msg.deserialize(data, size, offset);
+}
+
+Reader::Iterator::Iterator(const Reader *reader, size_t pos, size_t end, const Hash *type)
+    : reader_(reader), pos_(pos), end_(end), filter_(type != nullptr), type_(type ? *type : Hash{}) {
+    skip();
+}
+
+Record Reader::Iterator::operator*() const { return reader_->record(pos_); }
+
+Reader::Iterator &Reader::Iterator::operator++() {
+    pos_++;
+    skip();
+    return *this;
+}
+
+Reader::Iterator Reader::Iterator::operator++(int) {
+    Iterator it = *this;
+    ++*this;
+    return it;
+}
+
+void Reader::Iterator::skip() {
+    if (!filter_) {
+        return;
+    }
+    while (pos_ < end_) {
+        detail::IndexEntry entry = reader_->index_entry(pos_);
+        if (entry.hash[0] == type_[0] && entry.hash[1] == type_[1]) {
+            return;
+        }
+        pos_++;
+    }
+}
+
+Reader::Reader()
+    : fd_(-1),
+      map_(nullptr),
+      map_size_(0),
+      indexed_(false),
+      chunk_table_(nullptr),
+      chunk_count_(0),
+      index_(nullptr),
+      index_count_(0),
+      cache_clock_(0) {}
+
+Reader::~Reader() { close(); }
+
+bool Reader::open(const std::string &path, const Options &options) {
+    close();
+    options_ = options;
+    fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd_ < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd_, &st) < 0 || static_cast<size_t>(st.st_size) < sizeof(detail::FileHeader)) {
+        close();
+        return false;
+    }
+    map_size_ = static_cast<size_t>(st.st_size);
+    void *map = mmap(nullptr, map_size_, PROT_READ, MAP_SHARED, fd_, 0);
+    if (map == MAP_FAILED) {
+        close();
+        return false;
+    }
+    map_ = static_cast<const uint8_t *>(map);
+
+    detail::FileHeader header = load<detail::FileHeader>(map_);
+    if (std::memcmp(header.magic, detail::MAGIC, sizeof(header.magic)) != 0 || header.version != detail::VERSION) {
+        close();
+        return false;
+    }
+    indexed_ = read_index();
+    if (!indexed_ && !rebuild_index()) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool Reader::open(const std::string &path) { return open(path, Options()); }
+
+void Reader::close() {
+    // Finish any read-ahead before the mapping goes away
+    {
+        std::lock_guard<std::mutex> guard(pool_mtx_);
+        pool_.reset();
+    }
+    cache_.clear();
+    cache_clock_ = 0;
+    if (map_) {
+        munmap(const_cast<uint8_t *>(map_), map_size_);
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+    fd_ = -1;
+    map_ = nullptr;
+    map_size_ = 0;
+    indexed_ = false;
+    chunk_table_ = nullptr;
+    chunk_count_ = 0;
+    index_ = nullptr;
+    index_count_ = 0;
+    rebuilt_chunks_.clear();
+    rebuilt_index_.clear();
+}
+
+bool Reader::is_open() const { return map_ != nullptr; }
+
+bool Reader::indexed() const { return indexed_; }
+
+size_t Reader::size() const { return index_count_; }
+
+Record Reader::record(size_t i) const {
+    Record record;
+    if (i >= index_count_) {
+        return record;
+    }
+    detail::IndexEntry entry = index_entry(i);
+    record.stamp = util::Time(util::Time::Type(std::chrono::nanoseconds(entry.stamp_ns)));
+    record.hash = {entry.hash[0], entry.hash[1]};
+
+    size_t size;
+    Records owner;
+    const uint8_t *records = chunk_records(entry.chunk, size, owner);
+    if (!records || size < sizeof(detail::RecordHeader) || entry.offset > size - sizeof(detail::RecordHeader)) {
+        return record;
+    }
+    detail::RecordHeader header = load<detail::RecordHeader>(records + entry.offset);
+    size_t start = entry.offset + sizeof(detail::RecordHeader);
+    if (header.size > size - start) {
+        return record;
+    }
+    record.data = records + start;
+    record.size = header.size;
+    record.chunk = std::move(owner);
+    return record;
+}
+
+size_t Reader::lower_bound(const util::Time &time) const {
+    const int64_t ns = time.to_nanoseconds();
+    size_t lo = 0;
+    size_t hi = index_count_;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (index_entry(mid).stamp_ns < ns) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+util::Time Reader::start_time() const {
+    return index_count_ > 0 ? util::Time(util::Time::Type(std::chrono::nanoseconds(index_entry(0).stamp_ns)))
+                            : util::Time();
+}
+
+util::Time Reader::end_time() const {
+    return index_count_ > 0
+               ? util::Time(util::Time::Type(std::chrono::nanoseconds(index_entry(index_count_ - 1).stamp_ns)))
+               : util::Time();
+}
+
+Reader::Range Reader::range(const util::Time &start, const util::Time &end) const {
+    size_t first = lower_bound(start);
+    size_t last = std::max(first, lower_bound(end));
+    return Range(Iterator(this, first, last, nullptr), Iterator(this, last, last, nullptr));
+}
+
+Reader::Range Reader::range(const Hash &type, const util::Time &start, const util::Time &end) const {
+    size_t first = lower_bound(start);
+    size_t last = std::max(first, lower_bound(end));
+    return Range(Iterator(this, first, last, &type), Iterator(this, last, last, &type));
+}
+
+size_t Reader::chunks() const { return chunk_count_; }
+
+size_t Reader::workers() const {
+    if (options_.threads > 0) {
+        return options_.threads;
+    }
+    return std::max(std::thread::hardware_concurrency(), 1u);
+}
+
+size_t Reader::for_each(const Hash &type, const util::Time &start, const util::Time &end,
+                        const std::function<void(const Record &, size_t)> &fn) const {
+    const int64_t start_ns = start.to_nanoseconds();
+    const int64_t end_ns = end.to_nanoseconds();
+    std::vector<uint32_t> chunks;
+    for (uint32_t c = 0; c < chunk_count_; c++) {
+        detail::ChunkEntry entry = chunk_entry(c);
+        if (entry.end_ns >= start_ns && entry.start_ns < end_ns) {
+            chunks.push_back(c);
+        }
+    }
+
+    util::ThreadPool &threads = pool();
+    std::vector<std::vector<uint8_t>> buffers(threads.size());  // One per worker, reused across chunks
+    std::atomic<size_t> count(0);
+    threads.parallel_for(chunks.size(), [&](size_t i) {
+        const size_t worker = threads.worker();
+        size_t size;
+        const uint8_t *records = load_records(chunks[i], buffers[worker], size);
+        if (!records) {
+            return;
+        }
+        size_t visited = 0;
+        scan(records, size, chunk_entry(chunks[i]).count, [&](const detail::RecordHeader &header, size_t offset) {
+            if (header.hash[0] != type[0] || header.hash[1] != type[1] || header.stamp_ns < start_ns ||
+                header.stamp_ns >= end_ns) {
+                return;
+            }
+            Record record;
+            record.stamp = util::Time(util::Time::Type(std::chrono::nanoseconds(header.stamp_ns)));
+            record.hash = type;
+            record.data = records + offset + sizeof(detail::RecordHeader);
+            record.size = header.size;
+            fn(record, worker);
+            visited++;
+        });
+        count += visited;
+    });
+    return count;
+}
+
+detail::IndexEntry Reader::index_entry(size_t i) const {
+    return load<detail::IndexEntry>(index_ + i * sizeof(detail::IndexEntry));
+}
+
+detail::ChunkEntry Reader::chunk_entry(size_t i) const {
+    return load<detail::ChunkEntry>(chunk_table_ + i * sizeof(detail::ChunkEntry));
+}
+
+const uint8_t *Reader::chunk_data(uint32_t chunk, detail::ChunkHeader &header) const {
+    if (chunk >= chunk_count_) {
+        return nullptr;
+    }
+    uint64_t offset = chunk_entry(chunk).offset;
+    if (offset > map_size_ || map_size_ - offset < sizeof(detail::ChunkHeader)) {
+        return nullptr;
+    }
+    header = load<detail::ChunkHeader>(map_ + offset);
+    offset += sizeof(detail::ChunkHeader);
+    if (header.magic != detail::CHUNK_MAGIC || header.stored_size > map_size_ - offset) {
+        return nullptr;
+    }
+    return map_ + offset;
+}
+
+const uint8_t *Reader::chunk_records(uint32_t chunk, size_t &size, Records &owner) const {
+    detail::ChunkHeader header;
+    const uint8_t *data = chunk_data(chunk, header);
+    if (!data) {
+        return nullptr;
+    }
+    switch (static_cast<Compression>(header.compression)) {
+        case Compression::NONE:
+            size = header.stored_size;
+            return data;
+        case Compression::LZ:
+        case Compression::DELTA_LZ:
+            owner = cached_records(chunk);
+            if (!owner) {
+                return nullptr;
+            }
+            size = owner->size();
+            return owner->data();
+    }
+    return nullptr;
+}
+
+Reader::Records Reader::cached_records(uint32_t chunk) const {
+    std::promise<Records> promise;
+    std::shared_future<Records> records;
+    bool load = false;
+    {
+        std::lock_guard<std::mutex> guard(cache_mtx_);
+        auto it = cache_.find(chunk);
+        if (it == cache_.end()) {
+            records = promise.get_future().share();
+            cache_[chunk] = CacheEntry{records, ++cache_clock_, false};
+            load = true;
+            evict();
+            read_ahead(chunk);
+        } else {
+            records = it->second.records;
+            it->second.used = ++cache_clock_;
+            if (it->second.prefetched) {
+                it->second.prefetched = false;
+                read_ahead(chunk);
+            }
+        }
+    }
+    if (load) {
+        promise.set_value(decompress(chunk));
+    }
+    return records.get();
+}
+
+void Reader::read_ahead(uint32_t chunk) const {
+    // Never read so far ahead that the cache evicts the chunk in use
+    size_t ahead = std::min(options_.readahead, options_.cache_chunks > 0 ? options_.cache_chunks - 1 : 0);
+    if (ahead == 0) {
+        return;
+    }
+    for (uint64_t next = chunk + 1ull; next <= chunk + ahead && next < chunk_count_; next++) {
+        uint32_t c = static_cast<uint32_t>(next);
+        detail::ChunkHeader header;
+        if (cache_.count(c) > 0 || !chunk_data(c, header) ||
+            header.compression == static_cast<uint32_t>(Compression::NONE)) {
+            continue;
+        }
+        auto promise = std::make_shared<std::promise<Records>>();
+        cache_[c] = CacheEntry{promise->get_future().share(), ++cache_clock_, true};
+        pool().submit([this, c, promise] { promise->set_value(decompress(c)); });
+    }
+    evict();
+}
+
+void Reader::evict() const {
+    while (cache_.size() > std::max<size_t>(options_.cache_chunks, 1)) {
+        auto oldest = cache_.begin();
+        for (auto it = cache_.begin(); it != cache_.end(); ++it) {
+            if (it->second.used < oldest->second.used) {
+                oldest = it;
+            }
+        }
+        // Threads already holding the future keep its records alive
+        cache_.erase(oldest);
+    }
+}
+
+Reader::Records Reader::decompress(uint32_t chunk) const {
+    detail::ChunkHeader header;
+    const uint8_t *data = chunk_data(chunk, header);
+    auto records = std::make_shared<std::vector<uint8_t>>();
+    if (!data || !decompress_into(header, data, *records)) {
+        return nullptr;
+    }
+    return records;
+}
+
+const uint8_t *Reader::load_records(uint32_t chunk, std::vector<uint8_t> &buffer, size_t &size) const {
+    detail::ChunkHeader header;
+    const uint8_t *data = chunk_data(chunk, header);
+    if (!data) {
+        return nullptr;
+    }
+    switch (static_cast<Compression>(header.compression)) {
+        case Compression::NONE:
+            size = header.stored_size;
+            return data;
+        case Compression::LZ:
+        case Compression::DELTA_LZ:
+            if (!decompress_into(header, data, buffer)) {
+                return nullptr;
+            }
+            size = buffer.size();
+            return buffer.data();
+    }
+    return nullptr;
+}
+
+void Reader::scan(const uint8_t *records, size_t size, uint32_t count,
+                  const std::function<void(const detail::RecordHeader &, size_t)> &fn) {
+    size_t pos = 0;
+    for (uint32_t r = 0; r < count && size - pos >= sizeof(detail::RecordHeader); r++) {
+        detail::RecordHeader header = load<detail::RecordHeader>(records + pos);
+        if (header.size > size - pos - sizeof(detail::RecordHeader)) {
+            break;
+        }
+        fn(header, pos);
+        pos += sizeof(detail::RecordHeader) + header.size;
+    }
+}
+
+util::ThreadPool &Reader::pool() const {
+    std::lock_guard<std::mutex> guard(pool_mtx_);
+    if (!pool_) {
+        pool_ = std::make_unique<util::ThreadPool>(workers());
+    }
+    return *pool_;
+}
+
+bool Reader::read_index() {
+    if (map_size_ < sizeof(detail::FileHeader) + sizeof(detail::Footer)) {
+        return false;
+    }
+    const size_t footer_offset = map_size_ - sizeof(detail::Footer);
+    detail::Footer footer = load<detail::Footer>(map_ + footer_offset);
+    if (std::memcmp(footer.magic, detail::FOOTER_MAGIC, sizeof(footer.magic)) != 0) {
+        return false;
+    }
+    // The tables must lie between the header and the footer
+    auto valid = [&](uint64_t offset, uint64_t count, size_t entry_size) {
+        return offset >= sizeof(detail::FileHeader) && offset <= footer_offset &&
+               count <= (footer_offset - offset) / entry_size;
+    };
+    if (!valid(footer.chunk_table_offset, footer.chunk_count, sizeof(detail::ChunkEntry)) ||
+        !valid(footer.index_offset, footer.index_count, sizeof(detail::IndexEntry))) {
+        return false;
+    }
+    chunk_table_ = map_ + footer.chunk_table_offset;
+    chunk_count_ = footer.chunk_count;
+    index_ = map_ + footer.index_offset;
+    index_count_ = footer.index_count;
+    return true;
+}
+
+bool Reader::rebuild_index() {
+    rebuilt_chunks_.clear();
+    rebuilt_index_.clear();
+
+    // Keep every complete chunk; a torn one at the end is discarded
+    size_t offset = sizeof(detail::FileHeader);
+    while (map_size_ - offset >= sizeof(detail::ChunkHeader)) {
+        detail::ChunkHeader header = load<detail::ChunkHeader>(map_ + offset);
+        if (header.magic != detail::CHUNK_MAGIC ||
+            header.stored_size > map_size_ - offset - sizeof(detail::ChunkHeader)) {
+            break;
+        }
+        detail::ChunkEntry chunk{};
+        chunk.offset = offset;
+        chunk.start_ns = header.start_ns;
+        chunk.end_ns = header.end_ns;
+        chunk.count = header.count;
+        rebuilt_chunks_.push_back(chunk);
+        offset += sizeof(detail::ChunkHeader) + header.stored_size;
+    }
+    chunk_table_ = reinterpret_cast<const uint8_t *>(rebuilt_chunks_.data());
+    chunk_count_ = rebuilt_chunks_.size();
+
+    // Scan the chunks in parallel, then join their entries in chunk order so
+    // that the sort below keeps the write order of equal stamps
+    std::vector<std::vector<detail::IndexEntry>> entries(chunk_count_);
+    util::ThreadPool &threads = pool();
+    std::vector<std::vector<uint8_t>> buffers(threads.size());
+    threads.parallel_for(chunk_count_, [&](size_t c) {
+        size_t size;
+        const uint8_t *records = load_records(static_cast<uint32_t>(c), buffers[threads.worker()], size);
+        if (!records) {
+            return;
+        }
+        scan(records, size, rebuilt_chunks_[c].count, [&](const detail::RecordHeader &header, size_t offset) {
+            detail::IndexEntry entry{};
+            entry.stamp_ns = header.stamp_ns;
+            entry.hash[0] = header.hash[0];
+            entry.hash[1] = header.hash[1];
+            entry.chunk = static_cast<uint32_t>(c);
+            entry.offset = static_cast<uint32_t>(offset);
+            entries[c].push_back(entry);
+        });
+    });
+    size_t total = 0;
+    for (const auto &chunk : entries) {
+        total += chunk.size();
+    }
+    rebuilt_index_.reserve(total);
+    for (const auto &chunk : entries) {
+        rebuilt_index_.insert(rebuilt_index_.end(), chunk.begin(), chunk.end());
+    }
+    std::stable_sort(rebuilt_index_.begin(), rebuilt_index_.end(),
+                     [](const detail::IndexEntry &a, const detail::IndexEntry &b) { return a.stamp_ns < b.stamp_ns; });
+    index_ = reinterpret_cast<const uint8_t *>(rebuilt_index_.data());
+    index_count_ = rebuilt_index_.size();
+    return true;
+}
+
+}  // namespace bag
+}  // namespace rix
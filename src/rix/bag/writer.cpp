@@ -0,0 +1,335 @@
+#include "rix/bag/writer.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include "rix/bag/lz.hpp"
+#include "rix/msg/delta_codec.hpp"
+#include "rix/msg/geometry/Twist2DStamped.hpp"
+
+namespace rix {
+namespace bag {
+
+namespace {
+
+detail::ChunkHeader empty_chunk_header() {
+    detail::ChunkHeader header{};
+    header.magic = detail::CHUNK_MAGIC;
+    header.compression = static_cast<uint32_t>(Compression::NONE);
+    return header;
+}
+
+/**
+ * @brief Rewrites a chunk's records for DELTA_LZ: Twist2DStamped records are
+ * delta-encoded, everything else is copied.
+ */
+void delta_encode(const std::vector<uint8_t> &records, std::vector<uint8_t> &out) {
+    const Hash type = msg::geometry::Twist2DStamped().hash();
+    msg::DeltaEncoder encoder;
+    msg::geometry::Twist2DStamped cmd;
+    std::vector<uint8_t> check;
+    out.clear();
+    out.reserve(records.size());
+
+    size_t pos = 0;
+    while (records.size() - pos >= sizeof(detail::RecordHeader)) {
+        detail::RecordHeader header;
+        std::memcpy(&header, records.data() + pos, sizeof(header));
+        const uint8_t *data = records.data() + pos + sizeof(header);
+        pos += sizeof(header) + header.size;
+
+        // Only encode what serializes back to exactly the recorded bytes
+        size_t offset = 0;
+        bool encode = header.hash[0] == type[0] && header.hash[1] == type[1] &&
+                      cmd.deserialize(data, header.size, offset) && offset == header.size;
+        if (encode) {
+            check.resize(cmd.size());
+            offset = 0;
+            cmd.serialize(check.data(), offset);
+            encode = offset == header.size && std::memcmp(check.data(), data, header.size) == 0;
+        }
+
+        size_t header_at = out.size();
+        out.resize(header_at + sizeof(header));
+        if (encode) {
+            encoder.encode(cmd, out);
+            header.size = static_cast<uint32_t>(out.size() - header_at - sizeof(header));
+            header.flags = detail::RECORD_DELTA;
+        } else {
+            out.insert(out.end(), data, data + header.size);
+        }
+        std::memcpy(out.data() + header_at, &header, sizeof(header));
+    }
+}
+
+}  // namespace
+
+Writer::Writer()
+    : fd_(-1), ok_(false), chunk_header_(empty_chunk_header()), chunk_count_(0), pending_bytes_(0), offset_(0) {}
+
+Writer::~Writer() { close(); }
+
+bool Writer::open(const std::string &path, const Options &options) {
+    close();
+    fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        return false;
+    }
+    options_ = options;
+    ok_ = true;
+    offset_ = 0;
+    chunk_.clear();
+    chunk_header_ = empty_chunk_header();
+    chunk_count_ = 0;
+    chunks_.clear();
+    index_.clear();
+    pending_bytes_ = 0;
+    if (options_.threads > 0) {
+        pool_ = std::make_unique<util::ThreadPool>(options_.threads);
+    }
+
+    detail::FileHeader header{};
+    std::memcpy(header.magic, detail::MAGIC, sizeof(header.magic));
+    header.version = detail::VERSION;
+    return write_all(&header, sizeof(header));
+}
+
+bool Writer::open(const std::string &path) { return open(path, Options()); }
+
+bool Writer::close() {
+    if (fd_ < 0) {
+        return false;
+    }
+    flush();
+    pool_.reset();
+
+    // Sort by stamp, keeping the write order of equal stamps
+    std::stable_sort(index_.begin(), index_.end(),
+                     [](const detail::IndexEntry &a, const detail::IndexEntry &b) { return a.stamp_ns < b.stamp_ns; });
+
+    detail::Footer footer{};
+    footer.chunk_table_offset = offset_;
+    footer.chunk_count = chunks_.size();
+    write_all(chunks_.data(), chunks_.size() * sizeof(detail::ChunkEntry));
+    footer.index_offset = offset_;
+    footer.index_count = index_.size();
+    write_all(index_.data(), index_.size() * sizeof(detail::IndexEntry));
+    std::memcpy(footer.magic, detail::FOOTER_MAGIC, sizeof(footer.magic));
+    write_all(&footer, sizeof(footer));
+
+    bool ok = ok_ && ::close(fd_) == 0;
+    fd_ = -1;
+    ok_ = false;
+    return ok;
+}
+
+bool Writer::is_open() const { return fd_ >= 0; }
+
+bool Writer::write(const msg::Message &msg, const util::Time &stamp) {
+    if (fd_ < 0) {
+        return false;
+    }
+    // Serialize straight into the chunk
+    uint8_t *data = append(msg.hash(), msg.size(), stamp);
+    size_t offset = 0;
+    msg.serialize(data, offset);
+    return end_record();
+}
+
+bool Writer::write(const Hash &hash, const uint8_t *data, size_t size, const util::Time &stamp) {
+    if (fd_ < 0) {
+        return false;
+    }
+    std::memcpy(append(hash, size, stamp), data, size);
+    return end_record();
+}
+
+uint8_t *Writer::append(const Hash &hash, size_t size, const util::Time &stamp) {
+    detail::RecordHeader record{};
+    record.stamp_ns = stamp.to_nanoseconds();
+    record.hash[0] = hash[0];
+    record.hash[1] = hash[1];
+    record.size = static_cast<uint32_t>(size);
+
+    detail::IndexEntry entry{};
+    entry.stamp_ns = record.stamp_ns;
+    entry.hash[0] = hash[0];
+    entry.hash[1] = hash[1];
+    entry.chunk = chunk_count_;
+    entry.offset = static_cast<uint32_t>(chunk_.size());
+    index_.push_back(entry);
+
+    if (chunk_header_.count == 0 || record.stamp_ns < chunk_header_.start_ns) {
+        chunk_header_.start_ns = record.stamp_ns;
+    }
+    if (chunk_header_.count == 0 || record.stamp_ns > chunk_header_.end_ns) {
+        chunk_header_.end_ns = record.stamp_ns;
+    }
+    chunk_header_.count++;
+
+    size_t start = chunk_.size();
+    chunk_.resize(start + sizeof(record) + size);
+    std::memcpy(chunk_.data() + start, &record, sizeof(record));
+    return chunk_.data() + start + sizeof(record);
+}
+
+bool Writer::end_record() {
+    if (chunk_.size() >= options_.chunk_size) {
+        submit_chunk();
+    }
+    return ok_;
+}
+
+bool Writer::flush() {
+    if (fd_ < 0) {
+        return false;
+    }
+    submit_chunk();
+    if (pool_) {
+        pool_->wait();
+    }
+    return ok_;
+}
+
+void Writer::submit_chunk() {
+    if (chunk_header_.count == 0) {
+        return;
+    }
+    auto job = std::make_shared<Job>();
+    job->header = chunk_header_;
+    job->records.swap(chunk_);
+    chunk_.reserve(options_.chunk_size);
+    chunk_header_ = empty_chunk_header();
+    chunk_count_++;
+
+    if (!pool_) {
+        compress(*job);
+        std::lock_guard<std::mutex> io_guard(io_mtx_);
+        write_chunk(*job);
+        return;
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(mtx_);
+        cv_.wait(lock, [this] { return pending_.empty() || pending_bytes_ < options_.max_pending; });
+        pending_bytes_ += job->records.size();
+        pending_.push_back(job);
+    }
+    pool_->submit([this, job] {
+        compress(*job);
+        {
+            std::lock_guard<std::mutex> guard(mtx_);
+            job->done = true;
+        }
+        write_ready();
+    });
+}
+
+void Writer::compress(Job &job) const {
+    job.header.raw_size = job.records.size();
+    job.header.stored_size = job.records.size();
+    if (options_.compression == Compression::NONE) {
+        return;
+    }
+    std::vector<uint8_t> encoded;
+    const std::vector<uint8_t> *input = &job.records;
+    if (options_.compression == Compression::DELTA_LZ) {
+        delta_encode(job.records, encoded);
+        input = &encoded;
+    }
+    job.stored.resize(lz::compress_bound(input->size()));
+    size_t size = lz::compress(input->data(), input->size(), job.stored.data(), job.stored.size());
+    if (size == 0 || size >= job.records.size()) {
+        job.stored.clear();
+        return;
+    }
+    job.stored.resize(size);
+    job.header.compression = static_cast<uint32_t>(options_.compression);
+    job.header.stored_size = size;
+    if (options_.compression == Compression::DELTA_LZ) {
+        job.header.encoded_size = static_cast<uint32_t>(encoded.size());
+    }
+}
+
+void Writer::write_ready() {
+    // Only the holder of `io_mtx_` pops, so chunks reach the file in order
+    std::lock_guard<std::mutex> io_guard(io_mtx_);
+    while (true) {
+        std::shared_ptr<Job> job;
+        {
+            std::lock_guard<std::mutex> guard(mtx_);
+            if (pending_.empty() || !pending_.front()->done) {
+                return;
+            }
+            job = std::move(pending_.front());
+            pending_.pop_front();
+        }
+        write_chunk(*job);
+        {
+            std::lock_guard<std::mutex> guard(mtx_);
+            pending_bytes_ -= job->records.size();
+        }
+        cv_.notify_one();
+    }
+}
+
+void Writer::write_chunk(const Job &job) {
+    detail::ChunkEntry entry{};
+    entry.offset = offset_;
+    entry.start_ns = job.header.start_ns;
+    entry.end_ns = job.header.end_ns;
+    entry.count = job.header.count;
+    chunks_.push_back(entry);
+
+    // Header and records go out in one call rather than as two writes
+    const std::vector<uint8_t> &body =
+        job.header.compression == static_cast<uint32_t>(Compression::NONE) ? job.records : job.stored;
+    struct iovec iov[2];
+    iov[0].iov_base = const_cast<detail::ChunkHeader *>(&job.header);
+    iov[0].iov_len = sizeof(job.header);
+    iov[1].iov_base = const_cast<uint8_t *>(body.data());
+    iov[1].iov_len = body.size();
+    write_all(iov, 2);
+}
+
+uint64_t Writer::count() const { return index_.size(); }
+
+bool Writer::write_all(const void *data, size_t size) {
+    struct iovec iov;
+    iov.iov_base = const_cast<void *>(data);
+    iov.iov_len = size;
+    return write_all(&iov, 1);
+}
+
+bool Writer::write_all(struct iovec *iov, int count) {
+    while (count > 0) {
+        ssize_t n = ::writev(fd_, iov, count);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            ok_ = false;
+            return false;
+        }
+        offset_ += n;
+        // Skip what was written and continue a short write where it stopped
+        size_t written = n;
+        while (count > 0 && written >= iov->iov_len) {
+            written -= iov->iov_len;
+            iov++;
+            count--;
+        }
+        if (count > 0) {
+            iov->iov_base = static_cast<char *>(iov->iov_base) + written;
+            iov->iov_len -= written;
+        }
+    }
+    return true;
+}
+
+}  // namespace bag
+}  // namespace rix
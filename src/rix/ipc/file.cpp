@@ -2,6 +2,10 @@
 #include <fcntl.h>
 #include <unistd.h>
 
+#include <algorithm>
+
+#include "rix/util/clock.hpp"
+
 /*
 The File class should implement the IO interface using a file descriptor and system calls.
 You must implement the member functions of the File class in this file.
@@ -125,24 +129,51 @@ bool File::is_nonblocking() const {
     return false;
 }
 
+namespace {
+
+// Converts a duration to a ppoll() timeout without losing sub-millisecond
+// precision. Negative durations do not wait.
+struct timespec to_timespec(const util::Duration &duration) {
+    int64_t ns = std::max<int64_t>(duration.to_nanoseconds(), 0);
+    struct timespec ts;
+    ts.tv_sec = static_cast<time_t>(ns / 1'000'000'000);
+    ts.tv_nsec = static_cast<long>(ns % 1'000'000'000);
+    return ts;
+}
+
+// Polls `fd` for `events` and returns the events that occurred, or 0 on
+// timeout or error. On the simulated clock the timeout elapses in simulated
+// time: the wait ends when the simulation reaches the deadline.
+short poll_for(int fd, short events, const util::Duration &duration) {
+    struct pollfd pfds[2];
+    pfds[0].fd = fd;
+    pfds[0].events = events;
+    pfds[0].revents = 0;
+
+    if (duration > util::Duration(0.0) && util::SimulatedClock::running()) {
+        util::SimulatedClock::Alarm alarm(util::Time::now() + std::min(duration, util::Duration::safe_forever()));
+        if (alarm.fd() >= 0) {
+            pfds[1].fd = alarm.fd();
+            pfds[1].events = POLLIN;
+            pfds[1].revents = 0;
+            int result = ::ppoll(pfds, 2, nullptr, nullptr);
+            return result > 0 ? pfds[0].revents : 0;
+        }
+    }
+
+    // ppoll() returns > 0 if event occurred, 0 if timeout, -1 on error
+    struct timespec timeout = to_timespec(duration);
+    int result = ::ppoll(pfds, 1, &timeout, nullptr);
+    return result > 0 ? pfds[0].revents : 0;
+}
+
+}  // namespace
+
 // Waits the specified duration for the file to become writable
 // Return true if the file has become writable within the duration
 bool File::wait_for_writable(const util::Duration &duration) const {
     if (fd_ >= 0) { // only if file is valid
-        struct pollfd pfd;
-        pfd.fd = fd_;
-        pfd.events = POLLOUT; // wait for writeability
-        pfd.revents = 0;
-
-        // Convert duration to milliseconds
-        int timeout_ms = duration.to_milliseconds();
-
-        int result = ::poll(&pfd, 1, timeout_ms);
-
-        // poll() returns > 0 if event occurred, 0 if timeout, -1 on error
-        if (result > 0 && pfd.revents & POLLOUT) {
-            return true;
-        }
+        return poll_for(fd_, POLLOUT, duration) & POLLOUT;
     }
     return false;
 }
@@ -152,20 +183,8 @@ bool File::wait_for_writable(const util::Duration &duration) const {
 // Return true if the file has become readable within the duration
 bool File::wait_for_readable(const util::Duration &duration) const {
     if (fd_ >= 0) { // only if file is valid
-        struct pollfd pfd;
-        pfd.fd = fd_;
-        pfd.events = POLLIN; // wait for readability
-        pfd.revents = 0;
-
-        // Convert duration to milliseconds
-        int timeout_ms = duration.to_milliseconds();
-
-        int result = ::poll(&pfd, 1, timeout_ms);
-
-        // poll() returns > 0 if event occurred, 0 if timeout, -1 on error
-        if (result > 0 && pfd.revents & POLLIN) {
-            return true;
-        }
+        // A hang-up also counts: read() will return 0 without blocking.
+        return poll_for(fd_, POLLIN, duration) & (POLLIN | POLLHUP);
     }
     return false;
 }
@@ -0,0 +1,266 @@
+#include "rix/msg/delta_codec.hpp"
+
+#include <cstring>
+
+namespace rix {
+namespace msg {
+
+namespace {
+
+enum Flags : uint8_t {
+    SEQ = 1 << 0,
+    RAW_STAMP = 1 << 1,
+    FRAME_MASK = 3 << 2,
+    FRAME_SAME = 0 << 2,
+    FRAME_REF = 1 << 2,
+    FRAME_NEW = 2 << 2,
+    FRAME_LITERAL = 3 << 2,  ///< A new string that is not added to the dictionary
+    VX = 1 << 4,
+    VY = 1 << 5,
+    WZ = 1 << 6,
+};
+
+constexpr int64_t NS_PER_SEC = 1000000000;
+constexpr uint32_t NO_FRAME = UINT32_MAX;  ///< The frame id before the first message
+
+uint64_t zigzag(int64_t value) { return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63); }
+
+int64_t unzigzag(uint64_t value) { return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1); }
+
+void put_varint(std::vector<uint8_t> &out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value) | 0x80);
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+bool get_varint(const uint8_t *src, size_t size, size_t &offset, uint64_t &value) {
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (offset >= size) {
+            return false;
+        }
+        uint8_t byte = src[offset++];
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int64_t wrapping_sub(int64_t a, int64_t b) {
+    return static_cast<int64_t>(static_cast<uint64_t>(a) - static_cast<uint64_t>(b));
+}
+
+int64_t wrapping_add(int64_t a, int64_t b) {
+    return static_cast<int64_t>(static_cast<uint64_t>(a) + static_cast<uint64_t>(b));
+}
+
+bool same_bits(float a, float b) { return std::memcmp(&a, &b, sizeof(float)) == 0; }
+
+void put_float(std::vector<uint8_t> &out, float value) {
+    uint8_t bytes[sizeof(float)];
+    std::memcpy(bytes, &value, sizeof(float));
+    out.insert(out.end(), bytes, bytes + sizeof(float));
+}
+
+bool get_float(const uint8_t *src, size_t size, size_t &offset, float &value) {
+    if (offset > size || size - offset < sizeof(float)) {
+        return false;
+    }
+    std::memcpy(&value, src + offset, sizeof(float));
+    offset += sizeof(float);
+    return true;
+}
+
+bool get_frame_id(const uint8_t *src, size_t size, size_t &offset, FrameId &value) {
+    uint64_t len;
+    if (!get_varint(src, size, offset, len) || len > size - offset) {
+        return false;
+    }
+    value = FrameId(std::string_view(reinterpret_cast<const char *>(src + offset), len));
+    offset += len;
+    return true;
+}
+
+}  // namespace
+
+DeltaEncoder::DeltaEncoder() { reset(); }
+
+void DeltaEncoder::reset() {
+    seq_ = UINT32_MAX;  // So that a first seq of 0 is the expected one
+    stamp_ns_ = 0;
+    delta_ns_ = 0;
+    frame_ = NO_FRAME;
+    frames_.clear();
+    twist_ = geometry::Twist2D();
+}
+
+void DeltaEncoder::encode(const geometry::Twist2DStamped &msg, std::vector<uint8_t> &out) {
+    const size_t flags_at = out.size();
+    out.push_back(0);
+    uint8_t flags = 0;
+
+    int32_t seq_delta = static_cast<int32_t>(msg.header.seq - seq_ - 1);
+    if (seq_delta != 0) {
+        flags |= SEQ;
+        put_varint(out, zigzag(seq_delta));
+    }
+    seq_ = msg.header.seq;
+
+    const auto &stamp = msg.header.stamp;
+    if (stamp.nsec < 0 || stamp.nsec >= NS_PER_SEC) {
+        flags |= RAW_STAMP;
+        put_varint(out, zigzag(stamp.sec));
+        put_varint(out, zigzag(stamp.nsec));
+        stamp_ns_ = 0;
+        delta_ns_ = 0;
+    } else {
+        int64_t ns = stamp.sec * NS_PER_SEC + stamp.nsec;
+        int64_t delta = ns - stamp_ns_;
+        put_varint(out, zigzag(wrapping_sub(delta, delta_ns_)));
+        stamp_ns_ = ns;
+        delta_ns_ = delta;
+    }
+
+    auto it = frames_.find(msg.header.frame_id);
+    if (it != frames_.end()) {
+        if (it->second != frame_) {
+            flags |= FRAME_REF;
+            put_varint(out, it->second);
+            frame_ = it->second;
+        }
+    } else {
+        bool add = frames_.size() < MAX_FRAME_IDS;
+        flags |= add ? FRAME_NEW : FRAME_LITERAL;
+        std::string_view frame_id = msg.header.frame_id.view();
+        put_varint(out, frame_id.size());
+        out.insert(out.end(), frame_id.begin(), frame_id.end());
+        if (add) {
+            frame_ = static_cast<uint32_t>(frames_.size());
+            frames_.emplace(msg.header.frame_id, frame_);
+        } else {
+            frame_ = NO_FRAME;
+        }
+    }
+
+    if (!same_bits(msg.twist.vx, twist_.vx)) {
+        flags |= VX;
+        put_float(out, msg.twist.vx);
+    }
+    if (!same_bits(msg.twist.vy, twist_.vy)) {
+        flags |= VY;
+        put_float(out, msg.twist.vy);
+    }
+    if (!same_bits(msg.twist.wz, twist_.wz)) {
+        flags |= WZ;
+        put_float(out, msg.twist.wz);
+    }
+    twist_ = msg.twist;
+    out[flags_at] = flags;
+}
+
+DeltaDecoder::DeltaDecoder() { reset(); }
+
+void DeltaDecoder::reset() {
+    seq_ = UINT32_MAX;
+    stamp_ns_ = 0;
+    delta_ns_ = 0;
+    frame_ = NO_FRAME;
+    frames_.clear();
+    twist_ = geometry::Twist2D();
+}
+
+bool DeltaDecoder::decode(const uint8_t *src, size_t size, size_t &offset, geometry::Twist2DStamped &msg) {
+    if (offset >= size) {
+        return false;
+    }
+    const uint8_t flags = src[offset++];
+    uint64_t value;
+
+    int32_t seq_delta = 0;
+    if (flags & SEQ) {
+        if (!get_varint(src, size, offset, value)) {
+            return false;
+        }
+        seq_delta = static_cast<int32_t>(unzigzag(value));
+    }
+    seq_ = seq_ + 1 + static_cast<uint32_t>(seq_delta);
+    msg.header.seq = seq_;
+
+    if (flags & RAW_STAMP) {
+        uint64_t sec, nsec;
+        if (!get_varint(src, size, offset, sec) || !get_varint(src, size, offset, nsec)) {
+            return false;
+        }
+        msg.header.stamp.sec = static_cast<int32_t>(unzigzag(sec));
+        msg.header.stamp.nsec = static_cast<int32_t>(unzigzag(nsec));
+        stamp_ns_ = 0;
+        delta_ns_ = 0;
+    } else {
+        if (!get_varint(src, size, offset, value)) {
+            return false;
+        }
+        // Wrapping, so that corrupt input cannot overflow
+        delta_ns_ = wrapping_add(delta_ns_, unzigzag(value));
+        stamp_ns_ = wrapping_add(stamp_ns_, delta_ns_);
+        int64_t sec = stamp_ns_ / NS_PER_SEC;
+        int64_t nsec = stamp_ns_ % NS_PER_SEC;
+        if (nsec < 0) {
+            sec--;
+            nsec += NS_PER_SEC;
+        }
+        msg.header.stamp.sec = static_cast<int32_t>(sec);
+        msg.header.stamp.nsec = static_cast<int32_t>(nsec);
+    }
+
+    switch (flags & FRAME_MASK) {
+        case FRAME_SAME:
+            if (frame_ >= frames_.size()) {
+                return false;
+            }
+            msg.header.frame_id = frames_[frame_];
+            break;
+        case FRAME_REF:
+            if (!get_varint(src, size, offset, value) || value >= frames_.size()) {
+                return false;
+            }
+            frame_ = static_cast<uint32_t>(value);
+            msg.header.frame_id = frames_[frame_];
+            break;
+        case FRAME_NEW: {
+            FrameId frame_id;
+            if (!get_frame_id(src, size, offset, frame_id) || frames_.size() >= DeltaEncoder::MAX_FRAME_IDS) {
+                return false;
+            }
+            frame_ = static_cast<uint32_t>(frames_.size());
+            frames_.push_back(frame_id);
+            msg.header.frame_id = std::move(frame_id);
+            break;
+        }
+        case FRAME_LITERAL: {
+            FrameId frame_id;
+            if (!get_frame_id(src, size, offset, frame_id)) {
+                return false;
+            }
+            frame_ = NO_FRAME;
+            msg.header.frame_id = std::move(frame_id);
+            break;
+        }
+    }
+
+    if (((flags & VX) && !get_float(src, size, offset, twist_.vx)) ||
+        ((flags & VY) && !get_float(src, size, offset, twist_.vy)) ||
+        ((flags & WZ) && !get_float(src, size, offset, twist_.wz))) {
+        return false;
+    }
+    msg.twist.vx = twist_.vx;
+    msg.twist.vy = twist_.vy;
+    msg.twist.wz = twist_.wz;
+    return true;
+}
+
+}  // namespace msg
+}  // namespace rix
@@ -0,0 +1,124 @@
+#include "rix/msg/frame_id.hpp"
+
+#include <atomic>
+#include <ostream>
+
+namespace rix {
+namespace msg {
+
+namespace {
+
+using Entry = detail::FrameIdEntry;
+
+// At most half full, so probe sequences stay short and always end at an
+// empty slot
+constexpr size_t SLOTS = 2 * FrameId::MAX_INTERNED;
+static_assert((SLOTS & (SLOTS - 1)) == 0, "SLOTS must be a power of two");
+
+// Slots are only ever filled, never cleared or replaced, so an entry once
+// found stays valid and lookups need no locks
+std::atomic<const Entry *> slots[SLOTS];
+std::atomic<size_t> count{0};
+
+uint64_t fnv1a(std::string_view str) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (char c : str) {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+const Entry *empty_entry() {
+    static const Entry empty{fnv1a(""), std::string(), true};
+    return &empty;
+}
+
+const Entry *copy(const Entry *entry) { return entry->interned ? entry : new Entry(*entry); }
+
+void release(const Entry *entry) {
+    if (!entry->interned) {
+        delete entry;
+    }
+}
+
+}  // namespace
+
+const Entry *FrameId::intern(std::string_view str) {
+    if (str.empty()) {
+        return empty_entry();
+    }
+    const uint64_t hash = fnv1a(str);
+    if (str.size() > MAX_INTERNED_SIZE) {
+        return new Entry{hash, std::string(str), false};
+    }
+
+    Entry *created = nullptr;
+    size_t i = hash & (SLOTS - 1);
+    for (size_t probes = 0; probes < SLOTS; probes++, i = (i + 1) & (SLOTS - 1)) {
+        const Entry *entry = slots[i].load(std::memory_order_acquire);
+        if (!entry) {
+            // Not in the table: claim room for it, then the slot
+            if (!created) {
+                if (count.fetch_add(1, std::memory_order_relaxed) >= MAX_INTERNED) {
+                    count.fetch_sub(1, std::memory_order_relaxed);
+                    break;
+                }
+                created = new Entry{hash, std::string(str), true};
+            }
+            if (slots[i].compare_exchange_strong(entry, created, std::memory_order_acq_rel,
+                                                 std::memory_order_acquire)) {
+                return created;
+            }
+            // Another thread filled the slot first; `entry` is now its entry
+        }
+        if (entry->hash == hash && entry->str == str) {
+            if (created) {
+                delete created;
+                count.fetch_sub(1, std::memory_order_relaxed);
+            }
+            return entry;
+        }
+    }
+
+    if (created) {
+        delete created;
+        count.fetch_sub(1, std::memory_order_relaxed);
+    }
+    return new Entry{hash, std::string(str), false};
+}
+
+size_t FrameId::interned_count() { return count.load(std::memory_order_relaxed); }
+
+FrameId::FrameId() : entry_(empty_entry()) {}
+
+FrameId::FrameId(std::string_view str) : entry_(intern(str)) {}
+
+FrameId::FrameId(const FrameId &other) : entry_(copy(other.entry_)) {}
+
+FrameId::FrameId(FrameId &&other) noexcept : entry_(other.entry_) { other.entry_ = empty_entry(); }
+
+FrameId &FrameId::operator=(const FrameId &other) {
+    if (entry_ != other.entry_) {
+        const Entry *entry = copy(other.entry_);
+        release(entry_);
+        entry_ = entry;
+    }
+    return *this;
+}
+
+FrameId &FrameId::operator=(FrameId &&other) noexcept {
+    if (this != &other) {
+        release(entry_);
+        entry_ = other.entry_;
+        other.entry_ = empty_entry();
+    }
+    return *this;
+}
+
+FrameId::~FrameId() { release(entry_); }
+
+std::ostream &operator<<(std::ostream &os, const FrameId &id) { return os << id.view(); }
+
+}  // namespace msg
+}  // namespace rix
@@ -0,0 +1,131 @@
+#include "rix/msg/quantize.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+namespace rix {
+namespace msg {
+
+namespace {
+
+// Batches of messages are quantized in blocks: each field is gathered into
+// its own array so that the batch `Quantizer` loops see contiguous floats
+constexpr size_t BLOCK = 64;
+
+void put_code(uint8_t *dst, size_t &offset, uint16_t code) {
+    std::memcpy(dst + offset, &code, sizeof(code));
+    offset += sizeof(code);
+}
+
+uint16_t get_code(const uint8_t *src, size_t &offset) {
+    uint16_t code;
+    std::memcpy(&code, src + offset, sizeof(code));
+    offset += sizeof(code);
+    return code;
+}
+
+}  // namespace
+
+Quantizer::Quantizer(float min, float max, float resolution) {
+    if (!(resolution > 0.0f) || !(max > min) || !std::isfinite(min) || !std::isfinite(max)) {
+        throw std::invalid_argument("Quantizer needs a positive resolution and min < max.");
+    }
+    // Tolerate the float error in ranges that are meant to be whole steps; a
+    // value past the last step by less than that is clamped to it, which is
+    // still well within half a step
+    double exact = (static_cast<double>(max) - min) / resolution;
+    double steps = std::ceil(exact * (1.0 - 1e-6));
+    if (steps > UINT16_MAX) {
+        throw std::invalid_argument("Quantizer range needs more than 16 bits at this resolution.");
+    }
+    min_ = min;
+    resolution_ = resolution;
+    scale_ = 1.0f / resolution;
+    steps_ = static_cast<float>(steps);
+    zero_ = clamp_one(0.0f);
+}
+
+void Quantizer::encode(const float *src, size_t n, uint16_t *dst) const {
+    // Two passes, since a select on a NaN comparison keeps GCC from
+    // vectorizing the clamp
+    for (size_t i = 0; i < n; i++) {
+        dst[i] = clamp_one(src[i]);
+    }
+    const uint16_t zero = zero_;
+    for (size_t i = 0; i < n; i++) {
+        dst[i] = is_nan(src[i]) ? zero : dst[i];
+    }
+}
+
+void Quantizer::decode(const uint16_t *src, size_t n, float *dst) const {
+    const float min = min_, resolution = resolution_;
+    for (size_t i = 0; i < n; i++) {
+        dst[i] = min + static_cast<float>(src[i]) * resolution;
+    }
+}
+
+void Twist2DQuantization::serialize(const geometry::Twist2D &src, uint8_t *dst, size_t &offset) const {
+    put_code(dst, offset, linear.encode(src.vx));
+    put_code(dst, offset, linear.encode(src.vy));
+    put_code(dst, offset, angular.encode(src.wz));
+}
+
+bool Twist2DQuantization::deserialize(geometry::Twist2D &dst, const uint8_t *src, size_t size,
+                                      size_t &offset) const {
+    if (offset > size || size - offset < SIZE) {
+        return false;
+    }
+    dst.vx = linear.decode(get_code(src, offset));
+    dst.vy = linear.decode(get_code(src, offset));
+    dst.wz = angular.decode(get_code(src, offset));
+    return true;
+}
+
+void Twist2DQuantization::serialize(const geometry::Twist2D *src, size_t n, uint8_t *dst) const {
+    float vx[BLOCK], vy[BLOCK], wz[BLOCK];
+    uint16_t cvx[BLOCK], cvy[BLOCK], cwz[BLOCK];
+    size_t offset = 0;
+    for (size_t start = 0; start < n; start += BLOCK) {
+        const size_t count = std::min(BLOCK, n - start);
+        for (size_t i = 0; i < count; i++) {
+            vx[i] = src[start + i].vx;
+            vy[i] = src[start + i].vy;
+            wz[i] = src[start + i].wz;
+        }
+        linear.encode(vx, count, cvx);
+        linear.encode(vy, count, cvy);
+        angular.encode(wz, count, cwz);
+        for (size_t i = 0; i < count; i++) {
+            put_code(dst, offset, cvx[i]);
+            put_code(dst, offset, cvy[i]);
+            put_code(dst, offset, cwz[i]);
+        }
+    }
+}
+
+void Twist2DQuantization::deserialize(const uint8_t *src, size_t n, geometry::Twist2D *dst) const {
+    uint16_t cvx[BLOCK], cvy[BLOCK], cwz[BLOCK];
+    float vx[BLOCK], vy[BLOCK], wz[BLOCK];
+    size_t offset = 0;
+    for (size_t start = 0; start < n; start += BLOCK) {
+        const size_t count = std::min(BLOCK, n - start);
+        for (size_t i = 0; i < count; i++) {
+            cvx[i] = get_code(src, offset);
+            cvy[i] = get_code(src, offset);
+            cwz[i] = get_code(src, offset);
+        }
+        linear.decode(cvx, count, vx);
+        linear.decode(cvy, count, vy);
+        angular.decode(cwz, count, wz);
+        for (size_t i = 0; i < count; i++) {
+            dst[start + i].vx = vx[i];
+            dst[start + i].vy = vy[i];
+            dst[start + i].wz = wz[i];
+        }
+    }
+}
+
+}  // namespace msg
+}  // namespace rix
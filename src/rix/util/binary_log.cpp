@@ -0,0 +1,315 @@
+#include "rix/util/binary_log.hpp"
+
+#include <pwd.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <sstream>
+
+namespace rix {
+namespace util {
+
+std::mutex BinaryLog::mutex_;
+std::vector<BinaryLog::Entry> BinaryLog::sites_;
+std::string BinaryLog::dictionary_;
+std::filebuf BinaryLog::file_;
+// Defined after `file_` so that it is destroyed, and drained, first
+detail::AsyncLogWriter BinaryLog::writer_(&BinaryLog::finish);
+
+namespace {
+
+template <typename T>
+void append(std::string &out, const T &val) {
+    out.append(reinterpret_cast<const char *>(&val), sizeof(val));
+}
+
+void append_string(std::string &out, const std::string &str) {
+    append(out, static_cast<uint16_t>(str.size()));
+    out.append(str);
+}
+
+}  // namespace
+
+bool BinaryLog::init(const std::string &name) {
+    const char *homeDir;
+    if ((homeDir = getenv("HOME")) == NULL) {
+        homeDir = getpwuid(getuid())->pw_dir;
+    }
+    std::string dirName = std::string(homeDir) + "/.rix/log/";
+    struct stat st;
+    for (const std::string &dir : {std::string(homeDir) + "/.rix/", dirName}) {
+        if (stat(dir.c_str(), &st) < 0 && mkdir(dir.c_str(), S_IRWXU) < 0) {
+            return false;
+        }
+    }
+    return open(dirName + name + "_" + std::to_string(Time::now().to_nanoseconds()) + ".rixlog", name);
+}
+
+bool BinaryLog::open(const std::string &path, const std::string &name) {
+    close();
+    if (!file_.open(path, std::ios::out | std::ios::binary | std::ios::trunc)) {
+        return false;
+    }
+
+    std::string header(MAGIC, sizeof(MAGIC));
+    append_string(header, name);
+    file_.sputn(header.data(), header.size());
+
+    {
+        // A new file needs every site seen so far
+        std::lock_guard<std::mutex> guard(mutex_);
+        dictionary_.clear();
+        for (uint32_t id = 0; id < sites_.size(); id++) {
+            append_dictionary_entry(dictionary_, id);
+        }
+    }
+    writer_.start(&file_);
+    return true;
+}
+
+void BinaryLog::close() {
+    writer_.stop();
+    if (file_.is_open()) {
+        file_.close();
+    }
+}
+
+void BinaryLog::flush() {
+    if (writer_.running()) {
+        writer_.flush();
+    }
+}
+
+bool BinaryLog::is_open() { return writer_.running(); }
+
+uint32_t BinaryLog::register_site(const BinaryLogSite &site, const detail::BinaryArgType *types, size_t n) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    uint32_t id = static_cast<uint32_t>(sites_.size());
+    sites_.push_back(Entry{site, std::vector<detail::BinaryArgType>(types, types + n)});
+    append_dictionary_entry(dictionary_, id);
+    return id;
+}
+
+void BinaryLog::finish(std::string &batch, uint64_t dropped) {
+    // The batch was drained before the dictionary is read, so every site it
+    // refers to has already been registered and is either in an earlier
+    // batch or in `dictionary_`.
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        if (!dictionary_.empty()) {
+            batch.insert(0, dictionary_);
+            dictionary_.clear();
+        }
+    }
+    if (dropped > 0) {
+        batch.push_back(DROPPED);
+        append(batch, dropped);
+    }
+}
+
+void BinaryLog::append_dictionary_entry(std::string &out, uint32_t id) {
+    const Entry &entry = sites_[id];
+    out.push_back(DICTIONARY);
+    append(out, id);
+    append(out, static_cast<uint8_t>(entry.site.level));
+    append(out, static_cast<uint32_t>(entry.site.line));
+    append_string(out, entry.site.file);
+    append_string(out, entry.site.format);
+    append(out, static_cast<uint8_t>(entry.types.size()));
+    for (auto type : entry.types) {
+        append(out, static_cast<uint8_t>(type));
+    }
+}
+
+bool BinaryLogReader::open(const std::string &path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        return false;
+    }
+    std::stringstream ss;
+    ss << in.rdbuf();
+    data_ = ss.str();
+    pos_ = 0;
+    entries_.clear();
+
+    char magic[sizeof(BinaryLog::MAGIC)];
+    uint16_t name_len;
+    if (!read(magic, sizeof(magic)) || std::memcmp(magic, BinaryLog::MAGIC, sizeof(magic)) != 0 ||
+        !read(&name_len, sizeof(name_len)) || !read_string(name_, name_len)) {
+        return false;
+    }
+    return true;
+}
+
+const std::string &BinaryLogReader::name() const { return name_; }
+
+bool BinaryLogReader::next(BinaryLogRecord &record) {
+    char kind;
+    while (read(&kind, sizeof(kind))) {
+        switch (kind) {
+            case BinaryLog::DICTIONARY:
+                if (!read_dictionary_entry()) {
+                    return false;
+                }
+                break;
+            case BinaryLog::RECORD:
+                return read_record(record);
+            case BinaryLog::DROPPED: {
+                uint64_t dropped;
+                if (!read(&dropped, sizeof(dropped))) {
+                    return false;
+                }
+                record.stamp = last_stamp_;
+                record.level = Log::Level::WARN;
+                record.file.clear();
+                record.line = 0;
+                record.message = "[rix::util::Log] " + std::to_string(dropped) + " records dropped";
+                return true;
+            }
+            default:
+                return false;
+        }
+    }
+    return false;
+}
+
+bool BinaryLogReader::read(void *dst, size_t n) {
+    if (data_.size() - pos_ < n) {
+        return false;
+    }
+    std::memcpy(dst, data_.data() + pos_, n);
+    pos_ += n;
+    return true;
+}
+
+bool BinaryLogReader::read_string(std::string &dst, size_t n) {
+    if (data_.size() - pos_ < n) {
+        return false;
+    }
+    dst.assign(data_, pos_, n);
+    pos_ += n;
+    return true;
+}
+
+bool BinaryLogReader::read_dictionary_entry() {
+    uint32_t id, line;
+    uint8_t level, nargs;
+    uint16_t len;
+    Entry entry;
+    if (!read(&id, sizeof(id)) || !read(&level, sizeof(level)) || !read(&line, sizeof(line)) ||
+        !read(&len, sizeof(len)) || !read_string(entry.file, len) || !read(&len, sizeof(len)) ||
+        !read_string(entry.format, len) || !read(&nargs, sizeof(nargs))) {
+        return false;
+    }
+    entry.types.resize(nargs);
+    if (!read(entry.types.data(), nargs)) {
+        return false;
+    }
+    entry.valid = true;
+    entry.level = static_cast<Log::Level>(level);
+    entry.line = static_cast<int>(line);
+    if (id >= entries_.size()) {
+        entries_.resize(id + 1);
+    }
+    entries_[id] = std::move(entry);
+    return true;
+}
+
+namespace {
+
+/**
+ * @brief Reads one argument of type T and prints it as type P.
+ */
+template <typename T, typename P = T>
+bool format_arg(std::ostream &os, const std::string &data, size_t &pos) {
+    T val;
+    if (data.size() - pos < sizeof(val)) {
+        return false;
+    }
+    std::memcpy(&val, data.data() + pos, sizeof(val));
+    pos += sizeof(val);
+    os << static_cast<P>(val);
+    return true;
+}
+
+bool format_string_arg(std::ostream &os, const std::string &data, size_t &pos) {
+    uint32_t len;
+    if (data.size() - pos < sizeof(len)) {
+        return false;
+    }
+    std::memcpy(&len, data.data() + pos, sizeof(len));
+    pos += sizeof(len);
+    if (data.size() - pos < len) {
+        return false;
+    }
+    os.write(data.data() + pos, len);
+    pos += len;
+    return true;
+}
+
+bool format_arg(std::ostream &os, detail::BinaryArgType type, const std::string &data, size_t &pos) {
+    using detail::BinaryArgType;
+    switch (type) {
+        case BinaryArgType::BOOL:
+            return format_arg<bool>(os, data, pos);
+        case BinaryArgType::CHAR:
+            return format_arg<char>(os, data, pos);
+        case BinaryArgType::INT8:
+            return format_arg<int8_t, int>(os, data, pos);
+        case BinaryArgType::UINT8:
+            return format_arg<uint8_t, unsigned>(os, data, pos);
+        case BinaryArgType::INT16:
+            return format_arg<int16_t>(os, data, pos);
+        case BinaryArgType::UINT16:
+            return format_arg<uint16_t>(os, data, pos);
+        case BinaryArgType::INT32:
+            return format_arg<int32_t>(os, data, pos);
+        case BinaryArgType::UINT32:
+            return format_arg<uint32_t>(os, data, pos);
+        case BinaryArgType::INT64:
+            return format_arg<int64_t>(os, data, pos);
+        case BinaryArgType::UINT64:
+            return format_arg<uint64_t>(os, data, pos);
+        case BinaryArgType::FLOAT:
+            return format_arg<float>(os, data, pos);
+        case BinaryArgType::DOUBLE:
+            return format_arg<double>(os, data, pos);
+        case BinaryArgType::STRING:
+            return format_string_arg(os, data, pos);
+    }
+    return false;
+}
+
+}  // namespace
+
+bool BinaryLogReader::read_record(BinaryLogRecord &record) {
+    uint32_t id;
+    int64_t ns;
+    if (!read(&id, sizeof(id)) || !read(&ns, sizeof(ns)) || id >= entries_.size() || !entries_[id].valid) {
+        return false;
+    }
+    const Entry &entry = entries_[id];
+    record.stamp = Time(Time::Type(std::chrono::nanoseconds(ns)));
+    record.level = entry.level;
+    record.file = entry.file;
+    record.line = entry.line;
+    last_stamp_ = record.stamp;
+
+    std::ostringstream os;
+    size_t arg = 0;
+    for (const char *fmt = entry.format.c_str(); *fmt != '\0'; fmt++) {
+        if (fmt[0] == '{' && fmt[1] == '}' && arg < entry.types.size()) {
+            if (!format_arg(os, entry.types[arg++], data_, pos_)) {
+                return false;
+            }
+            fmt++;
+        } else {
+            os << *fmt;
+        }
+    }
+    record.message = os.str();
+    return true;
+}
+
+}  // namespace util
+}  // namespace rix
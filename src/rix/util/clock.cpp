@@ -0,0 +1,538 @@
+#include "rix/util/clock.hpp"
+
+#include <sys/eventfd.h>
+#include <time.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace rix {
+namespace util {
+
+namespace {
+
+constexpr int SHIFT = 32;
+constexpr int64_t STEP_NS = 1'000'000;  ///< Re-anchoring errors ahead by more than this are applied at once
+constexpr double MAX_SLEW = 500e-6;     ///< Maximum rate correction while slewing
+
+int64_t read_clock(clockid_t id) {
+    struct timespec ts;
+    clock_gettime(id, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1'000'000'000 + ts.tv_nsec;
+}
+
+inline uint64_t read_tsc() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#elif defined(__aarch64__)
+    uint64_t value;
+    asm volatile("isb; mrs %0, cntvct_el0" : "=r"(value));
+    return value;
+#else
+    return 0;
+#endif
+}
+
+bool tsc_invariant() {
+#if defined(__x86_64__) || defined(__i386__)
+    // Without both flags the counter rate changes with frequency scaling or
+    // stops in deep sleep states
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    std::string line;
+    while (std::getline(cpuinfo, line)) {
+        if (line.starts_with("flags")) {
+            return line.find(" constant_tsc") != std::string::npos && line.find(" nonstop_tsc") != std::string::npos;
+        }
+    }
+    return false;
+#elif defined(__aarch64__)
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief Maps a counter to nanoseconds since the epoch:
+ *
+ *     ns = base_ns + ((ticks - base_ticks) * mult) >> SHIFT
+ *
+ * The parameters are published through a sequence lock, so reading the clock
+ * never blocks. Whichever thread first reads the clock after `next_ticks`
+ * re-anchors it.
+ */
+class AnchoredClock {
+   public:
+    explicit AnchoredClock(ClockSource source) : source_(source) {}
+
+    void reset(int64_t interval_ns);
+    int64_t now();
+
+   private:
+    uint64_t ticks() const;
+
+    /**
+     * @brief Reads the counter and a system clock together.
+     *
+     * @return The system clock, with `ticks` set to the matching counter.
+     */
+    int64_t sample(clockid_t id, uint64_t &ticks) const;
+
+    int64_t estimate(uint64_t ticks) const;
+    void publish(uint64_t base_ticks, int64_t base_ns, uint64_t mult, uint64_t next_ticks);
+    void reanchor();
+
+    const ClockSource source_;
+
+    std::atomic<uint32_t> seq_{0};
+    std::atomic<uint64_t> base_ticks_{0};
+    std::atomic<int64_t> base_ns_{0};
+    std::atomic<uint64_t> mult_{uint64_t(1) << SHIFT};
+    std::atomic<uint64_t> next_ticks_{UINT64_MAX};
+
+    std::atomic_flag busy_ = ATOMIC_FLAG_INIT;  ///< Held while re-anchoring
+    // Only touched while holding `busy_`
+    int64_t interval_ns_ = 0;
+    uint64_t interval_ticks_ = 0;
+    uint64_t cal_ticks_ = 0;  ///< Counter at calibration
+    int64_t cal_raw_ns_ = 0;  ///< CLOCK_MONOTONIC_RAW at calibration
+    double ns_per_tick_ = 1.0;
+};
+
+/**
+ * @brief Added to every realtime sample taken by the anchored clocks. Set by
+ * `detail::offset_realtime`.
+ */
+std::atomic<int64_t> realtime_offset_ns{0};
+
+uint64_t AnchoredClock::ticks() const {
+    switch (source_) {
+        case ClockSource::MONOTONIC:
+            return static_cast<uint64_t>(read_clock(CLOCK_MONOTONIC));
+        case ClockSource::MONOTONIC_RAW:
+            return static_cast<uint64_t>(read_clock(CLOCK_MONOTONIC_RAW));
+        case ClockSource::TSC:
+            return read_tsc();
+        default:
+            return 0;
+    }
+}
+
+int64_t AnchoredClock::sample(clockid_t id, uint64_t &ticks) const {
+    // Keep the tightest of a few brackets around the realtime read
+    uint64_t best_width = UINT64_MAX;
+    int64_t best_ns = 0;
+    for (int i = 0; i < 5; i++) {
+        uint64_t before = this->ticks();
+        int64_t ns = read_clock(id);
+        if (id == CLOCK_REALTIME) {
+            ns += realtime_offset_ns.load(std::memory_order_relaxed);
+        }
+        uint64_t after = this->ticks();
+        if (after - before < best_width) {
+            best_width = after - before;
+            best_ns = ns;
+            ticks = before + (after - before) / 2;
+        }
+    }
+    return best_ns;
+}
+
+int64_t AnchoredClock::estimate(uint64_t ticks) const {
+    int64_t dt = static_cast<int64_t>(ticks - base_ticks_.load(std::memory_order_relaxed));
+    __int128 delta = static_cast<__int128>(dt) * mult_.load(std::memory_order_relaxed);
+    return base_ns_.load(std::memory_order_relaxed) + static_cast<int64_t>(delta >> SHIFT);
+}
+
+void AnchoredClock::publish(uint64_t base_ticks, int64_t base_ns, uint64_t mult, uint64_t next_ticks) {
+    uint32_t seq = seq_.load(std::memory_order_relaxed);
+    seq_.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    base_ticks_.store(base_ticks, std::memory_order_relaxed);
+    base_ns_.store(base_ns, std::memory_order_relaxed);
+    mult_.store(mult, std::memory_order_relaxed);
+    next_ticks_.store(next_ticks, std::memory_order_relaxed);
+    seq_.store(seq + 2, std::memory_order_release);
+}
+
+void AnchoredClock::reset(int64_t interval_ns) {
+    while (busy_.test_and_set(std::memory_order_acquire)) {
+        std::this_thread::yield();
+    }
+
+    ns_per_tick_ = 1.0;
+    cal_raw_ns_ = sample(CLOCK_MONOTONIC_RAW, cal_ticks_);
+    if (source_ == ClockSource::TSC) {
+        // Initial rate from a short interval; re-anchoring refines it over
+        // an ever longer baseline
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        uint64_t t;
+        int64_t raw = sample(CLOCK_MONOTONIC_RAW, t);
+        ns_per_tick_ = static_cast<double>(raw - cal_raw_ns_) / static_cast<double>(t - cal_ticks_);
+    }
+    interval_ns_ = interval_ns;
+    interval_ticks_ = interval_ns > 0 ? static_cast<uint64_t>(interval_ns / ns_per_tick_) : 0;
+
+    uint64_t t;
+    int64_t ns = sample(CLOCK_REALTIME, t);
+    uint64_t mult = static_cast<uint64_t>(std::llround(std::ldexp(ns_per_tick_, SHIFT)));
+    publish(t, ns, mult, interval_ticks_ > 0 ? t + interval_ticks_ : UINT64_MAX);
+
+    busy_.clear(std::memory_order_release);
+}
+
+void AnchoredClock::reanchor() {
+    uint64_t t;
+    int64_t realtime = sample(CLOCK_REALTIME, t);
+    int64_t estimated = estimate(t);
+    int64_t error = realtime - estimated;
+
+    if (source_ == ClockSource::TSC) {
+        uint64_t now;
+        int64_t raw = sample(CLOCK_MONOTONIC_RAW, now);
+        ns_per_tick_ = static_cast<double>(raw - cal_raw_ns_) / static_cast<double>(now - cal_ticks_);
+    }
+
+    if (error > STEP_NS) {
+        // The system time was stepped forward; follow it
+        uint64_t mult = static_cast<uint64_t>(std::llround(std::ldexp(ns_per_tick_, SHIFT)));
+        publish(t, realtime, mult, t + interval_ticks_);
+        return;
+    }
+
+    // Continue from the current estimate, running slightly fast or slow so
+    // that the error is gone by the next re-anchor. A step of the system time
+    // back is slewed out too, at most MAX_SLEW, so the clock never goes back
+    double slew = std::clamp(static_cast<double>(error) / static_cast<double>(interval_ns_), -MAX_SLEW, MAX_SLEW);
+    uint64_t mult = static_cast<uint64_t>(std::llround(std::ldexp(ns_per_tick_ * (1.0 + slew), SHIFT)));
+    publish(t, estimated, mult, t + interval_ticks_);
+}
+
+int64_t AnchoredClock::now() {
+    uint64_t t = ticks();
+    int64_t ns;
+    uint64_t next;
+    uint32_t seq;
+    do {
+        seq = seq_.load(std::memory_order_acquire);
+        ns = estimate(t);
+        next = next_ticks_.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } while ((seq & 1) != 0 || seq != seq_.load(std::memory_order_relaxed));
+
+    if (t >= next && !busy_.test_and_set(std::memory_order_acquire)) {
+        if (t >= next_ticks_.load(std::memory_order_relaxed)) {
+            reanchor();
+        }
+        busy_.clear(std::memory_order_release);
+    }
+    return ns;
+}
+
+AnchoredClock monotonic_clock(ClockSource::MONOTONIC);
+AnchoredClock monotonic_raw_clock(ClockSource::MONOTONIC_RAW);
+AnchoredClock tsc_clock(ClockSource::TSC);
+
+std::atomic<ClockSource> current_source{ClockSource::SYSTEM};
+std::mutex select_mutex;
+
+/**
+ * @brief State of the SIMULATED source. `now_ns` is written under `mutex` but
+ * read without it by `Time::now`.
+ */
+struct Simulation {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::atomic<int64_t> now_ns{0};
+    std::multimap<int64_t, int> waiters;  ///< Deadline -> eventfd to signal, or -1 for threads waiting on `cv`
+    ClockSource previous = ClockSource::SYSTEM;
+
+    bool running() const { return current_source.load(std::memory_order_acquire) == ClockSource::SIMULATED; }
+
+    /**
+     * @brief Wakes every waiter whose deadline is at or before `ns`. Only
+     * called with `mutex` held.
+     */
+    void wake(int64_t ns) {
+        for (auto it = waiters.begin(); it != waiters.end() && it->first <= ns; ++it) {
+            if (it->second >= 0) {
+                uint64_t one = 1;
+                ssize_t written = ::write(it->second, &one, sizeof(one));
+                (void)written;
+            }
+        }
+        cv.notify_all();
+    }
+};
+
+Simulation simulation;
+
+/**
+ * @brief The eventfd each thread polls while it holds a SimulatedClock::Alarm.
+ */
+struct AlarmFd {
+    int fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    ~AlarmFd() {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+};
+
+thread_local AlarmFd alarm_fd;
+
+AnchoredClock *anchored(ClockSource source) {
+    switch (source) {
+        case ClockSource::MONOTONIC:
+            return &monotonic_clock;
+        case ClockSource::MONOTONIC_RAW:
+            return &monotonic_raw_clock;
+        case ClockSource::TSC:
+            return &tsc_clock;
+        default:
+            return nullptr;
+    }
+}
+
+/**
+ * @brief Applies RIX_UTIL_CLOCK_SOURCE, or the RIX_CLOCK_SOURCE environment
+ * variable if it names a source, before main runs.
+ */
+bool select_default_source() {
+    ClockSource source = ClockSource::RIX_UTIL_CLOCK_SOURCE;
+    if (const char *env = std::getenv("RIX_CLOCK_SOURCE")) {
+        for (ClockSource s : {ClockSource::SYSTEM, ClockSource::MONOTONIC, ClockSource::MONOTONIC_RAW,
+                              ClockSource::REALTIME_COARSE, ClockSource::TSC}) {
+            if (std::strcmp(env, clock_source_name(s)) == 0) {
+                source = s;
+            }
+        }
+    }
+    return source == ClockSource::SYSTEM || set_clock_source(source);
+}
+
+const bool default_source_selected = select_default_source();
+
+}  // namespace
+
+bool set_clock_source(ClockSource source, const Duration &reanchor_interval) {
+    if (!clock_source_available(source)) {
+        return false;
+    }
+    std::lock_guard<std::mutex> guard(select_mutex);
+    ClockSource previous = current_source.load(std::memory_order_relaxed);
+    if (source == ClockSource::SIMULATED) {
+        if (previous != ClockSource::SIMULATED) {
+            std::lock_guard<std::mutex> sim_guard(simulation.mutex);
+            simulation.now_ns.store(detail::clock_now_ns(), std::memory_order_release);
+            simulation.previous = previous;
+        }
+    } else if (AnchoredClock *clock = anchored(source)) {
+        clock->reset(std::max<int64_t>(reanchor_interval.to_nanoseconds(), 0));
+    }
+    current_source.store(source, std::memory_order_release);
+
+    if (previous == ClockSource::SIMULATED && source != ClockSource::SIMULATED) {
+        std::lock_guard<std::mutex> sim_guard(simulation.mutex);
+        simulation.wake(INT64_MAX);
+    }
+    return true;
+}
+
+ClockSource clock_source() { return current_source.load(std::memory_order_relaxed); }
+
+bool clock_source_available(ClockSource source) {
+    switch (source) {
+        case ClockSource::SYSTEM:
+        case ClockSource::MONOTONIC:
+        case ClockSource::MONOTONIC_RAW:
+        case ClockSource::REALTIME_COARSE:
+        case ClockSource::SIMULATED:
+            return true;
+        case ClockSource::TSC: {
+            static const bool invariant = tsc_invariant();
+            return invariant;
+        }
+    }
+    return false;
+}
+
+const char *clock_source_name(ClockSource source) {
+    switch (source) {
+        case ClockSource::SYSTEM:
+            return "SYSTEM";
+        case ClockSource::MONOTONIC:
+            return "MONOTONIC";
+        case ClockSource::MONOTONIC_RAW:
+            return "MONOTONIC_RAW";
+        case ClockSource::REALTIME_COARSE:
+            return "REALTIME_COARSE";
+        case ClockSource::TSC:
+            return "TSC";
+        case ClockSource::SIMULATED:
+            return "SIMULATED";
+    }
+    return "";
+}
+
+void SimulatedClock::start(const Time &time) {
+    set_clock_source(ClockSource::SIMULATED);
+    std::lock_guard<std::mutex> guard(simulation.mutex);
+    simulation.now_ns.store(time.to_nanoseconds(), std::memory_order_release);
+    simulation.wake(time.to_nanoseconds());
+}
+
+void SimulatedClock::stop() {
+    ClockSource previous;
+    {
+        std::lock_guard<std::mutex> guard(simulation.mutex);
+        previous = simulation.previous;
+    }
+    if (running()) {
+        set_clock_source(previous);
+    }
+}
+
+bool SimulatedClock::running() { return simulation.running(); }
+
+void SimulatedClock::set(const Time &time) {
+    std::lock_guard<std::mutex> guard(simulation.mutex);
+    int64_t ns = time.to_nanoseconds();
+    if (ns > simulation.now_ns.load(std::memory_order_relaxed)) {
+        simulation.now_ns.store(ns, std::memory_order_release);
+        simulation.wake(ns);
+    }
+}
+
+void SimulatedClock::advance(const Duration &duration) {
+    std::lock_guard<std::mutex> guard(simulation.mutex);
+    int64_t ns = simulation.now_ns.load(std::memory_order_relaxed) + std::max<int64_t>(duration.to_nanoseconds(), 0);
+    simulation.now_ns.store(ns, std::memory_order_release);
+    simulation.wake(ns);
+}
+
+bool SimulatedClock::step() {
+    std::lock_guard<std::mutex> guard(simulation.mutex);
+    if (simulation.waiters.empty()) {
+        return false;
+    }
+    int64_t ns = std::max(simulation.waiters.begin()->first, simulation.now_ns.load(std::memory_order_relaxed));
+    simulation.now_ns.store(ns, std::memory_order_release);
+    simulation.wake(ns);
+    return true;
+}
+
+size_t SimulatedClock::waiting() {
+    std::lock_guard<std::mutex> guard(simulation.mutex);
+    return simulation.waiters.size();
+}
+
+bool SimulatedClock::wait_until(const Time &deadline) {
+    if (!simulation.running()) {
+        return false;
+    }
+    std::unique_lock<std::mutex> lock(simulation.mutex);
+    if (!simulation.running()) {
+        return false;
+    }
+    int64_t ns = deadline.to_nanoseconds();
+    auto it = simulation.waiters.emplace(ns, -1);
+    simulation.cv.wait(lock, [ns] {
+        return !simulation.running() || simulation.now_ns.load(std::memory_order_relaxed) >= ns;
+    });
+    simulation.waiters.erase(it);
+    return true;
+}
+
+SimulatedClock::Alarm::Alarm(const Time &deadline) : deadline_(deadline.to_nanoseconds()), fd_(-1) {
+    if (!simulation.running() || alarm_fd.fd < 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> guard(simulation.mutex);
+    if (!simulation.running()) {
+        return;
+    }
+    fd_ = alarm_fd.fd;
+    simulation.waiters.emplace(deadline_, fd_);
+    if (simulation.now_ns.load(std::memory_order_relaxed) >= deadline_) {
+        simulation.wake(deadline_);
+    }
+}
+
+SimulatedClock::Alarm::~Alarm() {
+    if (fd_ < 0) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> guard(simulation.mutex);
+        auto range = simulation.waiters.equal_range(deadline_);
+        for (auto it = range.first; it != range.second; ++it) {
+            if (it->second == fd_) {
+                simulation.waiters.erase(it);
+                break;
+            }
+        }
+    }
+    // Leave the descriptor unreadable for the thread's next alarm
+    uint64_t count;
+    ssize_t n = ::read(fd_, &count, sizeof(count));
+    (void)n;
+}
+
+int SimulatedClock::Alarm::fd() const { return fd_; }
+
+namespace detail {
+
+void offset_realtime(const Duration &offset) {
+    realtime_offset_ns.store(offset.to_nanoseconds(), std::memory_order_relaxed);
+}
+
+bool clock_is_realtime() {
+    ClockSource source = current_source.load(std::memory_order_acquire);
+    return source == ClockSource::SYSTEM || source == ClockSource::REALTIME_COARSE;
+}
+
+std::chrono::steady_clock::time_point steady_deadline(const Time &deadline) {
+    auto now = std::chrono::steady_clock::now();
+    Duration remaining = std::clamp(deadline - Time::now(), Duration(0.0), Duration::safe_forever());
+    return now + std::chrono::duration_cast<std::chrono::steady_clock::duration>(remaining.get());
+}
+
+int64_t clock_now_ns() {
+    switch (current_source.load(std::memory_order_acquire)) {
+        case ClockSource::MONOTONIC:
+            return monotonic_clock.now();
+        case ClockSource::MONOTONIC_RAW:
+            return monotonic_raw_clock.now();
+        case ClockSource::REALTIME_COARSE:
+            return read_clock(CLOCK_REALTIME_COARSE);
+        case ClockSource::TSC:
+            return tsc_clock.now();
+        case ClockSource::SIMULATED:
+            return simulation.now_ns.load(std::memory_order_acquire);
+        case ClockSource::SYSTEM:
+        default:
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+    }
+}
+
+}  // namespace detail
+
+}  // namespace util
+}  // namespace rix
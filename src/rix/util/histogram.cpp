@@ -0,0 +1,127 @@
+#include "rix/util/histogram.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+
+namespace rix {
+namespace util {
+
+namespace {
+
+std::string format_ns(double ns) {
+    char buf[32];
+    if (ns < 1e3) {
+        snprintf(buf, sizeof(buf), "%.0fns", ns);
+    } else if (ns < 1e6) {
+        snprintf(buf, sizeof(buf), "%.1fus", ns / 1e3);
+    } else if (ns < 1e9) {
+        snprintf(buf, sizeof(buf), "%.2fms", ns / 1e6);
+    } else {
+        snprintf(buf, sizeof(buf), "%.3fs", ns / 1e9);
+    }
+    return buf;
+}
+
+}  // namespace
+
+Histogram::Histogram() : count_(0), sum_(0), min_(std::numeric_limits<int64_t>::max()), max_(0) {
+    for (auto &c : counts_) {
+        c.store(0, std::memory_order_relaxed);
+    }
+}
+
+void Histogram::record(int64_t value) {
+    if (value < 0) {
+        value = 0;
+    }
+    counts_[index(value)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(value, std::memory_order_relaxed);
+
+    int64_t current = min_.load(std::memory_order_relaxed);
+    while (value < current && !min_.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+    current = max_.load(std::memory_order_relaxed);
+    while (value > current && !max_.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+void Histogram::record(const Duration &duration) { record(duration.to_nanoseconds()); }
+
+uint64_t Histogram::count() const { return count_.load(std::memory_order_relaxed); }
+
+int64_t Histogram::min() const { return count() == 0 ? 0 : min_.load(std::memory_order_relaxed); }
+
+int64_t Histogram::max() const { return max_.load(std::memory_order_relaxed); }
+
+double Histogram::mean() const {
+    uint64_t n = count();
+    return n == 0 ? 0.0 : static_cast<double>(sum_.load(std::memory_order_relaxed)) / n;
+}
+
+int64_t Histogram::percentile(double p) const {
+    uint64_t n = count();
+    if (n == 0) {
+        return 0;
+    }
+    p = std::clamp(p, 0.0, 100.0);
+    uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(p / 100.0 * n)));
+    if (rank >= n) {
+        return max();
+    }
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKETS; i++) {
+        seen += counts_[i].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            int64_t mid = static_cast<int64_t>(lowest(i) + (highest(i) - lowest(i)) / 2);
+            return std::clamp(mid, min(), max());
+        }
+    }
+    return max();
+}
+
+void Histogram::reset() {
+    for (auto &c : counts_) {
+        c.store(0, std::memory_order_relaxed);
+    }
+    count_.store(0, std::memory_order_relaxed);
+    sum_.store(0, std::memory_order_relaxed);
+    min_.store(std::numeric_limits<int64_t>::max(), std::memory_order_relaxed);
+    max_.store(0, std::memory_order_relaxed);
+}
+
+std::string Histogram::summary() const {
+    return "n=" + std::to_string(count()) + " min=" + format_ns(min()) + " mean=" + format_ns(mean()) +
+           " p50=" + format_ns(percentile(50.0)) + " p99=" + format_ns(percentile(99.0)) +
+           " p999=" + format_ns(percentile(99.9)) + " max=" + format_ns(max());
+}
+
+size_t Histogram::index(uint64_t value) {
+    // Values below 2^(SUB_BUCKET_BITS + 1) are stored exactly. Above that,
+    // `shift` is how many low bits are dropped so that the remaining
+    // significant bits fit in a sub-bucket.
+    int shift = 63 - __builtin_clzll(value | (uint64_t(1) << SUB_BUCKET_BITS)) - SUB_BUCKET_BITS;
+    return static_cast<size_t>(shift) * SUB_BUCKETS + (value >> shift);
+}
+
+uint64_t Histogram::lowest(size_t index) {
+    if (index < 2 * SUB_BUCKETS) {
+        return index;
+    }
+    size_t shift = index / SUB_BUCKETS - 1;
+    return static_cast<uint64_t>(index - shift * SUB_BUCKETS) << shift;
+}
+
+uint64_t Histogram::highest(size_t index) {
+    if (index < 2 * SUB_BUCKETS) {
+        return index;
+    }
+    size_t shift = index / SUB_BUCKETS - 1;
+    return lowest(index) + (uint64_t(1) << shift) - 1;
+}
+
+}  // namespace util
+}  // namespace rix
\ No newline at end of file
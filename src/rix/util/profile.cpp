@@ -0,0 +1,68 @@
+#include "rix/util/profile.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+
+namespace rix {
+namespace util {
+
+std::mutex Profiler::mutex_;
+std::vector<Profiler::Entry> Profiler::probes_;
+
+Histogram &Profiler::probe(const std::string &name) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    for (Entry &entry : probes_) {
+        if (entry.name == name) {
+            return *entry.histogram;
+        }
+    }
+    probes_.push_back(Entry{name, std::make_unique<Histogram>()});
+    return *probes_.back().histogram;
+}
+
+std::vector<std::string> Profiler::names() {
+    std::vector<std::string> result;
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        for (const Entry &entry : probes_) {
+            result.push_back(entry.name);
+        }
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+void Profiler::dump(std::ostream &os) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    std::vector<const Entry *> entries;
+    size_t width = 0;
+    for (const Entry &entry : probes_) {
+        if (entry.histogram->count() > 0) {
+            entries.push_back(&entry);
+            width = std::max(width, entry.name.size());
+        }
+    }
+    std::sort(entries.begin(), entries.end(), [](const Entry *a, const Entry *b) { return a->name < b->name; });
+    for (const Entry *entry : entries) {
+        os << std::left << std::setw(static_cast<int>(width + 1)) << (entry->name + ":") << std::right << " "
+           << entry->histogram->summary() << "\n";
+    }
+    os.flush();
+}
+
+void Profiler::dump_at_exit() {
+    static std::once_flag once;
+    std::call_once(once, [] { std::atexit([] { dump(std::cerr); }); });
+}
+
+void Profiler::reset() {
+    std::lock_guard<std::mutex> guard(mutex_);
+    for (Entry &entry : probes_) {
+        entry.histogram->reset();
+    }
+}
+
+}  // namespace util
+}  // namespace rix
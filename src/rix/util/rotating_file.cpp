@@ -0,0 +1,318 @@
+#include "rix/util/rotating_file.hpp"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <tuple>
+#include <vector>
+
+namespace rix {
+namespace util {
+
+RotatingFile::RotatingFile()
+    : stop_(true),
+      wake_(false),
+      fd_(-1),
+      sequence_(0),
+      file_bytes_(0),
+      unsynced_bytes_(0),
+      bytes_written_(0),
+      rotations_(0),
+      syncs_(0),
+      dropped_(0) {}
+
+RotatingFile::~RotatingFile() { close(); }
+
+bool RotatingFile::open(const std::string &directory, const std::string &name, const Options &options) {
+    close();
+    options_ = options;
+    if (options_.write_interval <= Duration(0.0)) {
+        options_.write_interval = Options().write_interval;
+    }
+    directory_ = directory;
+    if (!directory_.empty() && directory_.back() != '/') {
+        directory_ += '/';
+    }
+    name_ = name;
+
+    struct stat st;
+    if (stat(directory_.c_str(), &st) < 0 && mkdir(directory_.c_str(), S_IRWXU) < 0) {
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> io_guard(io_mtx_);
+        if (!open_file()) {
+            return false;
+        }
+        remove_old_files();
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(mtx_);
+        stop_ = false;
+        wake_ = false;
+    }
+    thr_ = std::thread(&RotatingFile::run, this);
+    return true;
+}
+
+bool RotatingFile::open(const std::string &directory, const std::string &name) {
+    return open(directory, name, Options());
+}
+
+void RotatingFile::close() {
+    {
+        std::lock_guard<std::mutex> guard(mtx_);
+        if (stop_) {
+            return;
+        }
+        stop_ = true;
+    }
+    cv_.notify_one();
+    if (thr_.joinable()) {
+        thr_.join();
+    }
+    std::lock_guard<std::mutex> io_guard(io_mtx_);
+    {
+        std::lock_guard<std::mutex> guard(mtx_);
+        batch_.swap(pending_);
+    }
+    write_batch();
+    close_file();
+}
+
+bool RotatingFile::is_open() const {
+    std::lock_guard<std::mutex> guard(mtx_);
+    return !stop_;
+}
+
+bool RotatingFile::flush() {
+    std::lock_guard<std::mutex> io_guard(io_mtx_);
+    {
+        std::lock_guard<std::mutex> guard(mtx_);
+        batch_.swap(pending_);
+    }
+    bool ok = write_batch();
+    if (fd_ >= 0 && unsynced_bytes_ > 0) {
+        ok = (fdatasync(fd_) == 0) && ok;
+        unsynced_bytes_ = 0;
+        last_sync_ = Time::now();
+        syncs_++;
+    }
+    return ok;
+}
+
+std::string RotatingFile::path() const {
+    std::lock_guard<std::mutex> guard(mtx_);
+    return path_;
+}
+
+uint64_t RotatingFile::bytes_written() const { return bytes_written_.load(); }
+uint64_t RotatingFile::rotations() const { return rotations_.load(); }
+uint64_t RotatingFile::syncs() const { return syncs_.load(); }
+uint64_t RotatingFile::dropped() const { return dropped_.load(); }
+
+int RotatingFile::overflow(int c) {
+    if (c != EOF) {
+        char ch = static_cast<char>(c);
+        xsputn(&ch, 1);
+    }
+    return 0;
+}
+
+std::streamsize RotatingFile::xsputn(const char *s, std::streamsize n) {
+    std::lock_guard<std::mutex> guard(mtx_);
+    if (pending_.size() + n > options_.max_pending) {
+        dropped_ += n;
+        return n;
+    }
+    pending_.append(s, n);
+    return n;
+}
+
+int RotatingFile::sync() {
+    {
+        std::lock_guard<std::mutex> guard(mtx_);
+        wake_ = true;
+    }
+    cv_.notify_one();
+    return 0;
+}
+
+void RotatingFile::run() {
+    std::unique_lock<std::mutex> lock(mtx_);
+    while (!stop_) {
+        cv_.wait_for(lock, options_.write_interval.get(), [this] { return stop_ || wake_; });
+        wake_ = false;
+        if (stop_) {
+            break;
+        }
+        lock.unlock();
+        {
+            std::lock_guard<std::mutex> io_guard(io_mtx_);
+            {
+                std::lock_guard<std::mutex> guard(mtx_);
+                batch_.swap(pending_);
+            }
+            write_batch();
+
+            // Time-based durability: sync whatever the byte threshold did not
+            Time now = Time::now();
+            if (fd_ >= 0 && unsynced_bytes_ > 0 && options_.sync_interval > Duration(0.0) &&
+                now - last_sync_ >= options_.sync_interval) {
+                fdatasync(fd_);
+                unsynced_bytes_ = 0;
+                last_sync_ = now;
+                syncs_++;
+            }
+        }
+        lock.lock();
+    }
+}
+
+bool RotatingFile::write_batch() {
+    Time now = Time::now();
+    bool too_big = options_.max_bytes > 0 && file_bytes_ > 0 && file_bytes_ + batch_.size() > options_.max_bytes;
+    bool too_old = options_.max_age > Duration(0.0) && file_bytes_ > 0 && now - file_opened_ >= options_.max_age;
+    // Rotate only when there is something to write, so idle periods and
+    // closing never leave empty files behind
+    if (!batch_.empty() && (too_big || too_old)) {
+        close_file();
+        rotations_++;
+        if (!open_file()) {
+            dropped_ += batch_.size();
+            batch_.clear();
+            return false;
+        }
+        remove_old_files();
+    }
+    if (batch_.empty() || fd_ < 0) {
+        return true;
+    }
+
+    bool ok = true;
+    size_t offset = 0;
+    while (offset < batch_.size()) {
+        ssize_t n = ::write(fd_, batch_.data() + offset, batch_.size() - offset);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            dropped_ += batch_.size() - offset;
+            ok = false;
+            break;
+        }
+        offset += n;
+    }
+    file_bytes_ += offset;
+    unsynced_bytes_ += offset;
+    bytes_written_ += offset;
+    batch_.clear();
+
+    if (options_.sync_bytes > 0 && unsynced_bytes_ >= options_.sync_bytes) {
+        ok = (fdatasync(fd_) == 0) && ok;
+        unsynced_bytes_ = 0;
+        last_sync_ = now;
+        syncs_++;
+    }
+    return ok;
+}
+
+bool RotatingFile::open_file() {
+    // Stamp files with the realtime clock whatever source Time::now reads,
+    // and never reuse a name: two rotations may read the same stamp, e.g.
+    // under a SimulatedClock or after the system time steps back
+    int64_t stamp = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+    std::string path;
+    int fd = -1;
+    while (fd < 0) {
+        char suffix[64];
+        std::snprintf(suffix, sizeof(suffix), "_%lld_%06llu.log", static_cast<long long>(stamp),
+                      static_cast<unsigned long long>(sequence_++));
+        path = directory_ + name_ + suffix;
+        fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+        if (fd < 0 && errno != EEXIST) {
+            return false;
+        }
+    }
+    if (options_.preallocate && options_.max_bytes > 0) {
+        // Reserve the blocks up front without changing the visible size; a
+        // failure here (e.g. on tmpfs) only loses the optimization
+        fallocate(fd, FALLOC_FL_KEEP_SIZE, 0, static_cast<off_t>(options_.max_bytes));
+    }
+    fd_ = fd;
+    file_bytes_ = 0;
+    unsynced_bytes_ = 0;
+    file_opened_ = Time::now();
+    last_sync_ = file_opened_;
+    std::lock_guard<std::mutex> guard(mtx_);
+    path_ = path;
+    return true;
+}
+
+void RotatingFile::close_file() {
+    if (fd_ < 0) {
+        return;
+    }
+    if (unsynced_bytes_ > 0) {
+        fdatasync(fd_);
+        syncs_++;
+    }
+    if (options_.preallocate) {
+        // Release the preallocated blocks past the end of the data
+        ftruncate(fd_, static_cast<off_t>(file_bytes_));
+    }
+    ::close(fd_);
+    fd_ = -1;
+    unsynced_bytes_ = 0;
+}
+
+void RotatingFile::remove_old_files() {
+    if (options_.max_files == 0) {
+        return;
+    }
+    DIR *dir = opendir(directory_.c_str());
+    if (!dir) {
+        return;
+    }
+    // Files are named <name>_<ns>_<seq>.log; order them by stamp, then sequence
+    std::vector<std::tuple<int64_t, uint64_t, std::string>> files;
+    const std::string prefix = name_ + "_";
+    const std::string suffix = ".log";
+    while (struct dirent *entry = readdir(dir)) {
+        std::string file(entry->d_name);
+        if (file.size() <= prefix.size() + suffix.size() || !file.starts_with(prefix) || !file.ends_with(suffix)) {
+            continue;
+        }
+        std::string stamp = file.substr(prefix.size(), file.size() - prefix.size() - suffix.size());
+        size_t sep = stamp.find('_');
+        std::string seq = sep == std::string::npos ? "0" : stamp.substr(sep + 1);
+        stamp = stamp.substr(0, sep);
+        auto digits = [](const std::string &str) {
+            return !str.empty() && std::all_of(str.begin(), str.end(), [](char c) { return c >= '0' && c <= '9'; });
+        };
+        if (!digits(stamp) || !digits(seq)) {
+            continue;
+        }
+        files.emplace_back(std::stoll(stamp), std::stoull(seq), file);
+    }
+    closedir(dir);
+
+    if (files.size() <= options_.max_files) {
+        return;
+    }
+    std::sort(files.begin(), files.end());
+    for (size_t i = 0; i + options_.max_files < files.size(); i++) {
+        unlink((directory_ + std::get<2>(files[i])).c_str());
+    }
+}
+
+}  // namespace util
+}  // namespace rix
@@ -0,0 +1,140 @@
+#include "rix/util/scheduler.hpp"
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include "rix/util/clock.hpp"
+
+namespace rix {
+namespace util {
+
+Scheduler::Scheduler()
+    : next_id_(1), stop_(false), wake_fd_(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)), thr_(&Scheduler::run, this) {}
+
+Scheduler::~Scheduler() {
+    stop();
+    if (wake_fd_ >= 0) {
+        ::close(wake_fd_);
+    }
+}
+
+Scheduler::JobId Scheduler::add(const Duration &period, std::function<void()> job, const Duration &delay) {
+    std::lock_guard<std::mutex> guard(mtx_);
+    JobId id = next_id_++;
+    jobs_.emplace(id, Job{period <= Duration(0.0) ? Rate::min_period() : period, std::move(job)});
+    deadlines_.push({Time::now() + delay, id});
+    wake();
+    return id;
+}
+
+bool Scheduler::cancel(JobId id) {
+    std::lock_guard<std::mutex> guard(mtx_);
+    // The stale deadline is discarded when it reaches the top of the heap
+    if (jobs_.erase(id) == 0) {
+        return false;
+    }
+    wake();
+    return true;
+}
+
+void Scheduler::stop() {
+    {
+        std::lock_guard<std::mutex> guard(mtx_);
+        stop_ = true;
+        jobs_.clear();
+        wake();
+    }
+    if (thr_.joinable() && thr_.get_id() != std::this_thread::get_id()) {
+        thr_.join();
+    }
+}
+
+size_t Scheduler::size() const {
+    std::lock_guard<std::mutex> guard(mtx_);
+    return jobs_.size();
+}
+
+void Scheduler::run() {
+    std::unique_lock<std::mutex> lock(mtx_);
+    while (!stop_) {
+        if (deadlines_.empty()) {
+            cv_.wait(lock);
+            continue;
+        }
+
+        Deadline next = deadlines_.top();
+        auto job = jobs_.find(next.id);
+        if (job == jobs_.end()) {
+            // Cancelled
+            deadlines_.pop();
+            continue;
+        }
+
+        if (Time::now() < next.time) {
+            // Woken early by add/cancel/stop or by the deadline itself
+            if (wait_simulated(lock, next.time)) {
+                continue;
+            }
+            if (detail::clock_is_realtime()) {
+                cv_.wait_until(lock, next.time.get());
+            } else {
+                cv_.wait_until(lock, detail::steady_deadline(next.time));
+            }
+            continue;
+        }
+        deadlines_.pop();
+
+        // Schedule the next call before running this one, skipping any
+        // periods that have already been missed
+        Duration period = job->second.period;
+        Time now = Time::now();
+        Time deadline = next.time + period;
+        if (deadline <= now) {
+            int64_t missed = (now - deadline).to_nanoseconds() / period.to_nanoseconds() + 1;
+            deadline += Duration(Duration::Type(missed * period.to_nanoseconds()));
+        }
+        deadlines_.push({deadline, next.id});
+
+        // Run the job without holding the lock so it may add or cancel jobs
+        std::function<void()> fn = job->second.fn;
+        lock.unlock();
+        fn();
+        lock.lock();
+    }
+}
+
+bool Scheduler::wait_simulated(std::unique_lock<std::mutex> &lock, const Time &deadline) {
+    if (wake_fd_ < 0 || !SimulatedClock::running()) {
+        return false;
+    }
+    SimulatedClock::Alarm alarm(deadline);
+    if (alarm.fd() < 0) {
+        return false;
+    }
+
+    // A wake signalled before the poll leaves `wake_fd_` readable, so none is
+    // lost while the lock is released
+    struct pollfd pfds[2];
+    pfds[0] = {alarm.fd(), POLLIN, 0};
+    pfds[1] = {wake_fd_, POLLIN, 0};
+    lock.unlock();
+    ::poll(pfds, 2, -1);
+    uint64_t count;
+    ssize_t n = ::read(wake_fd_, &count, sizeof(count));
+    (void)n;
+    lock.lock();
+    return true;
+}
+
+void Scheduler::wake() {
+    cv_.notify_one();
+    if (wake_fd_ >= 0) {
+        uint64_t one = 1;
+        ssize_t n = ::write(wake_fd_, &one, sizeof(one));
+        (void)n;
+    }
+}
+
+}  // namespace util
+}  // namespace rix
\ No newline at end of file
@@ -0,0 +1,154 @@
+#include "rix/util/thread_pool.hpp"
+
+#include <algorithm>
+
+namespace rix {
+namespace util {
+
+namespace {
+
+// The pool the current thread works for, and its index there
+thread_local const ThreadPool *current_pool = nullptr;
+thread_local size_t current_index = 0;
+
+constexpr int IDLE_YIELDS = 16;  ///< Failed takes a worker yields for before it parks
+
+}  // namespace
+
+ThreadPool::ThreadPool(size_t threads) : queued_(0), pending_(0), next_(0), parked_(0), stop_(false) {
+    threads = std::max<size_t>(threads, 1);
+    for (size_t i = 0; i < threads; i++) {
+        queues_.push_back(std::make_unique<Queue>());
+    }
+    threads_.reserve(threads);
+    for (size_t i = 0; i < threads; i++) {
+        threads_.emplace_back(&ThreadPool::run, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> guard(mtx_);
+        stop_ = true;
+    }
+    cv_.notify_all();
+    for (auto &thread : threads_) {
+        thread.join();
+    }
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    size_t index = worker();
+    if (index == size()) {
+        index = next_.fetch_add(1, std::memory_order_relaxed) % size();
+    }
+    pending_.fetch_add(1);
+    {
+        std::lock_guard<std::mutex> guard(queues_[index]->mtx);
+        queues_[index]->tasks.push_back(std::move(task));
+    }
+    // Counted after the push, so a worker woken by the count finds the task.
+    // A worker may take it first and briefly drive the count negative.
+    queued_.fetch_add(1);
+    wake_one();
+}
+
+void ThreadPool::wake_one() {
+    // Pairs with the increment of `parked_` in `run`: either the worker sees
+    // the new `queued_`, or this sees it parking and takes `mtx_`, which the
+    // worker holds until it waits
+    if (parked_.load() > 0) {
+        std::lock_guard<std::mutex> guard(mtx_);
+        cv_.notify_one();
+    }
+}
+
+void ThreadPool::parallel_for(size_t n, const std::function<void(size_t)> &fn) {
+    if (worker() < size()) {
+        // Waiting here could leave no worker to run the calls
+        for (size_t i = 0; i < n; i++) {
+            fn(i);
+        }
+        return;
+    }
+    std::mutex mtx;
+    std::condition_variable cv;
+    size_t done = 0;
+    for (size_t i = 0; i < n; i++) {
+        submit([&, i] {
+            fn(i);
+            std::lock_guard<std::mutex> guard(mtx);
+            if (++done == n) {
+                cv.notify_one();
+            }
+        });
+    }
+    std::unique_lock<std::mutex> lock(mtx);
+    cv.wait(lock, [&] { return done == n; });
+}
+
+void ThreadPool::wait() {
+    std::unique_lock<std::mutex> lock(mtx_);
+    idle_cv_.wait(lock, [this] { return pending_.load() == 0; });
+}
+
+size_t ThreadPool::size() const { return threads_.size(); }
+
+size_t ThreadPool::worker() const { return current_pool == this ? current_index : size(); }
+
+void ThreadPool::run(size_t index) {
+    current_pool = this;
+    current_index = index;
+    std::function<void()> task;
+    int idle = 0;
+    while (true) {
+        if (take(index, task)) {
+            idle = 0;
+            task();
+            task = nullptr;
+            if (pending_.fetch_sub(1) == 1) {
+                std::lock_guard<std::mutex> guard(mtx_);
+                idle_cv_.notify_all();
+            }
+            continue;
+        }
+        // Yield a few times before parking, so a submitter that is mid-batch
+        // can queue more without paying for a wakeup per task
+        if (idle++ < IDLE_YIELDS) {
+            std::this_thread::yield();
+            continue;
+        }
+        idle = 0;
+        std::unique_lock<std::mutex> lock(mtx_);
+        parked_.fetch_add(1);
+        cv_.wait(lock, [this] { return stop_.load() || queued_.load() > 0; });
+        parked_.fetch_sub(1);
+        if (stop_.load() && queued_.load() <= 0) {
+            return;  // Stopped and drained
+        }
+    }
+}
+
+bool ThreadPool::take(size_t index, std::function<void()> &task) {
+    const size_t n = queues_.size();
+    for (size_t i = 0; i < n; i++) {
+        Queue &queue = *queues_[(index + i) % n];
+        std::unique_lock<std::mutex> lock(queue.mtx);
+        if (queue.tasks.empty()) {
+            continue;
+        }
+        if (i == 0) {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+        } else {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+        }
+        queued_.fetch_sub(1);
+        return true;
+    }
+    return false;
+}
+
+}  // namespace util
+}  // namespace rix
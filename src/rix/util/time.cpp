@@ -1,37 +1,22 @@
 #include "rix/util/time.hpp"
 
+#include <time.h>
+
+#include <algorithm>
+#include <cerrno>
 #include <chrono>
-#include <iomanip>
-#include <sstream>
 #include <thread>
 
+#include "rix/util/clock.hpp"
+#include "rix/util/histogram.hpp"
+#include "rix/util/timestamp.hpp"
+
 namespace rix {
 namespace util {
 
 std::string Time::to_string(bool local_time) const {
-    auto time = Clock::to_time_t(std::chrono::time_point_cast<std::chrono::seconds>(tp));
-    std::stringstream ss;
-    std::tm *timeinfo;
-    if (local_time) {
-        timeinfo = std::localtime(&time);
-    } else {
-        timeinfo = std::gmtime(&time);
-    }
-
-    ss << std::put_time(timeinfo, "%D %T");
-    int64_t us = to_microseconds() % 1'000'000;
-    if (us == 0) {
-        ss << ".000000";
-    } else {
-        ss << "." << us;
-    }
-
-    if (local_time) {
-        ss << " " << std::put_time(timeinfo, "%Z");
-    } else {
-        ss << " GMT";
-    }
-    return ss.str();
+    TimestampFormatter &formatter = local_time ? TimestampFormatter::local() : TimestampFormatter::utc();
+    return formatter.format(*this);
 }
 
 rix::msg::standard::Time Time::to_msg() {
@@ -44,7 +29,7 @@ rix::msg::standard::Time Time::to_msg() {
 
 Time Time::now() {
     Time time;
-    time.tp = Clock::now();
+    time.tp = Type(std::chrono::nanoseconds(detail::clock_now_ns()));
     return time;
 }
 
@@ -278,13 +263,34 @@ const Duration::Type &Duration::get() const { return d; }
 
 Duration::Type &Duration::get() { return d; }
 
-void sleep_for(const Duration &duration) { std::this_thread::sleep_for(duration.get()); }
+void sleep_for(const Duration &duration) {
+    if (SimulatedClock::running()) {
+        sleep_until(Time::now() + duration);
+        return;
+    }
+    std::this_thread::sleep_for(duration.get());
+}
 
-void sleep_until(const Time &time) { std::this_thread::sleep_until(time.get()); }
+void sleep_until(const Time &time) {
+    if (SimulatedClock::wait_until(time)) {
+        return;
+    }
+    if (detail::clock_is_realtime()) {
+        std::this_thread::sleep_until(time.get());
+        return;
+    }
+    // The anchored sources are slewed, so a steady deadline may wake slightly
+    // early; wait again for the rest
+    while (Time::now() < time) {
+        std::this_thread::sleep_until(detail::steady_deadline(time));
+    }
+}
 
 Timer::Timer() {}
 
-Timer::Timer(const Timer &other) : start_(other.start_), end_(other.end_) {}
+Timer::Timer(Histogram &histogram) : histogram_(&histogram) {}
+
+Timer::Timer(const Timer &other) : start_(other.start_), end_(other.end_), histogram_(other.histogram_) {}
 
 Timer &Timer::operator=(const Timer &other) {
     if (this == &other) {
@@ -293,23 +299,86 @@ Timer &Timer::operator=(const Timer &other) {
     Timer tmp(other);
     std::swap(start_, tmp.start_);
     std::swap(end_, tmp.end_);
+    std::swap(histogram_, tmp.histogram_);
     return *this;
 }
 
 void Timer::start() { start_ = Time::now(); }
 
-void Timer::stop() { end_ = Time::now(); }
+void Timer::stop() {
+    end_ = Time::now();
+    if (histogram_) {
+        histogram_->record(end_ - start_);
+    }
+}
 
 Duration Timer::get() const { return end_ - start_; }
 
-Rate::Rate() : period_(0), start_(Time::now()) {}
+namespace {
+
+constexpr Duration::Type DEFAULT_SPIN = std::chrono::microseconds(200);
+
+/**
+ * @brief Adds a period to a deadline without overflowing for "infinite"
+ * periods.
+ */
+Time advance(const Time &time, const Duration &period) {
+    return time + std::min(period, Duration::safe_forever());
+}
+
+/**
+ * @brief Sleeps until `spin` before the deadline, then spins until it.
+ */
+void sleep_until_precise(const Time &deadline, const Duration &spin) {
+    if (SimulatedClock::running()) {
+        sleep_until(deadline);
+        return;
+    }
+    Time wake = deadline - spin;
+    if (wake > Time::now()) {
+        // Sleep on the clock the source follows, so an anchored source that
+        // runs ahead of CLOCK_REALTIME does not oversleep
+        clockid_t id = CLOCK_REALTIME;
+        int64_t ns = wake.to_nanoseconds();
+        if (!detail::clock_is_realtime()) {
+            id = CLOCK_MONOTONIC;
+            ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                     detail::steady_deadline(wake).time_since_epoch())
+                     .count();
+        }
+        struct timespec ts;
+        ts.tv_sec = static_cast<time_t>(ns / 1'000'000'000);
+        ts.tv_nsec = static_cast<long>(ns % 1'000'000'000);
+        while (clock_nanosleep(id, TIMER_ABSTIME, &ts, nullptr) == EINTR) {
+        }
+    }
+    while (Time::now() < deadline) {
+    }
+}
+
+}  // namespace
 
-Rate::Rate(double frequency)
-    : period_((frequency <= min_frequency()) ? max_period() : Duration(1.0 / frequency)), start_(Time::now()) {}
+Rate::Rate() : period_(0), mode_(Mode::SLEEP), overrun_(Overrun::SKIP), spin_(DEFAULT_SPIN) { reset(); }
 
-Rate::Rate(Duration period) : period_((period <= min_period()) ? min_period() : period), start_(Time::now()) {}
+Rate::Rate(double frequency) : Rate(frequency, Mode::SLEEP) {}
 
-Rate::Rate(const Rate &other) : period_(other.period_), start_(other.start_) {}
+Rate::Rate(Duration period) : Rate(period, Mode::SLEEP) {}
+
+Rate::Rate(double frequency, Mode mode, Overrun overrun)
+    : Rate((frequency <= min_frequency()) ? max_period() : Duration(1.0 / frequency), mode, overrun) {}
+
+Rate::Rate(Duration period, Mode mode, Overrun overrun)
+    : period_((period <= min_period()) ? min_period() : period), mode_(mode), overrun_(overrun), spin_(DEFAULT_SPIN) {
+    reset();
+}
+
+Rate::Rate(const Rate &other)
+    : period_(other.period_),
+      start_(other.start_),
+      mode_(other.mode_),
+      overrun_(other.overrun_),
+      spin_(other.spin_),
+      stats_(other.stats_) {}
 
 Rate &Rate::operator=(const Rate &other) {
     if (this == &other) {
@@ -318,20 +387,71 @@ Rate &Rate::operator=(const Rate &other) {
     Rate tmp(other);
     std::swap(period_, tmp.period_);
     std::swap(start_, tmp.start_);
+    std::swap(mode_, tmp.mode_);
+    std::swap(overrun_, tmp.overrun_);
+    std::swap(spin_, tmp.spin_);
+    std::swap(stats_, tmp.stats_);
     return *this;
 }
 
 bool Rate::sleep() {
+    if (mode_ == Mode::PRECISE) {
+        return sleep_precise();
+    }
     auto now = Time::now();
-    if (start_ + period_ > now) {
-        sleep_until(start_ + period_);
+    Time deadline = start_ + period_;
+    if (deadline > now) {
+        sleep_until(deadline);
         start_ = Time::now();
+        record(start_ - deadline);
         return true;
     } else {
         start_ = now;
+        stats_.overruns++;
+        record(now - deadline);
         return false;
     }
 }
+
+bool Rate::sleep_precise() {
+    Time now = Time::now();
+    Time deadline = start_;
+    bool on_time = now < deadline;
+    if (on_time) {
+        sleep_until_precise(deadline, spin_);
+        now = Time::now();
+    } else {
+        stats_.overruns++;
+    }
+    record(now - deadline);
+
+    start_ = advance(deadline, period_);
+    if (!on_time && overrun_ == Overrun::SKIP && start_ <= now) {
+        int64_t period = period_.to_nanoseconds();
+        if (period <= 0) {
+            // No phase to keep; the next cycle starts now
+            start_ = now;
+            return on_time;
+        }
+        // Jump to the first deadline after now, keeping the phase
+        int64_t missed = (now - start_).to_nanoseconds() / period + 1;
+        start_ += Duration(std::chrono::nanoseconds(missed * period));
+        stats_.skipped += missed;
+    }
+    return on_time;
+}
+
+void Rate::record(const Duration &lateness) {
+    stats_.cycles++;
+    stats_.last_lateness = lateness;
+    stats_.total_lateness += lateness;
+    if (stats_.cycles == 1 || lateness > stats_.max_lateness) {
+        stats_.max_lateness = lateness;
+    }
+}
+
+void Rate::reset() { start_ = mode_ == Mode::PRECISE ? advance(Time::now(), period_) : Time::now(); }
+
 Duration Rate::period() const { return period_; }
 
 void Rate::set_period(const Duration &period) { period_ = period; }
@@ -344,6 +464,25 @@ double Rate::frequency() const {
     return 1.0 / (ns * 1e-9);
 }
 
+Rate::Mode Rate::mode() const { return mode_; }
+
+void Rate::set_mode(Mode mode) {
+    mode_ = mode;
+    reset();
+}
+
+Rate::Overrun Rate::overrun() const { return overrun_; }
+
+void Rate::set_overrun(Overrun overrun) { overrun_ = overrun; }
+
+Duration Rate::spin() const { return spin_; }
+
+void Rate::set_spin(const Duration &spin) { spin_ = spin; }
+
+const Rate::Stats &Rate::stats() const { return stats_; }
+
+void Rate::reset_stats() { stats_ = Stats(); }
+
 void Rate::set_frequency(double frequency) {
     if (frequency <= min_frequency()) {
         period_ = max_period();
@@ -0,0 +1,252 @@
+#include "rix/util/timer_wheel.hpp"
+
+#include <algorithm>
+
+namespace rix {
+namespace util {
+
+TimerWheel::TimerWheel(const Duration &resolution, const Time &start)
+    : resolution_ns_(std::max<int64_t>(resolution.to_nanoseconds(), 1)),
+      start_ns_(start.to_nanoseconds()),
+      current_(0),
+      size_(0) {
+    heads_.fill(NONE);
+    level_sizes_.fill(0);
+}
+
+TimerWheel::TimerId TimerWheel::schedule_at(const Time &deadline, Callback callback) {
+    uint32_t index = allocate();
+    Node &node = nodes_[index];
+    node.expires = std::max(deadline_tick(deadline), current_ + 1);
+    node.callback = std::move(callback);
+    place(index);
+    size_++;
+    return (static_cast<uint64_t>(node.generation) << 32) | index;
+}
+
+TimerWheel::TimerId TimerWheel::schedule_after(const Duration &delay, Callback callback) {
+    return schedule_at(Time::now() + delay, std::move(callback));
+}
+
+bool TimerWheel::reschedule(TimerId id, const Time &deadline) {
+    Node *node = find(id);
+    if (!node) {
+        return false;
+    }
+    uint32_t index = static_cast<uint32_t>(id);
+    unlink(index);
+    node->expires = std::max(deadline_tick(deadline), current_ + 1);
+    place(index);
+    return true;
+}
+
+bool TimerWheel::cancel(TimerId id) {
+    if (!find(id)) {
+        return false;
+    }
+    uint32_t index = static_cast<uint32_t>(id);
+    unlink(index);
+    release(index);
+    size_--;
+    return true;
+}
+
+size_t TimerWheel::advance(const Time &now) {
+    const int64_t target = current_tick(now);
+    size_t fired = 0;
+    while (current_ < target) {
+        // Skip ticks on which nothing can happen: with the lower wheels
+        // empty, the next event is the cascade at the next boundary of the
+        // lowest occupied wheel
+        int level = 0;
+        while (level < LEVELS && level_sizes_[level] == 0) {
+            level++;
+        }
+        if (level == LEVELS) {
+            current_ = target;
+            break;
+        }
+        if (level > 0) {
+            int64_t mask = (int64_t(1) << (SLOT_BITS * level)) - 1;
+            current_ = std::min(target, current_ | mask);
+            if (current_ == target) {
+                break;
+            }
+        }
+
+        const int64_t tick = ++current_;
+        for (int l = 1; l < LEVELS; l++) {
+            if (((tick >> (SLOT_BITS * (l - 1))) & (SLOTS - 1)) != 0) {
+                break;
+            }
+            cascade(l, (tick >> (SLOT_BITS * l)) & (SLOTS - 1));
+        }
+
+        // Detach the due slot first so that callbacks can cancel or
+        // reschedule timers that are due on the same tick
+        uint32_t slot = static_cast<uint32_t>(tick & (SLOTS - 1));
+        while (heads_[slot] != NONE) {
+            uint32_t index = heads_[slot];
+            unlink(index);
+            link(index, FIRING);
+        }
+        while (heads_[FIRING] != NONE) {
+            uint32_t index = heads_[FIRING];
+            unlink(index);
+            if (nodes_[index].expires > tick) {
+                place(index);
+                continue;
+            }
+            Callback callback = std::move(nodes_[index].callback);
+            release(index);
+            size_--;
+            fired++;
+            callback();
+        }
+    }
+    return fired;
+}
+
+Duration TimerWheel::time_until_next(const Time &now) const {
+    if (size_ == 0) {
+        return Duration::max();
+    }
+
+    int64_t next = INT64_MAX;
+    if (level_sizes_[0] > 0) {
+        for (size_t k = 1; k < SLOTS; k++) {
+            if (heads_[(current_ + k) & (SLOTS - 1)] != NONE) {
+                next = current_ + k;
+                break;
+            }
+        }
+    }
+    // A slot of an upper wheel holds no timer due before the slot starts
+    for (int level = 1; level < LEVELS; level++) {
+        if (level_sizes_[level] == 0) {
+            continue;
+        }
+        const int shift = SLOT_BITS * level;
+        const int64_t base = current_ >> shift;
+        for (size_t k = 1; k <= SLOTS; k++) {
+            if (heads_[level * SLOTS + ((base + k) & (SLOTS - 1))] != NONE) {
+                next = std::min(next, (base + static_cast<int64_t>(k)) << shift);
+                break;
+            }
+        }
+    }
+
+    int64_t wait = start_ns_ + next * resolution_ns_ - now.to_nanoseconds();
+    return Duration(Duration::Type(std::max<int64_t>(wait, 0)));
+}
+
+size_t TimerWheel::size() const { return size_; }
+
+bool TimerWheel::empty() const { return size_ == 0; }
+
+Duration TimerWheel::resolution() const { return Duration(Duration::Type(resolution_ns_)); }
+
+int64_t TimerWheel::deadline_tick(const Time &time) const {
+    int64_t ns = time.to_nanoseconds() - start_ns_;
+    return ns > 0 ? (ns + resolution_ns_ - 1) / resolution_ns_ : ns / resolution_ns_;
+}
+
+int64_t TimerWheel::current_tick(const Time &time) const {
+    int64_t ns = time.to_nanoseconds() - start_ns_;
+    return ns >= 0 ? ns / resolution_ns_ : -((resolution_ns_ - 1 - ns) / resolution_ns_);
+}
+
+void TimerWheel::place(uint32_t index) {
+    int64_t expires = nodes_[index].expires;
+    int64_t delta = expires - current_;
+    for (int level = 0; level < LEVELS; level++) {
+        const int shift = SLOT_BITS * level;
+        const int64_t span = int64_t(1) << (shift + SLOT_BITS);
+        if (delta < span || level == LEVELS - 1) {
+            if (delta >= span) {
+                // Beyond the top wheel: park the timer in its last slot, from
+                // where it is placed again when that slot is cascaded
+                expires = current_ + span - 1;
+            }
+            link(index, static_cast<uint32_t>(level * SLOTS + ((expires >> shift) & (SLOTS - 1))));
+            return;
+        }
+    }
+}
+
+void TimerWheel::link(uint32_t index, uint32_t list) {
+    Node &node = nodes_[index];
+    node.list = list;
+    node.prev = NONE;
+    node.next = heads_[list];
+    if (node.next != NONE) {
+        nodes_[node.next].prev = index;
+    }
+    heads_[list] = index;
+    if (list != FIRING) {
+        level_sizes_[list / SLOTS]++;
+    }
+}
+
+void TimerWheel::unlink(uint32_t index) {
+    Node &node = nodes_[index];
+    if (node.prev != NONE) {
+        nodes_[node.prev].next = node.next;
+    } else {
+        heads_[node.list] = node.next;
+    }
+    if (node.next != NONE) {
+        nodes_[node.next].prev = node.prev;
+    }
+    if (node.list != FIRING) {
+        level_sizes_[node.list / SLOTS]--;
+    }
+    node.prev = NONE;
+    node.next = NONE;
+}
+
+void TimerWheel::release(uint32_t index) {
+    Node &node = nodes_[index];
+    node.callback = nullptr;
+    node.list = NONE;
+    // Invalidates every id handed out for this node
+    if (++node.generation == 0) {
+        node.generation = 1;
+    }
+    free_.push_back(index);
+}
+
+uint32_t TimerWheel::allocate() {
+    if (!free_.empty()) {
+        uint32_t index = free_.back();
+        free_.pop_back();
+        return index;
+    }
+    nodes_.emplace_back();
+    nodes_.back().generation = 1;
+    return static_cast<uint32_t>(nodes_.size() - 1);
+}
+
+TimerWheel::Node *TimerWheel::find(TimerId id) {
+    uint32_t index = static_cast<uint32_t>(id);
+    uint32_t generation = static_cast<uint32_t>(id >> 32);
+    if (index >= nodes_.size() || nodes_[index].generation != generation || nodes_[index].list == NONE) {
+        return nullptr;
+    }
+    return &nodes_[index];
+}
+
+void TimerWheel::cascade(int level, size_t slot) {
+    uint32_t list = static_cast<uint32_t>(level * SLOTS + slot);
+    uint32_t index = heads_[list];
+    heads_[list] = NONE;
+    while (index != NONE) {
+        uint32_t next = nodes_[index].next;
+        level_sizes_[level]--;
+        place(index);
+        index = next;
+    }
+}
+
+}  // namespace util
+}  // namespace rix
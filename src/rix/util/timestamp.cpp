@@ -0,0 +1,94 @@
+#include "rix/util/timestamp.hpp"
+
+#include <cstring>
+#include <ctime>
+
+namespace rix {
+namespace util {
+
+namespace detail {
+
+namespace {
+
+struct DigitPairs {
+    char digits[200];
+    constexpr DigitPairs() : digits() {
+        for (int i = 0; i < 100; i++) {
+            digits[2 * i] = static_cast<char>('0' + i / 10);
+            digits[2 * i + 1] = static_cast<char>('0' + i % 10);
+        }
+    }
+};
+
+constexpr DigitPairs DIGIT_PAIRS;
+
+}  // namespace
+
+void format_micros(uint32_t value, char *out) {
+    uint32_t hi = value / 10000;
+    uint32_t mid = (value / 100) % 100;
+    uint32_t lo = value % 100;
+    std::memcpy(out, DIGIT_PAIRS.digits + 2 * hi, 2);
+    std::memcpy(out + 2, DIGIT_PAIRS.digits + 2 * mid, 2);
+    std::memcpy(out + 4, DIGIT_PAIRS.digits + 2 * lo, 2);
+}
+
+}  // namespace detail
+
+TimestampFormatter::TimestampFormatter(bool local_time)
+    : local_time_(local_time), cached_second_(INT64_MIN), prefix_len_(0), suffix_len_(0) {}
+
+size_t TimestampFormatter::format(const Time &t, char *out) {
+    int64_t ns = t.to_nanoseconds();
+    // Floor division so that times before the epoch round down
+    int64_t second = ns / 1'000'000'000;
+    int64_t sub = ns % 1'000'000'000;
+    if (sub < 0) {
+        second -= 1;
+        sub += 1'000'000'000;
+    }
+    if (second != cached_second_) {
+        render_prefix(second);
+    }
+
+    std::memcpy(out, prefix_, prefix_len_);
+    detail::format_micros(static_cast<uint32_t>(sub / 1000), out + prefix_len_);
+    std::memcpy(out + prefix_len_ + 6, suffix_, suffix_len_);
+    return prefix_len_ + 6 + suffix_len_;
+}
+
+std::string TimestampFormatter::format(const Time &t) {
+    char buf[MAX_SIZE];
+    return std::string(buf, format(t, buf));
+}
+
+TimestampFormatter &TimestampFormatter::utc() {
+    thread_local TimestampFormatter formatter(false);
+    return formatter;
+}
+
+TimestampFormatter &TimestampFormatter::local() {
+    thread_local TimestampFormatter formatter(true);
+    return formatter;
+}
+
+void TimestampFormatter::render_prefix(int64_t second) {
+    std::time_t time = static_cast<std::time_t>(second);
+    std::tm timeinfo;
+    if (local_time_) {
+        localtime_r(&time, &timeinfo);
+    } else {
+        gmtime_r(&time, &timeinfo);
+    }
+    prefix_len_ = std::strftime(prefix_, sizeof(prefix_), "%D %T.", &timeinfo);
+    if (local_time_) {
+        suffix_len_ = std::strftime(suffix_, sizeof(suffix_), " %Z", &timeinfo);
+    } else {
+        std::memcpy(suffix_, " GMT", 4);
+        suffix_len_ = 4;
+    }
+    cached_second_ = second;
+}
+
+}  // namespace util
+}  // namespace rix
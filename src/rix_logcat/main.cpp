@@ -0,0 +1,65 @@
+#include <iomanip>
+#include <iostream>
+
+#include "rix/util/argument_parser.hpp"
+#include "rix/util/binary_log.hpp"
+
+using namespace rix::util;
+
+namespace {
+
+const char *level_string(Log::Level level) {
+    switch (level) {
+        case Log::Level::DEBUG:
+            return "DEBUG";
+        case Log::Level::INFO:
+            return "INFO";
+        case Log::Level::WARN:
+            return "WARN";
+        case Log::Level::ERROR:
+            return "ERROR";
+        case Log::Level::FATAL:
+            return "FATAL";
+    }
+    return "";
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    ArgumentParser parser("rix_logcat", "Decodes a binary log written by rix::util::BinaryLog to text.");
+    parser.add<std::string>("file", "Path to the .rixlog file");
+    parser.add<bool>("location", "Append the source file and line of each record", 'l', false);
+    parser.add<bool>("local", "Print timestamps in local time", 't', false);
+
+    if (!parser.parse(argc, argv)) {
+        std::cerr << parser.help() << std::endl;
+        return 1;
+    }
+
+    std::string file;
+    bool location, local;
+    if (!parser.get<std::string>("file", file) || !parser.get<bool>("location", location) ||
+        !parser.get<bool>("local", local)) {
+        std::cerr << "Failed to get arguments." << std::endl;
+        return 1;
+    }
+
+    BinaryLogReader reader;
+    if (!reader.open(file)) {
+        std::cerr << "Failed to open " << file << ": not a binary log." << std::endl;
+        return 1;
+    }
+
+    BinaryLogRecord record;
+    while (reader.next(record)) {
+        std::string level_str = std::string("[") + level_string(record.level) + "] ";
+        std::cout << "[" << record.stamp.to_string(local) << "] " << std::setw(8) << std::left << level_str << "["
+                  << reader.name() << "] " << record.message;
+        if (location && !record.file.empty()) {
+            std::cout << " (" << record.file << ":" << record.line << ")";
+        }
+        std::cout << '\n';
+    }
+    return 0;
+}
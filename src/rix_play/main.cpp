@@ -0,0 +1,125 @@
+#include <unistd.h>
+
+#include <csignal>
+#include <iostream>
+#include <vector>
+
+#include "rix/bag/reader.hpp"
+#include "rix/ipc/file.hpp"
+#include "rix/ipc/signal.hpp"
+#include "rix/msg/geometry/Twist2DStamped.hpp"
+#include "rix/msg/standard/UInt32.hpp"
+#include "rix/util/argument_parser.hpp"
+#include "rix/util/time.hpp"
+
+using namespace rix::ipc;
+using namespace rix::msg;
+using namespace rix::util;
+
+namespace {
+
+bool write_all(const File &output, const uint8_t *data, size_t size) {
+    size_t written = 0;
+    while (written < size) {
+        ssize_t n = output.write(data + written, size - written);
+        if (n <= 0) {
+            return false;
+        }
+        written += n;
+    }
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    ArgumentParser parser("rix_play",
+                          "Writes the Twist2DStamped messages of a bag to stdout as size-prefixed frames (the input "
+                          "format of mbot_driver), preserving the recorded timing.");
+    parser.add<std::string>("bag", "Path of the bag to play");
+    parser.add<double>("rate", "Playback speed as a multiple of real time (0 = as fast as possible)", 'r', 1.0);
+    parser.add<double>("start", "Seconds into the bag to start playing from", 's', 0.0);
+    parser.add<bool>("keep_stamps", "Keep the recorded header stamps instead of stamping messages when sent", 'k',
+                     false);
+
+    if (!parser.parse(argc, argv)) {
+        std::cerr << parser.help() << std::endl;
+        return 1;
+    }
+
+    std::string path;
+    double rate, start;
+    bool keep_stamps = false;
+    if (!parser.get<std::string>("bag", path) || !parser.get<double>("rate", rate) ||
+        !parser.get<double>("start", start) || !parser.get<bool>("keep_stamps", keep_stamps) || rate < 0.0) {
+        std::cerr << "Failed to get arguments." << std::endl;
+        return 1;
+    }
+
+    rix::bag::Reader reader;
+    if (!reader.open(path)) {
+        std::cerr << "Failed to open " << path << ": not a bag." << std::endl;
+        return 1;
+    }
+
+    File output(STDOUT_FILENO);
+    Signal sig(SIGINT);
+
+    geometry::Twist2DStamped cmd;
+    auto records = reader.range(cmd.hash(), reader.start_time() + Duration(start), Time::max());
+
+    // Each record is released one recorded gap (scaled by `rate`) after the
+    // previous one. Precise mode keeps wakeup jitter from adding up over a
+    // long bag, and catching up after a late send preserves the overall pace.
+    // In precise mode the period in effect at a wakeup sets the deadline after
+    // it, so the period is always the gap to the record that follows.
+    Rate pace(Duration(0.0), Rate::Mode::PRECISE, Rate::Overrun::CATCH_UP);
+
+    std::vector<uint8_t> buffer;
+    uint64_t sent = 0;
+    bool first = true;
+    for (auto it = records.begin(); it != records.end() && !sig.is_ready(); first = false) {
+        rix::bag::Record record = *it;
+        ++it;
+        if (rate > 0.0) {
+            Duration gap = it != records.end() ? ((*it).stamp - record.stamp) / rate : Duration(0.0);
+            pace.set_period(gap);
+            if (first) {
+                pace.reset();
+            } else {
+                pace.sleep();
+            }
+        }
+
+        const uint8_t *data = record.data;
+        size_t size = record.size;
+        if (!keep_stamps) {
+            if (!record.deserialize(cmd)) {
+                std::cerr << "Skipping a malformed message at " << record.stamp.to_string() << "." << std::endl;
+                continue;
+            }
+            cmd.header.stamp = Time::now().to_msg();
+            buffer.resize(cmd.size());
+            size_t offset = 0;
+            cmd.serialize(buffer.data(), offset);
+            data = buffer.data();
+            size = offset;
+        }
+
+        uint8_t size_buffer[4];
+        size_t offset = 0;
+        standard::UInt32 size_msg;
+        size_msg.data = static_cast<uint32_t>(size);
+        size_msg.serialize(size_buffer, offset);
+        if (!write_all(output, size_buffer, offset) || !write_all(output, data, size)) {
+            break;
+        }
+        sent++;
+    }
+
+    std::cerr << "Played " << sent << " messages from " << path;
+    if (rate > 0.0 && pace.stats().cycles > 0) {
+        std::cerr << " (max lateness " << pace.stats().max_lateness.to_microseconds() / 1e3 << " ms)";
+    }
+    std::cerr << "." << std::endl;
+}
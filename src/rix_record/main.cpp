@@ -0,0 +1,152 @@
+#include <unistd.h>
+
+#include <csignal>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "rix/bag/writer.hpp"
+#include "rix/ipc/fifo.hpp"
+#include "rix/ipc/file.hpp"
+#include "rix/ipc/signal.hpp"
+#include "rix/msg/geometry/Twist2DStamped.hpp"
+#include "rix/msg/standard/UInt32.hpp"
+#include "rix/util/argument_parser.hpp"
+#include "rix/util/bounded_queue.hpp"
+#include "rix/util/time.hpp"
+
+using namespace rix::ipc;
+using namespace rix::msg;
+using namespace rix::util;
+
+namespace {
+
+constexpr size_t MAX_FRAME_SIZE = 1 << 20;
+
+/**
+ * @brief A message read from the input and the time its last byte arrived.
+ */
+struct Frame {
+    Time stamp;
+    std::vector<uint8_t> data;
+};
+
+bool write_all(const File &output, const uint8_t *data, size_t size) {
+    size_t written = 0;
+    while (written < size) {
+        ssize_t n = output.write(data + written, size - written);
+        if (n <= 0) {
+            return false;
+        }
+        written += n;
+    }
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    ArgumentParser parser("rix_record",
+                          "Copies size-prefixed Twist2DStamped messages from stdin (or a FIFO) to stdout and records "
+                          "them to a bag.");
+    parser.add<std::string>("bag", "Path of the bag to write");
+    parser.add<std::string>("fifo", "Read from this FIFO instead of stdin", 'f', std::string());
+    parser.add<int>("queue", "Messages buffered for the recording thread before new ones are dropped", 'q', 4096);
+
+    if (!parser.parse(argc, argv)) {
+        std::cerr << parser.help() << std::endl;
+        return 1;
+    }
+
+    std::string path, fifo;
+    int queue_size = 0;
+    if (!parser.get<std::string>("bag", path) || !parser.get<std::string>("fifo", fifo) ||
+        !parser.get<int>("queue", queue_size) || queue_size <= 0) {
+        std::cerr << "Failed to get arguments." << std::endl;
+        return 1;
+    }
+
+    rix::bag::Writer writer;
+    rix::bag::Writer::Options options;
+    options.compression = rix::bag::Compression::LZ;
+    options.threads = 1;
+    if (!writer.open(path, options)) {
+        std::cerr << "Failed to create " << path << "." << std::endl;
+        return 1;
+    }
+
+    std::unique_ptr<File> input;
+    if (fifo.empty()) {
+        input = std::make_unique<File>(STDIN_FILENO);
+    } else {
+        input = std::make_unique<Fifo>(fifo, Fifo::Mode::READ);
+    }
+    File output(STDOUT_FILENO);
+    Signal sig(SIGINT);
+
+    // Disk writes happen on their own thread; the live path only queues a
+    // copy of each message and never waits for the recorder
+    BoundedQueue<Frame> frames(static_cast<size_t>(queue_size), OverflowPolicy::DROP_NEWEST);
+    const auto hash = geometry::Twist2DStamped().hash();
+    std::thread recorder([&] {
+        Frame frame;
+        while (frames.wait_pop(frame)) {
+            writer.write(hash, frame.data.data(), frame.data.size(), frame.stamp);
+        }
+    });
+
+    uint8_t buffer[4096];
+    std::vector<uint8_t> pending;  // Bytes of the message being framed
+    bool framing = true;
+    while (!sig.is_ready()) {
+        if (!input->wait_for_readable(Duration(0.1))) {
+            continue;
+        }
+        ssize_t n = input->read(buffer, sizeof(buffer));
+        if (n <= 0) {
+            break;
+        }
+
+        // Forward first so recording adds no latency downstream
+        if (!write_all(output, buffer, n)) {
+            break;
+        }
+        if (!framing) {
+            continue;
+        }
+        Time stamp = Time::now();
+
+        pending.insert(pending.end(), buffer, buffer + n);
+        size_t offset = 0;
+        while (pending.size() - offset >= 4) {
+            standard::UInt32 size_msg;
+            size_t size_offset = offset;
+            size_msg.deserialize(pending.data(), pending.size(), size_offset);
+            if (size_msg.data > MAX_FRAME_SIZE) {
+                std::cerr << "Input is not a stream of size-prefixed messages; recording stopped." << std::endl;
+                framing = false;
+                break;
+            }
+            if (pending.size() - size_offset < size_msg.data) {
+                break;
+            }
+            Frame frame;
+            frame.stamp = stamp;
+            frame.data.assign(pending.begin() + size_offset, pending.begin() + size_offset + size_msg.data);
+            frames.push(std::move(frame));
+            offset = size_offset + size_msg.data;
+        }
+        pending.erase(pending.begin(), pending.begin() + offset);
+    }
+
+    frames.close();
+    recorder.join();
+    uint64_t recorded = writer.count();
+    if (!writer.close()) {
+        std::cerr << "Failed to write " << path << "." << std::endl;
+        return 1;
+    }
+    std::cerr << "Recorded " << recorded << " messages to " << path << " (" << frames.dropped() << " dropped)."
+              << std::endl;
+}
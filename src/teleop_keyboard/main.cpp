@@ -4,6 +4,7 @@
 #include "rix/msg/geometry/Twist2DStamped.hpp"
 #include "rix/msg/standard/UInt32.hpp"
 #include "rix/util/argument_parser.hpp"
+#include "rix/util/profile.hpp"
 #include "rix/util/time.hpp"
 #include "teleop_keyboard/teleop_keyboard.hpp"
 
@@ -40,4 +41,6 @@ int main(int argc, char **argv) {
 
     auto notif = std::make_unique<Signal>(SIGINT);
     teleop_keyboard.spin(std::move(notif));
+
+    Profiler::dump(std::cerr);
 }
\ No newline at end of file
@@ -48,14 +48,17 @@ void TeleopKeyboard::spin(std::unique_ptr<rix::ipc::interfaces::Notification> no
         // Serialize message size and data
         uint8_t msg_buffer[4096];
         size_t offset = 0;
+        {
+            RIX_PROFILE_SCOPE("teleop_keyboard.serialize");
 
-        // First serialize the size
-        standard::UInt32 size_msg;
-        size_msg.data = cmd.size();
-        size_msg.serialize(msg_buffer, offset);
+            // First serialize the size
+            standard::UInt32 size_msg;
+            size_msg.data = cmd.size();
+            size_msg.serialize(msg_buffer, offset);
 
-        // Then serialize the message
-        cmd.serialize(msg_buffer, offset);
+            // Then serialize the message
+            cmd.serialize(msg_buffer, offset);
+        }
 
         // Write to stdout
         output->write(msg_buffer, offset);
@@ -0,0 +1,229 @@
+#include "rix/util/async_log.hpp"
+
+#include <algorithm>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "rix/util/clock.hpp"
+#include "rix/util/log.hpp"
+
+using namespace rix::util;
+
+namespace {
+
+std::string record(int thread, int line) { return "t=" + std::to_string(thread) + " i=" + std::to_string(line) + "\n"; }
+
+/**
+ * @brief Checks that `out` holds `lines` records from each of `threads`
+ * threads, each thread's in the order it pushed them. Other lines, such as
+ * headers and drop reports, are skipped unless they hold a record.
+ */
+void expect_per_thread_order(const std::string &out, int threads, int lines) {
+    std::vector<int> next(threads, 0);
+    std::istringstream ss(out);
+    std::string line;
+    while (std::getline(ss, line)) {
+        size_t pos = line.find("t=");
+        if (pos == std::string::npos) {
+            continue;
+        }
+        int t = line[pos + 2] - '0';
+        ASSERT_GE(t, 0);
+        ASSERT_LT(t, threads);
+        ASSERT_EQ(line.substr(pos) + "\n", record(t, next[t])) << line;
+        next[t]++;
+    }
+    EXPECT_EQ(next, std::vector<int>(threads, lines));
+}
+
+}  // namespace
+
+TEST(LogRing, FullRingDropsAndCounts) {
+    detail::LogRing ring(16);
+    std::string record(10, 'a');
+    EXPECT_TRUE(ring.push(record.data(), record.size()));
+    EXPECT_FALSE(ring.push(record.data(), record.size()));
+    EXPECT_FALSE(ring.push(record.data(), record.size()));
+    EXPECT_EQ(ring.take_dropped(), 2);
+    EXPECT_EQ(ring.take_dropped(), 0);
+
+    // Draining frees the space, including across the wrap
+    std::string out;
+    EXPECT_EQ(ring.drain(out), 10);
+    std::string wrapped = "0123456789";
+    EXPECT_TRUE(ring.push(wrapped.data(), wrapped.size()));
+    out.clear();
+    EXPECT_EQ(ring.drain(out), 10);
+    EXPECT_EQ(out, wrapped);
+    EXPECT_TRUE(ring.empty());
+}
+
+TEST(AsyncLogWriter, DrainsEveryThreadInOrder) {
+    const int threads = 4, lines = 500;
+    std::stringbuf target;
+    detail::AsyncLogWriter writer;
+    writer.start(&target);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&, t] {
+            for (int i = 0; i < lines; i++) {
+                std::string line = record(t, i);
+                ASSERT_TRUE(writer.ring().push(line.data(), line.size()));
+            }
+        });
+    }
+    for (auto &worker : workers) {
+        worker.join();
+    }
+    writer.stop();
+    expect_per_thread_order(target.str(), threads, lines);
+}
+
+TEST(AsyncLogWriter, ReportsDroppedRecords) {
+    std::stringbuf target;
+    uint64_t reported = 0;
+    detail::AsyncLogWriter writer([&](std::string &batch, uint64_t dropped) {
+        reported += dropped;
+        if (dropped > 0) {
+            batch += "dropped\n";
+        }
+    });
+    writer.start(&target, 64, Duration(0.05));
+
+    // Whenever the writer drains, the pushes that failed before it are the
+    // drops it reports
+    std::string line(40, 'a');
+    line.back() = '\n';
+    int pushed = 0, dropped = 0;
+    for (int i = 0; i < 100; i++) {
+        writer.ring().push(line.data(), line.size()) ? pushed++ : dropped++;
+    }
+    writer.stop();
+
+    EXPECT_GT(dropped, 0);
+    EXPECT_EQ(reported, static_cast<uint64_t>(dropped));
+    std::string out = target.str();
+    EXPECT_EQ(std::count(out.begin(), out.end(), 'a'), 39 * pushed);
+    EXPECT_NE(out.find("dropped\n"), std::string::npos);
+}
+
+TEST(AsyncLogWriter, DefaultFinisherReportsDrops) {
+    std::stringbuf target;
+    detail::AsyncLogWriter writer;
+    writer.start(&target, 16, Duration(0.05));
+    std::string line(10, 'a');
+    int dropped = 0;
+    for (int i = 0; i < 10; i++) {
+        dropped += !writer.ring().push(line.data(), line.size());
+    }
+    writer.stop();
+    ASSERT_GT(dropped, 0);
+    EXPECT_NE(target.str().find("records dropped"), std::string::npos);
+}
+
+TEST(AsyncLogWriter, FlushAndStopWritePendingRecords) {
+    std::stringbuf target;
+    detail::AsyncLogWriter writer;
+    writer.start(&target, 1 << 16, Duration(0.2));
+
+    // The writer thread most likely sleeps through these, but whether or not
+    // it drains them, they must all be out once `flush` returns
+    for (int i = 0; i < 10; i++) {
+        std::string line = record(0, i);
+        writer.ring().push(line.data(), line.size());
+    }
+    writer.flush();
+    expect_per_thread_order(target.str(), 1, 10);
+
+    for (int i = 10; i < 20; i++) {
+        std::string line = record(0, i);
+        writer.ring().push(line.data(), line.size());
+    }
+    writer.stop();
+    EXPECT_FALSE(writer.running());
+    expect_per_thread_order(target.str(), 1, 20);
+}
+
+TEST(AsyncLogWriter, WriterAtReusedAddressGetsItsOwnRing) {
+    std::stringbuf first_target, second_target;
+    std::optional<detail::AsyncLogWriter> writer;
+    writer.emplace();
+    writer->start(&first_target);
+    std::string first = record(0, 0);
+    writer->ring().push(first.data(), first.size());
+    writer.reset();
+    EXPECT_EQ(first_target.str(), first);
+
+    // Built in the same storage, so at the same address as the first writer
+    writer.emplace();
+    writer->start(&second_target);
+    std::string second = record(0, 1);
+    writer->ring().push(second.data(), second.size());
+    writer->stop();
+    EXPECT_EQ(second_target.str(), second);
+}
+
+TEST(AsyncLogWriter, RestartUsesNewRingCapacity) {
+    std::stringbuf target;
+    detail::AsyncLogWriter writer;
+    writer.start(&target, 16);
+    std::string line(10, 'a');
+    EXPECT_TRUE(writer.ring().push(line.data(), line.size()));
+    EXPECT_FALSE(writer.ring().push(line.data(), line.size()));
+    writer.stop();
+
+    writer.start(&target, 1 << 10);
+    for (int i = 0; i < 10; i++) {
+        EXPECT_TRUE(writer.ring().push(line.data(), line.size()));
+    }
+    writer.stop();
+    std::string out = target.str();
+    EXPECT_EQ(std::count(out.begin(), out.end(), 'a'), 110);
+}
+
+TEST(AsyncLogWriter, RunsAndStopsOnSimulatedClock) {
+    SimulatedClock::start(Time(1000.0));
+    std::stringbuf target;
+    detail::AsyncLogWriter writer;
+    writer.start(&target, 1 << 16, Duration(0.001));
+
+    // The writer drains on its own without simulated time passing, and never
+    // waits for it
+    std::string line = record(0, 0);
+    writer.ring().push(line.data(), line.size());
+    for (int i = 0; i < 2000 && !writer.ring().empty(); i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_TRUE(writer.ring().empty());
+    EXPECT_EQ(SimulatedClock::waiting(), 0);
+
+    writer.stop();
+    EXPECT_FALSE(writer.running());
+    EXPECT_EQ(target.str(), line);
+    SimulatedClock::stop();
+}
+
+TEST(AsyncLogWriter, LogInitAsync) {
+    const int threads = 4, lines = 200;
+    testing::internal::CaptureStdout();
+    Log::init("async_log_test", false, true);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([t] {
+            for (int i = 0; i < lines; i++) {
+                Log::info << "t=" << t << " i=" << i << std::endl;
+            }
+        });
+    }
+    for (auto &worker : workers) {
+        worker.join();
+    }
+    Log::flush();
+    std::cout.flush();
+    expect_per_thread_order(testing::internal::GetCapturedStdout(), threads, lines);
+}
@@ -0,0 +1,438 @@
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "rix/bag/lz.hpp"
+#include "rix/bag/reader.hpp"
+#include "rix/bag/writer.hpp"
+#include "rix/msg/geometry/Twist2DStamped.hpp"
+#include "rix/msg/standard/UInt32.hpp"
+
+#include "bag_test_util.hpp"
+
+using namespace rix;
+using rix::msg::geometry::Twist2DStamped;
+using rix::msg::standard::UInt32;
+using rix::bag::test::at;
+using rix::bag::test::twist;
+
+namespace {
+
+class BagTest : public bag::test::TempFileTest {
+   protected:
+    /**
+     * @brief Writes `n` twists stamped 0..n-1 ms, with a UInt32 after every
+     * tenth, in chunks of about `chunk_size` bytes.
+     */
+    void write_bag(int n, size_t chunk_size = 1 << 20) {
+        bag::Writer::Options options;
+        options.chunk_size = chunk_size;
+        write_bag(n, options);
+    }
+
+    void write_bag(int n, const bag::Writer::Options &options) {
+        bag::Writer writer;
+        ASSERT_TRUE(writer.open(path, options));
+        for (int i = 0; i < n; i++) {
+            ASSERT_TRUE(writer.write(twist(i), at(i)));
+            if (i % 10 == 0) {
+                UInt32 count;
+                count.data = i;
+                ASSERT_TRUE(writer.write(count, at(i)));
+            }
+        }
+        ASSERT_TRUE(writer.close());
+    }
+};
+
+}  // namespace
+
+TEST_F(BagTest, RoundTrip) {
+    write_bag(100);
+    bag::Reader reader;
+    ASSERT_TRUE(reader.open(path));
+    EXPECT_TRUE(reader.indexed());
+    ASSERT_EQ(reader.size(), 110);
+    EXPECT_EQ(reader.start_time(), at(0));
+    EXPECT_EQ(reader.end_time(), at(99));
+
+    // Twist 0, UInt32 0, twist 1, ..., in write order for equal stamps
+    bag::Record first = reader.record(0);
+    Twist2DStamped cmd;
+    ASSERT_TRUE(first.deserialize(cmd));
+    EXPECT_EQ(cmd.header.frame_id, "mbot");
+    EXPECT_EQ(first.stamp, at(0));
+
+    UInt32 count;
+    EXPECT_FALSE(first.deserialize(count));
+    ASSERT_TRUE(reader.record(1).deserialize(count));
+    EXPECT_EQ(count.data, 0);
+}
+
+TEST_F(BagTest, RandomAccessAcrossChunks) {
+    write_bag(1000, 512);
+    bag::Reader reader;
+    ASSERT_TRUE(reader.open(path));
+    EXPECT_GT(reader.chunks(), 10);
+
+    for (int i : {999, 0, 500, 37, 731}) {
+        size_t pos = reader.lower_bound(at(i));
+        Twist2DStamped cmd;
+        ASSERT_TRUE(reader.record(pos).deserialize(cmd)) << i;
+        Twist2DStamped expected = twist(i);
+        EXPECT_EQ(cmd.header.seq, expected.header.seq);
+        EXPECT_EQ(cmd.twist.vx, expected.twist.vx);
+        EXPECT_EQ(cmd.twist.wz, expected.twist.wz);
+    }
+}
+
+TEST_F(BagTest, TimeRanges) {
+    write_bag(1000, 4096);
+    bag::Reader reader;
+    ASSERT_TRUE(reader.open(path));
+
+    int n = 0;
+    util::Time last = at(0);
+    for (const bag::Record &record : reader.range(at(100), at(200))) {
+        EXPECT_GE(record.stamp, at(100));
+        EXPECT_LT(record.stamp, at(200));
+        EXPECT_GE(record.stamp, last);
+        last = record.stamp;
+        n++;
+    }
+    EXPECT_EQ(n, 110);
+
+    n = 0;
+    for (const bag::Record &record : reader.range(UInt32().hash(), at(100), at(200))) {
+        UInt32 count;
+        ASSERT_TRUE(record.deserialize(count));
+        EXPECT_EQ(count.data % 10, 0);
+        n++;
+    }
+    EXPECT_EQ(n, 10);
+
+    auto empty = reader.range(at(2000), at(3000));
+    EXPECT_EQ(empty.begin(), empty.end());
+}
+
+TEST_F(BagTest, OutOfOrderStamps) {
+    {
+        bag::Writer writer;
+        ASSERT_TRUE(writer.open(path));
+        for (int i : {5, 3, 9, 1, 3}) {
+            UInt32 value;
+            value.data = i;
+            writer.write(value, at(i));
+        }
+    }
+    bag::Reader reader;
+    ASSERT_TRUE(reader.open(path));
+    std::vector<uint32_t> values;
+    for (const bag::Record &record : reader.range(at(0), at(10))) {
+        UInt32 value;
+        ASSERT_TRUE(record.deserialize(value));
+        values.push_back(value.data);
+    }
+    EXPECT_EQ(values, (std::vector<uint32_t>{1, 3, 3, 5, 9}));
+}
+
+TEST(LzTest, RoundTrip) {
+    std::mt19937 rng(7);
+    std::vector<std::vector<uint8_t>> inputs;
+    inputs.push_back({});
+    inputs.push_back({1, 2, 3});
+    inputs.push_back(std::vector<uint8_t>(100000, 'a'));  // One long, overlapping match
+    std::vector<uint8_t> random(5000);
+    for (auto &b : random) {
+        b = static_cast<uint8_t>(rng());
+    }
+    inputs.push_back(random);
+    std::vector<uint8_t> text;
+    while (text.size() < 200000) {
+        std::string line = "seq=" + std::to_string(rng() % 1000) + " frame_id=mbot vx=0.25 wz=-1.5\n";
+        text.insert(text.end(), line.begin(), line.end());
+    }
+    inputs.push_back(text);
+
+    for (const auto &input : inputs) {
+        std::vector<uint8_t> compressed(bag::lz::compress_bound(input.size()));
+        size_t size = bag::lz::compress(input.data(), input.size(), compressed.data(), compressed.size());
+        ASSERT_GT(size, 0) << input.size();
+        std::vector<uint8_t> output(input.size());
+        ASSERT_TRUE(bag::lz::decompress(compressed.data(), size, output.data(), output.size())) << input.size();
+        EXPECT_EQ(output, input);
+
+        if (!input.empty()) {
+            // Truncated blocks and wrong sizes are rejected, not overrun
+            EXPECT_FALSE(bag::lz::decompress(compressed.data(), size - 1, output.data(), output.size()));
+            EXPECT_FALSE(bag::lz::decompress(compressed.data(), size, output.data(), output.size() - 1));
+        }
+    }
+
+    std::vector<uint8_t> compressed(bag::lz::compress_bound(text.size()));
+    EXPECT_LT(bag::lz::compress(text.data(), text.size(), compressed.data(), compressed.size()), text.size() / 3);
+    EXPECT_EQ(bag::lz::compress(text.data(), text.size(), compressed.data(), 100), 0);
+}
+
+TEST_F(BagTest, CompressedMatchesUncompressed) {
+    write_bag(2000, 2048);
+    std::string plain = temp_file();
+    ASSERT_EQ(rename(path.c_str(), plain.c_str()), 0);
+
+    bag::Writer::Options options;
+    options.chunk_size = 2048;
+    options.compression = bag::Compression::LZ;
+    options.threads = 3;
+    options.max_pending = 8192;  // Make the writer wait for the workers
+    write_bag(2000, options);
+
+    struct stat plain_st, compressed_st;
+    ASSERT_EQ(stat(plain.c_str(), &plain_st), 0);
+    ASSERT_EQ(stat(path.c_str(), &compressed_st), 0);
+    EXPECT_LT(compressed_st.st_size, plain_st.st_size * 3 / 4);  // The index is not compressed
+
+    bag::Reader expected, reader;
+    ASSERT_TRUE(expected.open(plain));
+    bag::Reader::Options reader_options;
+    reader_options.cache_chunks = 4;
+    reader_options.readahead = 3;
+    ASSERT_TRUE(reader.open(path, reader_options));
+    ASSERT_EQ(reader.size(), expected.size());
+    EXPECT_EQ(reader.chunks(), expected.chunks());
+
+    // Forward, then backward to defeat the read-ahead
+    for (size_t i = 0; i < reader.size(); i++) {
+        bag::Record a = expected.record(i), b = reader.record(i);
+        ASSERT_NE(b.data, nullptr) << i;
+        EXPECT_EQ(b.stamp, a.stamp);
+        ASSERT_EQ(std::vector<uint8_t>(b.data, b.data + b.size), std::vector<uint8_t>(a.data, a.data + a.size));
+    }
+    for (size_t i = reader.size(); i-- > 0;) {
+        ASSERT_EQ(reader.record(i).size, expected.record(i).size) << i;
+    }
+
+    // A record keeps its decompressed chunk alive past eviction and close
+    bag::Record kept = reader.record(0);
+    Twist2DStamped cmd;
+    reader.close();
+    ASSERT_TRUE(kept.deserialize(cmd));
+    EXPECT_EQ(cmd.header.seq, 0);
+}
+
+TEST_F(BagTest, DeltaChunksMatchUncompressed) {
+    write_bag(2000, 4096);
+    std::string plain = temp_file();
+    ASSERT_EQ(rename(path.c_str(), plain.c_str()), 0);
+
+    bag::Writer::Options options;
+    options.chunk_size = 4096;
+    options.compression = bag::Compression::LZ;
+    write_bag(2000, options);
+    struct stat lz_st;
+    ASSERT_EQ(stat(path.c_str(), &lz_st), 0);
+
+    options.compression = bag::Compression::DELTA_LZ;
+    options.threads = 2;
+    write_bag(2000, options);
+    struct stat delta_st;
+    ASSERT_EQ(stat(path.c_str(), &delta_st), 0);
+    EXPECT_LT(delta_st.st_size, lz_st.st_size);
+
+    bag::Reader expected, reader;
+    ASSERT_TRUE(expected.open(plain));
+    ASSERT_TRUE(reader.open(path));
+    ASSERT_EQ(reader.size(), expected.size());
+    for (size_t i = 0; i < reader.size(); i++) {
+        bag::Record a = expected.record(i), b = reader.record(i);
+        ASSERT_NE(b.data, nullptr) << i;
+        EXPECT_EQ(b.stamp, a.stamp);
+        EXPECT_EQ(b.hash, a.hash);
+        ASSERT_EQ(std::vector<uint8_t>(b.data, b.data + b.size), std::vector<uint8_t>(a.data, a.data + a.size));
+    }
+
+    // Scans decode the chunks themselves
+    std::atomic<size_t> count = 0;
+    std::atomic<uint64_t> seqs = 0;
+    reader.for_each<Twist2DStamped>(util::Time(), util::Time::max(),
+                                    [&](const Twist2DStamped &cmd, const bag::Record &, size_t) {
+                                        count++;
+                                        seqs += cmd.header.seq;
+                                    });
+    EXPECT_EQ(count, 2000);
+    EXPECT_EQ(seqs, 1999 * 2000 / 2);
+
+    // So does rebuilding the index
+    reader.close();
+    ASSERT_EQ(truncate(path.c_str(), delta_st.st_size - sizeof(bag::detail::Footer)), 0);
+    ASSERT_TRUE(reader.open(path));
+    EXPECT_FALSE(reader.indexed());
+    EXPECT_EQ(reader.size(), 2200);
+    Twist2DStamped cmd;
+    ASSERT_TRUE(reader.record(reader.lower_bound(at(1234))).deserialize(cmd));
+    EXPECT_EQ(cmd.header.seq, 1234);
+}
+
+TEST_F(BagTest, DeltaChunksWithLongFrameId) {
+    // A repeated frame id costs nothing in the delta form but its full length
+    // in every restored record
+    const std::string frame_id(4096, 'f');
+    bag::Writer::Options options;
+    options.compression = bag::Compression::DELTA_LZ;
+    bag::Writer writer;
+    ASSERT_TRUE(writer.open(path, options));
+    for (int i = 0; i < 200; i++) {
+        Twist2DStamped cmd = twist(i);
+        cmd.header.frame_id = frame_id;
+        ASSERT_TRUE(writer.write(cmd, at(i)));
+    }
+    ASSERT_TRUE(writer.close());
+
+    bag::Reader reader;
+    ASSERT_TRUE(reader.open(path));
+    ASSERT_EQ(reader.size(), 200);
+    for (size_t i = 0; i < reader.size(); i++) {
+        Twist2DStamped cmd;
+        ASSERT_TRUE(reader.record(i).deserialize(cmd)) << i;
+        EXPECT_EQ(cmd.header.seq, i);
+        EXPECT_EQ(cmd.header.frame_id, frame_id);
+    }
+}
+
+TEST_F(BagTest, ConcurrentCompressedReads) {
+    bag::Writer::Options options;
+    options.chunk_size = 1024;
+    options.compression = bag::Compression::LZ;
+    options.threads = 2;
+    write_bag(1000, options);
+
+    bag::Reader::Options reader_options;
+    reader_options.cache_chunks = 3;
+    bag::Reader reader;
+    ASSERT_TRUE(reader.open(path, reader_options));
+    std::vector<std::thread> threads;
+    std::vector<int> counts(4, 0);
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&, t] {
+            for (const bag::Record &record : reader.range(Twist2DStamped().hash(), at(t * 100), at(1000))) {
+                Twist2DStamped cmd;
+                if (record.deserialize(cmd) && record.stamp == at(cmd.header.seq)) {
+                    counts[t]++;
+                }
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(counts, (std::vector<int>{1000, 900, 800, 700}));
+}
+
+TEST_F(BagTest, ParallelForEach) {
+    bag::Writer::Options options;
+    options.chunk_size = 1024;
+    options.compression = bag::Compression::LZ;
+    write_bag(1000, options);
+
+    bag::Reader::Options reader_options;
+    reader_options.threads = 4;
+    bag::Reader reader;
+    ASSERT_TRUE(reader.open(path, reader_options));
+    ASSERT_EQ(reader.workers(), 4);
+
+    // Per-worker sums need no locking
+    std::vector<uint64_t> sums(reader.workers(), 0);
+    std::vector<int> mismatches(reader.workers(), 0);
+    size_t n = reader.for_each<Twist2DStamped>(
+        at(100), at(900), [&](const Twist2DStamped &cmd, const bag::Record &record, size_t worker) {
+            sums[worker] += cmd.header.seq;
+            mismatches[worker] += record.stamp != at(cmd.header.seq) || cmd.header.frame_id != "mbot";
+        });
+    EXPECT_EQ(n, 800);
+    uint64_t sum = 0;
+    for (size_t w = 0; w < sums.size(); w++) {
+        sum += sums[w];
+        EXPECT_EQ(mismatches[w], 0);
+    }
+    EXPECT_EQ(sum, (100 + 899) * 800 / 2);
+
+    std::atomic<int> counts(0);
+    size_t visited = reader.for_each(UInt32().hash(), at(100), at(900), [&](const bag::Record &record, size_t) {
+        UInt32 count;
+        if (record.deserialize(count) && count.data % 10 == 0) {
+            counts++;
+        }
+    });
+    EXPECT_EQ(visited, 80);
+    EXPECT_EQ(counts.load(), 80);
+    EXPECT_EQ(reader.for_each(UInt32().hash(), at(2000), at(3000), [](const bag::Record &, size_t) {}), 0);
+}
+
+TEST_F(BagTest, RebuildsMissingIndex) {
+    write_bag(500, 1024);
+    size_t full;
+    {
+        bag::Reader reader;
+        ASSERT_TRUE(reader.open(path));
+        full = reader.size();
+    }
+
+    // Drop the footer and tear the last chunk, as after a crash
+    struct stat st;
+    ASSERT_EQ(stat(path.c_str(), &st), 0);
+    ASSERT_EQ(truncate(path.c_str(), st.st_size - 500 * 32 - 20), 0);
+
+    bag::Reader reader;
+    ASSERT_TRUE(reader.open(path));
+    EXPECT_FALSE(reader.indexed());
+    EXPECT_GT(reader.size(), 0);
+    EXPECT_LE(reader.size(), full);
+    for (size_t i = 0; i < reader.size(); i++) {
+        ASSERT_NE(reader.record(i).data, nullptr);
+    }
+}
+
+TEST_F(BagTest, RebuildsCompressedIndex) {
+    bag::Writer::Options options;
+    options.chunk_size = 1024;
+    options.compression = bag::Compression::LZ;
+    write_bag(500, options);
+
+    struct stat st;
+    ASSERT_EQ(stat(path.c_str(), &st), 0);
+    ASSERT_EQ(truncate(path.c_str(), st.st_size - sizeof(bag::detail::Footer)), 0);
+
+    bag::Reader reader;
+    ASSERT_TRUE(reader.open(path));
+    EXPECT_FALSE(reader.indexed());
+    EXPECT_EQ(reader.size(), 550);
+    Twist2DStamped cmd;
+    ASSERT_TRUE(reader.record(reader.lower_bound(at(321))).deserialize(cmd));
+    EXPECT_EQ(cmd.header.seq, 321);
+}
+
+TEST_F(BagTest, Empty) {
+    write_bag(0);
+    bag::Reader reader;
+    ASSERT_TRUE(reader.open(path));
+    EXPECT_EQ(reader.size(), 0);
+    EXPECT_EQ(reader.record(0).data, nullptr);
+    auto all = reader.range(at(0), at(1000));
+    EXPECT_EQ(all.begin(), all.end());
+}
+
+TEST_F(BagTest, RejectsOtherFiles) {
+    FILE *f = fopen(path.c_str(), "w");
+    fputs("not a bag at all, but long enough", f);
+    fclose(f);
+    bag::Reader reader;
+    EXPECT_FALSE(reader.open(path));
+    EXPECT_FALSE(reader.open("/nonexistent/bag"));
+}
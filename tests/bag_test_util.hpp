@@ -0,0 +1,74 @@
+#pragma once
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "rix/msg/geometry/Twist2DStamped.hpp"
+#include "rix/util/time.hpp"
+
+namespace rix {
+namespace bag {
+namespace test {
+
+/**
+ * @brief Returns the time `ms` milliseconds after the epoch.
+ */
+inline util::Time at(int64_t ms) { return util::Time(util::Time::Type(std::chrono::milliseconds(ms))); }
+
+/**
+ * @brief Returns the `seq`th test command. Its header is stamped
+ * `header_delay_ms` after `at(seq)`.
+ */
+inline msg::geometry::Twist2DStamped twist(uint32_t seq, int64_t header_delay_ms = 0) {
+    msg::geometry::Twist2DStamped cmd;
+    cmd.header.seq = seq;
+    cmd.header.frame_id = "mbot";
+    cmd.header.stamp = at(seq + header_delay_ms).to_msg();
+    cmd.twist.vx = 0.5f * seq;
+    cmd.twist.vy = -0.25f;
+    cmd.twist.wz = 1.0f / (seq + 1);
+    return cmd;
+}
+
+/**
+ * @brief A fixture that provides temporary files and removes them in
+ * `TearDown`, even when a test fails partway.
+ */
+class TempFileTest : public ::testing::Test {
+   protected:
+    void SetUp() override { path = temp_file(); }
+
+    void TearDown() override {
+        for (const auto &file : files_) {
+            unlink(file.c_str());
+        }
+    }
+
+    /**
+     * @brief Creates another empty temporary file.
+     */
+    std::string temp_file() {
+        char templ[] = "/tmp/rix_bag_XXXXXX";
+        int fd = mkstemp(templ);
+        EXPECT_GE(fd, 0);
+        if (fd >= 0) {
+            close(fd);
+        }
+        files_.push_back(templ);
+        return templ;
+    }
+
+    std::string path;  ///< A temporary file created for every test
+
+   private:
+    std::vector<std::string> files_;
+};
+
+}  // namespace test
+}  // namespace bag
+}  // namespace rix
@@ -0,0 +1,117 @@
+#include "rix/util/bounded_queue.hpp"
+
+#include <string>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+using namespace rix::util;
+
+TEST(BoundedQueue, FifoOrder) {
+    BoundedQueue<int> q(4);
+    EXPECT_EQ(q.capacity(), 4);
+    for (int i = 0; i < 4; i++) {
+        EXPECT_TRUE(q.try_push(int(i)));
+    }
+    EXPECT_FALSE(q.try_push(4));
+    int v;
+    for (int i = 0; i < 4; i++) {
+        ASSERT_TRUE(q.try_pop(v));
+        EXPECT_EQ(v, i);
+    }
+    EXPECT_FALSE(q.try_pop(v));
+}
+
+TEST(BoundedQueue, CapacityIsRoundedUp) {
+    EXPECT_EQ(BoundedQueue<int>(0).capacity(), 2);
+    EXPECT_EQ(BoundedQueue<int>(1).capacity(), 2);
+    EXPECT_EQ(BoundedQueue<int>(5).capacity(), 8);
+}
+
+TEST(BoundedQueue, DropNewest) {
+    BoundedQueue<int> q(2, OverflowPolicy::DROP_NEWEST);
+    EXPECT_TRUE(q.push(1));
+    EXPECT_TRUE(q.push(2));
+    EXPECT_FALSE(q.push(3));
+    EXPECT_EQ(q.dropped(), 1);
+    int v;
+    q.try_pop(v);
+    EXPECT_EQ(v, 1);
+}
+
+TEST(BoundedQueue, DropOldest) {
+    BoundedQueue<int> q(2, OverflowPolicy::DROP_OLDEST);
+    for (int i = 1; i <= 5; i++) {
+        EXPECT_TRUE(q.push(i));
+    }
+    EXPECT_EQ(q.dropped(), 3);
+    int v;
+    q.try_pop(v);
+    EXPECT_EQ(v, 4);
+    q.try_pop(v);
+    EXPECT_EQ(v, 5);
+}
+
+TEST(BoundedQueue, KeepLatest) {
+    BoundedQueue<std::string> q(8, OverflowPolicy::KEEP_LATEST);
+    q.push("a");
+    q.push("b");
+    q.push("c");
+    EXPECT_EQ(q.dropped(), 2);
+    std::string v;
+    ASSERT_TRUE(q.try_pop(v));
+    EXPECT_EQ(v, "c");
+    EXPECT_FALSE(q.try_pop(v));
+}
+
+TEST(BoundedQueue, CloseWakesConsumer) {
+    BoundedQueue<int> q(4);
+    std::thread consumer([&] {
+        int v;
+        EXPECT_TRUE(q.wait_pop(v));
+        EXPECT_EQ(v, 7);
+        EXPECT_FALSE(q.wait_pop(v));
+    });
+    q.push(7);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    q.close();
+    consumer.join();
+    EXPECT_FALSE(q.push(8));
+}
+
+TEST(BoundedQueue, ProducerConsumer) {
+    const int n = 200000;
+    BoundedQueue<int> q(64);
+    std::thread producer([&] {
+        for (int i = 0; i < n; i++) {
+            q.push(i);
+        }
+        q.close();
+    });
+    int expected = 0, v;
+    while (q.wait_pop(v)) {
+        ASSERT_EQ(v, expected++);
+    }
+    producer.join();
+    EXPECT_EQ(expected, n);
+}
+
+TEST(BoundedQueue, ProducerEvictsWhileConsuming) {
+    const int n = 200000;
+    BoundedQueue<int> q(8, OverflowPolicy::DROP_OLDEST);
+    std::thread producer([&] {
+        for (int i = 0; i < n; i++) {
+            q.push(i);
+        }
+        q.close();
+    });
+    int last = -1, received = 0, v;
+    while (q.wait_pop(v)) {
+        ASSERT_GT(v, last);
+        last = v;
+        received++;
+    }
+    producer.join();
+    EXPECT_EQ(last, n - 1);
+    EXPECT_EQ(received + q.dropped(), n);
+}
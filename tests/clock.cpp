@@ -0,0 +1,165 @@
+#include "rix/util/clock.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "rix/util/scheduler.hpp"
+
+using namespace rix::util;
+
+namespace {
+
+int64_t system_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+const ClockSource SOURCES[] = {ClockSource::SYSTEM, ClockSource::MONOTONIC, ClockSource::MONOTONIC_RAW,
+                               ClockSource::REALTIME_COARSE, ClockSource::TSC};
+
+class ClockTest : public ::testing::TestWithParam<ClockSource> {
+   protected:
+    void SetUp() override {
+        if (!clock_source_available(GetParam())) {
+            GTEST_SKIP() << clock_source_name(GetParam()) << " is not available";
+        }
+        ASSERT_TRUE(set_clock_source(GetParam(), Duration(0.01)));
+    }
+
+    void TearDown() override {
+        detail::offset_realtime(Duration(0.0));
+        set_clock_source(ClockSource::SYSTEM);
+    }
+
+    bool anchored() const {
+        return GetParam() == ClockSource::MONOTONIC || GetParam() == ClockSource::MONOTONIC_RAW ||
+               GetParam() == ClockSource::TSC;
+    }
+};
+
+/**
+ * @brief Reads the clock for `seconds` and returns how often it went back.
+ */
+int count_backwards(double seconds) {
+    Time last = Time::now();
+    Time end = last + Duration(seconds);
+    int backwards = 0;
+    while (last < end) {
+        Time now = Time::now();
+        if (now < last) {
+            backwards++;
+        }
+        last = now;
+    }
+    return backwards;
+}
+
+}  // namespace
+
+TEST_P(ClockTest, Selected) { EXPECT_EQ(clock_source(), GetParam()); }
+
+TEST_P(ClockTest, TracksSystemClock) {
+    // The coarse clock lags by up to one scheduler tick
+    const int64_t tolerance = GetParam() == ClockSource::REALTIME_COARSE ? 20'000'000 : 2'000'000;
+    for (int i = 0; i < 20; i++) {
+        int64_t before = system_ns();
+        int64_t now = Time::now().to_nanoseconds();
+        int64_t after = system_ns();
+        EXPECT_GT(now, before - tolerance);
+        EXPECT_LT(now, after + tolerance);
+        sleep_for(Duration(0.005));
+    }
+}
+
+TEST_P(ClockTest, NeverGoesBackwards) {
+    // Re-anchoring every 10 ms happens several times during this loop
+    EXPECT_EQ(count_backwards(0.05), 0);
+}
+
+TEST_P(ClockTest, NeverGoesBackwardsWhenSystemTimeStepsBack) {
+    if (!anchored()) {
+        GTEST_SKIP() << "only the anchored sources re-anchor";
+    }
+    int64_t ahead = Time::now().to_nanoseconds() - system_ns();
+    detail::offset_realtime(Duration(-1.0));
+    EXPECT_EQ(count_backwards(0.05), 0);
+
+    // Slewed at most 500 ppm, so still about as far ahead of SYSTEM as before
+    int64_t lag = Time::now().to_nanoseconds() - system_ns() - ahead;
+    EXPECT_GT(lag, -50'000'000);
+    EXPECT_LT(lag, 50'000'000);
+}
+
+TEST_P(ClockTest, FollowsSystemTimeStepsForward) {
+    if (!anchored()) {
+        GTEST_SKIP() << "only the anchored sources re-anchor";
+    }
+    detail::offset_realtime(Duration(1.0));
+    EXPECT_EQ(count_backwards(0.05), 0);
+    int64_t lead = Time::now().to_nanoseconds() - system_ns();
+    EXPECT_GT(lead, 900'000'000);
+    EXPECT_LT(lead, 1'100'000'000);
+}
+
+TEST_P(ClockTest, WaitsOnSourceTimeWhenAheadOfSystemTime) {
+    if (!anchored()) {
+        GTEST_SKIP() << "only the anchored sources re-anchor";
+    }
+    // The source now runs ten seconds ahead of CLOCK_REALTIME, as it does
+    // after the system time steps back
+    detail::offset_realtime(Duration(10.0));
+    count_backwards(0.05);
+    ASSERT_GT(Time::now().to_nanoseconds() - system_ns(), 9'000'000'000);
+
+    auto start = std::chrono::steady_clock::now();
+    sleep_until(Time::now() + Duration(0.05));
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(1));
+
+    Rate rate(Duration(0.05), Rate::Mode::PRECISE);
+    start = std::chrono::steady_clock::now();
+    EXPECT_TRUE(rate.sleep());
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(1));
+
+    std::atomic<bool> ran{false};
+    Scheduler scheduler;
+    start = std::chrono::steady_clock::now();
+    scheduler.add(Duration(1.0), [&ran] { ran = true; }, Duration(0.05));
+    while (!ran && std::chrono::steady_clock::now() - start < std::chrono::seconds(5)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_TRUE(ran);
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(1));
+}
+
+TEST_P(ClockTest, MeasuresIntervals) {
+    Time start = Time::now();
+    sleep_for(Duration(0.05));
+    double elapsed = (Time::now() - start).to_nanoseconds() * 1e-9;
+    // Each read of the coarse clock may lag by up to one scheduler tick
+    const double tolerance = GetParam() == ClockSource::REALTIME_COARSE ? 0.02 : 0.005;
+    EXPECT_GE(elapsed, 0.05 - tolerance);
+    EXPECT_LT(elapsed, 0.5);
+}
+
+INSTANTIATE_TEST_SUITE_P(Sources, ClockTest, ::testing::ValuesIn(SOURCES),
+                         [](const ::testing::TestParamInfo<ClockSource> &info) {
+                             return std::string(clock_source_name(info.param));
+                         });
+
+TEST(Clock, Names) {
+    EXPECT_STREQ(clock_source_name(ClockSource::SYSTEM), "SYSTEM");
+    EXPECT_STREQ(clock_source_name(ClockSource::TSC), "TSC");
+    EXPECT_TRUE(clock_source_available(ClockSource::MONOTONIC_RAW));
+}
+
+TEST(Clock, UnavailableSourceKeepsCurrent) {
+    ASSERT_TRUE(set_clock_source(ClockSource::MONOTONIC));
+    if (!clock_source_available(ClockSource::TSC)) {
+        EXPECT_FALSE(set_clock_source(ClockSource::TSC));
+        EXPECT_EQ(clock_source(), ClockSource::MONOTONIC);
+    }
+    set_clock_source(ClockSource::SYSTEM);
+}
@@ -0,0 +1,138 @@
+#include <unistd.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "rix/bag/column_file.hpp"
+#include "rix/bag/columns.hpp"
+#include "rix/bag/reader.hpp"
+#include "rix/bag/writer.hpp"
+#include "rix/msg/geometry/Twist2DStamped.hpp"
+#include "rix/msg/standard/UInt32.hpp"
+
+#include "bag_test_util.hpp"
+
+using namespace rix;
+using rix::msg::geometry::Twist2DStamped;
+using rix::bag::test::at;
+
+namespace {
+
+// Headers are stamped a little after the records, so the two stamps differ
+constexpr int64_t HEADER_DELAY_MS = 5;
+
+Twist2DStamped twist(uint32_t seq) { return bag::test::twist(seq, HEADER_DELAY_MS); }
+
+using ColumnsTest = bag::test::TempFileTest;
+
+}  // namespace
+
+TEST_F(ColumnsTest, LoadsBagInStampOrder) {
+    {
+        bag::Writer::Options options;
+        options.chunk_size = 1024;
+        options.compression = bag::Compression::LZ;
+        bag::Writer writer;
+        ASSERT_TRUE(writer.open(path, options));
+        // Written out of order, with another type mixed in
+        for (int i = 999; i >= 0; i--) {
+            ASSERT_TRUE(writer.write(twist(i), at(i)));
+            msg::standard::UInt32 other;
+            ASSERT_TRUE(writer.write(other, at(i)));
+        }
+        ASSERT_TRUE(writer.close());
+    }
+    bag::Reader::Options options;
+    options.threads = 3;
+    bag::Reader reader;
+    ASSERT_TRUE(reader.open(path, options));
+    unlink(path.c_str());
+
+    bag::Twist2DColumns columns = bag::Twist2DColumns::load(reader, at(100), at(600));
+    ASSERT_EQ(columns.size(), 500);
+    for (size_t i = 0; i < columns.size(); i++) {
+        Twist2DStamped expected = twist(100 + i);
+        ASSERT_EQ(columns.stamp_ns[i], at(100 + i).to_nanoseconds());
+        EXPECT_EQ(columns.seq[i], expected.header.seq);
+        EXPECT_EQ(columns.header_stamp_ns[i], at(100 + i + HEADER_DELAY_MS).to_nanoseconds());
+        EXPECT_EQ(columns.vx[i], expected.twist.vx);
+        EXPECT_EQ(columns.vy[i], expected.twist.vy);
+        EXPECT_EQ(columns.wz[i], expected.twist.wz);
+    }
+}
+
+TEST_F(ColumnsTest, ColumnFileRoundTrip) {
+    bag::Twist2DColumns columns;
+    for (int i = 0; i < 1001; i++) {
+        columns.push_back(twist(i), at(i));
+    }
+    ASSERT_TRUE(columns.write(path));
+
+    bag::ColumnFile file;
+    ASSERT_TRUE(file.open(path));
+    unlink(path.c_str());
+    EXPECT_EQ(file.rows(), 1001);
+    ASSERT_EQ(file.columns(), 6);
+    EXPECT_EQ(file.name(3), "vx");
+    EXPECT_EQ(file.type(3), bag::ColumnType::FLOAT32);
+
+    auto vx = file.column<float>("vx");
+    auto stamps = file.column<int64_t>("stamp_ns");
+    auto seq = file.column<uint32_t>("seq");
+    ASSERT_EQ(vx.size(), 1001);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(vx.data()) % 64, 0);
+    EXPECT_TRUE(std::equal(vx.begin(), vx.end(), columns.vx.begin()));
+    EXPECT_TRUE(std::equal(stamps.begin(), stamps.end(), columns.stamp_ns.begin()));
+    EXPECT_TRUE(std::equal(seq.begin(), seq.end(), columns.seq.begin()));
+
+    // Wrong type or name
+    EXPECT_TRUE(file.column<double>("vx").empty());
+    EXPECT_TRUE(file.column<float>("vz").empty());
+}
+
+TEST_F(ColumnsTest, RejectsMismatchedColumns) {
+    std::vector<float> a(10), b(11);
+    EXPECT_FALSE(bag::write_column_file(path, {bag::Column::of("a", a), bag::Column::of("b", b)}));
+    EXPECT_FALSE(bag::write_column_file(path, {bag::Column::of(std::string(48, 'x'), a)}));
+    EXPECT_TRUE(bag::write_column_file(path, {}));
+
+    bag::ColumnFile file;
+    EXPECT_TRUE(file.open(path));
+    EXPECT_EQ(file.columns(), 0);
+
+    FILE *f = fopen(path.c_str(), "w");
+    fputs("not a column file at all", f);
+    fclose(f);
+    EXPECT_FALSE(file.open(path));
+}
+
+TEST_F(ColumnsTest, Summarize) {
+    EXPECT_EQ(bag::summarize({}).count, 0);
+
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<float> dist(-2.0f, 2.0f);
+    for (size_t n : {1, 7, 8, 9, 1000, 1003}) {
+        std::vector<float> values(n);
+        for (auto &v : values) {
+            v = dist(rng);
+        }
+        values[n / 2] = 5.0f;
+        values[n - 1] = -5.0f;
+        if (n == 1) {
+            values[0] = 3.0f;
+        }
+
+        double sum = 0.0;
+        for (float v : values) {
+            sum += v;
+        }
+        bag::Summary summary = bag::summarize(values);
+        EXPECT_EQ(summary.count, n);
+        EXPECT_EQ(summary.min, n == 1 ? 3.0 : -5.0) << n;
+        EXPECT_EQ(summary.max, n == 1 ? 3.0 : 5.0) << n;
+        EXPECT_NEAR(summary.mean, sum / n, 1e-9) << n;
+    }
+}
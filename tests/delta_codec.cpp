@@ -0,0 +1,145 @@
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "rix/msg/delta_codec.hpp"
+#include "rix/msg/geometry/Twist2DStamped.hpp"
+
+using namespace rix::msg;
+using rix::msg::geometry::Twist2DStamped;
+
+namespace {
+
+Twist2DStamped command(uint32_t seq, int32_t sec, int32_t nsec, const std::string &frame_id, float vx, float vy,
+                       float wz) {
+    Twist2DStamped cmd;
+    cmd.header.seq = seq;
+    cmd.header.stamp.sec = sec;
+    cmd.header.stamp.nsec = nsec;
+    cmd.header.frame_id = frame_id;
+    cmd.twist.vx = vx;
+    cmd.twist.vy = vy;
+    cmd.twist.wz = wz;
+    return cmd;
+}
+
+std::vector<uint8_t> serialized(const Twist2DStamped &cmd) {
+    std::vector<uint8_t> bytes(cmd.size());
+    size_t offset = 0;
+    cmd.serialize(bytes.data(), offset);
+    return bytes;
+}
+
+/**
+ * @brief Encodes `stream`, decodes it again and checks that every message
+ * serializes to the same bytes as the original.
+ */
+size_t round_trip(const std::vector<Twist2DStamped> &stream) {
+    DeltaEncoder encoder;
+    std::vector<uint8_t> encoded;
+    for (const auto &cmd : stream) {
+        encoder.encode(cmd, encoded);
+    }
+
+    DeltaDecoder decoder;
+    size_t offset = 0;
+    for (size_t i = 0; i < stream.size(); i++) {
+        Twist2DStamped cmd;
+        EXPECT_TRUE(decoder.decode(encoded.data(), encoded.size(), offset, cmd)) << i;
+        EXPECT_EQ(serialized(cmd), serialized(stream[i])) << i;
+    }
+    EXPECT_EQ(offset, encoded.size());
+    return encoded.size();
+}
+
+}  // namespace
+
+TEST(DeltaCodecTest, SteadyStreamIsSmall) {
+    // 50 Hz commands with some jitter and an occasional change of speed
+    std::mt19937 rng(1);
+    std::vector<Twist2DStamped> stream;
+    int64_t ns = 1700000000LL * 1000000000LL;
+    float vx = 0.25f;
+    for (uint32_t seq = 0; seq < 1000; seq++) {
+        ns += 20000000 + static_cast<int64_t>(rng() % 100000);
+        if (seq % 100 == 0) {
+            vx += 0.05f;
+        }
+        stream.push_back(command(seq, static_cast<int32_t>(ns / 1000000000), static_cast<int32_t>(ns % 1000000000),
+                                 "mbot", vx, 0.0f, -0.5f));
+    }
+    size_t size = round_trip(stream);
+    EXPECT_LT(size, stream.size() * 6);
+    EXPECT_EQ(serialized(stream[0]).size(), 32);
+}
+
+TEST(DeltaCodecTest, IrregularStreamIsLossless) {
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    std::vector<Twist2DStamped> stream = {
+        command(0, 0, 0, "", 0.0f, 0.0f, 0.0f),
+        command(7, 100, 5, "odom", -0.0f, nan, 1e30f),           // seq jump, -0 and NaN
+        command(3, 99, 999999999, "odom", -0.0f, nan, 1e30f),   // seq and stamp go backwards
+        command(UINT32_MAX, -5, 0, "mbot", 1.0f, 2.0f, 3.0f),   // negative stamp
+        command(0, -5, 0, "odom", 1.0f, 2.0f, 3.0f),            // seq wraps, back to a known frame
+        command(1, 7, -3, "odom", 1.0f, 2.0f, 3.0f),            // nsec out of range
+        command(2, 7, 1000000000, "odom", 1.0f, 2.0f, 3.0f),    // nsec out of range
+        command(3, INT32_MAX, 999999999, "mbot", 1.0f, 2.0f, 3.0f),
+        command(4, INT32_MIN, 0, "mbot", 1.0f, 2.0f, 3.0f),
+        command(5, 0, 0, std::string(300, 'x'), 1.0f, 2.0f, 3.0f),
+    };
+    round_trip(stream);
+}
+
+TEST(DeltaCodecTest, ManyFrameIds) {
+    // Past the dictionary limit, new frame ids are sent in full
+    std::vector<Twist2DStamped> stream;
+    for (uint32_t i = 0; i < DeltaEncoder::MAX_FRAME_IDS + 50; i++) {
+        stream.push_back(command(i, i, 0, "frame" + std::to_string(i), 0.0f, 0.0f, 0.0f));
+        stream.push_back(command(i, i, 0, "frame" + std::to_string(i % 10), 0.0f, 0.0f, 0.0f));
+        stream.push_back(command(i, i, 0, "frame" + std::to_string(i), 0.0f, 0.0f, 0.0f));
+    }
+    round_trip(stream);
+}
+
+TEST(DeltaCodecTest, Reset) {
+    DeltaEncoder encoder;
+    std::vector<uint8_t> first, second;
+    Twist2DStamped cmd = command(10, 1, 2, "mbot", 1.0f, 0.0f, 0.0f);
+    encoder.encode(cmd, first);
+    encoder.reset();
+    encoder.encode(cmd, second);
+    EXPECT_EQ(first, second);
+
+    DeltaDecoder decoder;
+    Twist2DStamped out;
+    size_t offset = 0;
+    ASSERT_TRUE(decoder.decode(first.data(), first.size(), offset, out));
+    decoder.reset();
+    offset = 0;
+    ASSERT_TRUE(decoder.decode(second.data(), second.size(), offset, out));
+    EXPECT_EQ(serialized(out), serialized(cmd));
+}
+
+TEST(DeltaCodecTest, RejectsMalformedInput) {
+    DeltaEncoder encoder;
+    std::vector<uint8_t> encoded;
+    encoder.encode(command(0, 1, 2, "mbot", 1.0f, 2.0f, 3.0f), encoded);
+
+    // Every truncation fails rather than reading past the end
+    for (size_t size = 0; size < encoded.size(); size++) {
+        DeltaDecoder decoder;
+        Twist2DStamped cmd;
+        size_t offset = 0;
+        EXPECT_FALSE(decoder.decode(encoded.data(), size, offset, cmd)) << size;
+    }
+
+    // A reference to a frame id that was never sent
+    std::vector<uint8_t> bad = {1 << 2, 0, 5};
+    DeltaDecoder decoder;
+    Twist2DStamped cmd;
+    size_t offset = 0;
+    EXPECT_FALSE(decoder.decode(bad.data(), bad.size(), offset, cmd));
+}
@@ -0,0 +1,124 @@
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "rix/msg/frame_id.hpp"
+#include "rix/msg/standard/Header.hpp"
+
+using rix::msg::FrameId;
+using rix::msg::standard::Header;
+
+TEST(FrameIdTest, Interning) {
+    FrameId empty;
+    EXPECT_TRUE(empty.empty());
+    EXPECT_EQ(empty, "");
+    EXPECT_EQ(empty, FrameId(""));
+
+    FrameId a = "mbot";
+    FrameId b(std::string("mbot"));
+    FrameId c(std::string_view("mbot-odom").substr(0, 4));
+    EXPECT_TRUE(a.interned());
+    EXPECT_EQ(&a.str(), &b.str());
+    EXPECT_EQ(&a.str(), &c.str());
+    EXPECT_EQ(a, b);
+    EXPECT_NE(a, FrameId("odom"));
+
+    EXPECT_EQ(a, "mbot");
+    EXPECT_EQ("mbot", a);
+    EXPECT_EQ(a, std::string("mbot"));
+    EXPECT_NE(a, "odom");
+    const std::string &str = a;
+    EXPECT_EQ(str, "mbot");
+
+    std::ostringstream ss;
+    ss << a;
+    EXPECT_EQ(ss.str(), "mbot");
+
+    std::unordered_set<FrameId> set = {a, b, "odom"};
+    EXPECT_EQ(set.size(), 2);
+}
+
+TEST(FrameIdTest, WireLayoutIsUnchanged) {
+    Header header;
+    header.seq = 7;
+    header.stamp.sec = 1;
+    header.stamp.nsec = 2;
+    header.frame_id = "odom";
+
+    std::vector<uint8_t> bytes(header.size());
+    size_t offset = 0;
+    header.serialize(bytes.data(), offset);
+
+    // seq, stamp, then a size_string
+    std::vector<uint8_t> expected(16);
+    uint32_t fields[] = {7, 1, 2, 4};
+    std::memcpy(expected.data(), fields, sizeof(fields));
+    expected.insert(expected.end(), {'o', 'd', 'o', 'm'});
+    EXPECT_EQ(bytes, expected);
+
+    size_t before = FrameId::interned_count();
+    Header copy;
+    offset = 0;
+    ASSERT_TRUE(copy.deserialize(bytes.data(), bytes.size(), offset));
+    EXPECT_EQ(offset, bytes.size());
+    EXPECT_EQ(&copy.frame_id.str(), &header.frame_id.str());
+    EXPECT_EQ(FrameId::interned_count(), before);
+
+    offset = 0;
+    EXPECT_FALSE(copy.deserialize(bytes.data(), bytes.size() - 1, offset));
+}
+
+TEST(FrameIdTest, ConcurrentInterning) {
+    // Threads racing to intern the same new strings all get the same entries
+    constexpr int THREADS = 4;
+    std::vector<std::vector<const std::string *>> seen(THREADS);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; t++) {
+        threads.emplace_back([&, t] {
+            for (int i = 0; i < 200; i++) {
+                seen[t].push_back(&FrameId("race" + std::to_string(i)).str());
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    for (int t = 1; t < THREADS; t++) {
+        EXPECT_EQ(seen[t], seen[0]);
+    }
+}
+
+TEST(FrameIdTest, UninternedStrings) {
+    // Too long to intern, but still a working frame id
+    std::string long_id(FrameId::MAX_INTERNED_SIZE + 1, 'x');
+    FrameId a = long_id;
+    FrameId b = long_id;
+    EXPECT_FALSE(a.interned());
+    EXPECT_NE(&a.str(), &b.str());
+    EXPECT_EQ(a, b);
+    EXPECT_NE(a, FrameId("x"));
+
+    FrameId c = a;
+    FrameId d = std::move(b);
+    EXPECT_EQ(c, long_id);
+    EXPECT_EQ(d, long_id);
+    EXPECT_TRUE(b.empty());
+    c = d;
+    c = "mbot";
+    EXPECT_TRUE(c.interned());
+
+    // Once the table is full, new strings are no longer interned
+    for (size_t i = 0; FrameId::interned_count() < FrameId::MAX_INTERNED; i++) {
+        FrameId("fill" + std::to_string(i));
+    }
+    FrameId full = "not-interned";
+    EXPECT_FALSE(full.interned());
+    EXPECT_EQ(full, FrameId("not-interned"));
+    EXPECT_TRUE(FrameId("mbot").interned());
+    EXPECT_EQ(FrameId::interned_count(), FrameId::MAX_INTERNED);
+}
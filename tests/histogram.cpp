@@ -0,0 +1,85 @@
+#include "rix/util/histogram.hpp"
+
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace rix::util;
+
+TEST(Histogram, Empty) {
+    Histogram h;
+    EXPECT_EQ(h.count(), 0);
+    EXPECT_EQ(h.min(), 0);
+    EXPECT_EQ(h.max(), 0);
+    EXPECT_EQ(h.mean(), 0.0);
+    EXPECT_EQ(h.percentile(50.0), 0);
+}
+
+TEST(Histogram, SmallValuesAreExact) {
+    Histogram h;
+    for (int64_t v = 0; v < 64; v++) {
+        h.record(v);
+    }
+    EXPECT_EQ(h.count(), 64);
+    EXPECT_EQ(h.min(), 0);
+    EXPECT_EQ(h.max(), 63);
+    EXPECT_DOUBLE_EQ(h.mean(), 31.5);
+    EXPECT_EQ(h.percentile(50.0), 31);
+    EXPECT_EQ(h.percentile(100.0), 63);
+}
+
+TEST(Histogram, PercentilesWithinPrecision) {
+    Histogram h;
+    for (int64_t v = 1; v <= 100000; v++) {
+        h.record(v * 1000);
+    }
+    const double tolerance = 1.0 / Histogram::SUB_BUCKETS;
+    EXPECT_NEAR(h.percentile(50.0), 50'000'000, 50'000'000 * tolerance);
+    EXPECT_NEAR(h.percentile(99.0), 99'000'000, 99'000'000 * tolerance);
+    EXPECT_NEAR(h.percentile(99.9), 99'900'000, 99'900'000 * tolerance);
+    EXPECT_EQ(h.max(), 100'000'000);
+    EXPECT_EQ(h.min(), 1000);
+}
+
+TEST(Histogram, LargeAndNegativeValues) {
+    Histogram h;
+    h.record(std::numeric_limits<int64_t>::max());
+    h.record(-5);
+    EXPECT_EQ(h.count(), 2);
+    EXPECT_EQ(h.min(), 0);
+    EXPECT_EQ(h.max(), std::numeric_limits<int64_t>::max());
+    EXPECT_EQ(h.percentile(100.0), std::numeric_limits<int64_t>::max());
+}
+
+TEST(Histogram, RecordDuration) {
+    Histogram h;
+    h.record(Duration(0.001));
+    EXPECT_EQ(h.max(), 1'000'000);
+}
+
+TEST(Histogram, ConcurrentRecord) {
+    Histogram h;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&h] {
+            for (int i = 0; i < 100000; i++) {
+                h.record(i);
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    EXPECT_EQ(h.count(), 400000);
+    EXPECT_EQ(h.max(), 99999);
+    EXPECT_EQ(h.min(), 0);
+}
+
+TEST(Histogram, Reset) {
+    Histogram h;
+    h.record(100);
+    h.reset();
+    EXPECT_EQ(h.count(), 0);
+    EXPECT_EQ(h.max(), 0);
+}
@@ -0,0 +1,169 @@
+#include "rix/util/log.hpp"
+
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace rix::util;
+
+namespace {
+
+int evaluations = 0;
+
+int counted(int value) {
+    evaluations++;
+    return value;
+}
+
+RIX_LOG_DEFINE_MODULE(test_log, "test");
+
+/**
+ * @brief A stream buffer that records how its contents arrived: `puts` bulk
+ * writes, and `chars` single characters through `overflow`.
+ */
+class CountingBuffer : public std::streambuf {
+   public:
+    std::string data;
+    int puts = 0;
+    int chars = 0;
+
+   protected:
+    int overflow(int c) override {
+        chars++;
+        data.push_back(static_cast<char>(c));
+        return c;
+    }
+    std::streamsize xsputn(const char *s, std::streamsize n) override {
+        puts++;
+        data.append(s, n);
+        return n;
+    }
+};
+
+std::string line_body(int thread, int line) {
+    return "t=" + std::to_string(thread) + " i=" + std::to_string(line) + " a 1.5 b";
+}
+
+}  // namespace
+
+TEST(Log, CompiledOutLevelsDoNotEvaluateArguments) {
+    static_assert(RIX_UTIL_LOG_LEVEL > Log::Level::DEBUG);
+    evaluations = 0;
+    RIX_LOG_DEBUG << "value " << counted(1) << std::endl;
+    EXPECT_EQ(evaluations, 0);
+}
+
+TEST(Log, EnabledLevelsEvaluateArgumentsOnce) {
+    evaluations = 0;
+    RIX_LOG_INFO << "value " << counted(1) << std::endl;
+    EXPECT_EQ(evaluations, 1);
+}
+
+TEST(Log, RuntimeLevelSkipsArguments) {
+    Log::set_level(Log::Level::ERROR);
+    evaluations = 0;
+    RIX_LOG_WARN << "value " << counted(1) << std::endl;
+    EXPECT_EQ(evaluations, 0);
+    RIX_LOG_ERROR << "value " << counted(2) << std::endl;
+    EXPECT_EQ(evaluations, 1);
+    Log::set_level(static_cast<Log::Level>(RIX_UTIL_LOG_LEVEL));
+}
+
+TEST(Log, ModuleOverride) {
+    EXPECT_EQ(test_log.name(), "test");
+    EXPECT_TRUE(test_log.enabled(Log::Level::INFO));
+
+    Log::set_level("test", Log::Level::FATAL);
+    EXPECT_FALSE(test_log.enabled(Log::Level::ERROR));
+    EXPECT_TRUE(Log::default_module.enabled(Log::Level::INFO));
+
+    evaluations = 0;
+    RIX_LOG(Log::Level::ERROR, test_log) << "value " << counted(1) << std::endl;
+    RIX_LOG(Log::Level::ERROR, Log::default_module) << "value " << counted(2) << std::endl;
+    EXPECT_EQ(evaluations, 1);
+
+    // Overrides survive changes to the default level
+    Log::set_level(Log::Level::WARN);
+    EXPECT_EQ(test_log.level(), Log::Level::FATAL);
+    EXPECT_EQ(Log::default_module.level(), Log::Level::WARN);
+
+    Log::clear_level("test");
+    EXPECT_EQ(test_log.level(), Log::Level::WARN);
+    Log::set_level(static_cast<Log::Level>(RIX_UTIL_LOG_LEVEL));
+    EXPECT_EQ(test_log.level(), static_cast<Log::Level>(RIX_UTIL_LOG_LEVEL));
+}
+
+TEST(Log, OverrideAppliesToLaterModules) {
+    Log::set_level("later", Log::Level::ERROR);
+    Log::Module later("later");
+    EXPECT_EQ(later.level(), Log::Level::ERROR);
+    Log::clear_level("later");
+    EXPECT_EQ(later.level(), static_cast<Log::Level>(RIX_UTIL_LOG_LEVEL));
+}
+
+TEST(Log, MacrosComposeWithIfElse) {
+    bool taken = false;
+    if (false)
+        RIX_LOG_INFO << "never" << std::endl;
+    else
+        taken = true;
+    EXPECT_TRUE(taken);
+}
+
+TEST(Log, ConcurrentRecordsStayWholeAndOrdered) {
+    const int threads = 4, lines = 200;
+    testing::internal::CaptureStdout();
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([t] {
+            for (int i = 0; i < lines; i++) {
+                Log::info << "t=" << t << " i=" << i << " a" << ' ' << 1.5 << " b" << std::endl;
+            }
+        });
+    }
+    for (auto &worker : workers) {
+        worker.join();
+    }
+    std::cout.flush();
+    std::string out = testing::internal::GetCapturedStdout();
+
+    // Each line is one record: a header, then exactly the body its thread
+    // logged next
+    std::vector<int> next(threads, 0);
+    std::istringstream ss(out);
+    std::string line;
+    int count = 0;
+    while (std::getline(ss, line)) {
+        size_t pos = line.find("t=");
+        ASSERT_NE(pos, std::string::npos) << line;
+        int t = line[pos + 2] - '0';
+        ASSERT_GE(t, 0);
+        ASSERT_LT(t, threads);
+        EXPECT_EQ(line.substr(pos), line_body(t, next[t])) << line;
+        next[t]++;
+        count++;
+    }
+    EXPECT_EQ(count, threads * lines);
+    EXPECT_EQ(next, std::vector<int>(threads, lines));
+}
+
+TEST(Log, TeeBufferForwardsEachRecordInOneCall) {
+    CountingBuffer first, second;
+    detail::TeeBuffer tee({&first, &second});
+    detail::RecordBuilder builder;
+    std::string expected;
+    for (int i = 0; i < 3; i++) {
+        builder.buffer.clear();
+        builder.stream << line_body(0, i) << ' ' << i << std::endl;
+        tee.sputn(builder.buffer.data(), builder.buffer.size());
+        expected += line_body(0, i) + " " + std::to_string(i) + "\n";
+    }
+
+    for (CountingBuffer *target : {&first, &second}) {
+        EXPECT_EQ(target->puts, 3);
+        EXPECT_EQ(target->chars, 0);
+        EXPECT_EQ(target->data, expected);
+    }
+}
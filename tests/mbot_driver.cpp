@@ -0,0 +1,498 @@
+#include "mbot_driver/mbot_driver.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "rix/util/clock.hpp"
+
+using namespace rix::util;
+
+namespace {
+
+/**
+ * @brief Serializes a size-prefixed command whose `vx` identifies it.
+ */
+std::vector<uint8_t> frame(float vx) {
+    geometry::Twist2DStamped cmd;
+    cmd.header.frame_id = "mbot";
+    cmd.twist.vx = vx;
+    standard::UInt32 size;
+    size.data = cmd.size();
+    std::vector<uint8_t> bytes(size.size() + cmd.size());
+    size_t offset = 0;
+    size.serialize(bytes.data(), offset);
+    cmd.serialize(bytes.data(), offset);
+    return bytes;
+}
+
+/**
+ * @brief A size prefix over the driver's 4096-byte buffer, followed by its
+ * body.
+ */
+std::vector<uint8_t> oversized_frame() {
+    standard::UInt32 size;
+    size.data = 5001;
+    std::vector<uint8_t> bytes(size.size() + size.data, 0xab);
+    size_t offset = 0;
+    size.serialize(bytes.data(), offset);
+    return bytes;
+}
+
+/**
+ * @brief An input that delivers queued frames in batches. Each batch is one
+ * wakeup: `is_readable` is false between batches, and a blocking read or wait
+ * starts the next batch, first calling its `on_start`. After `close`, the
+ * input ends once every batch has been read.
+ */
+class FakeInput : public interfaces::IO {
+   public:
+    void push(const std::vector<std::vector<uint8_t>> &frames, std::function<void()> on_start = {}) {
+        Batch batch{{}, std::move(on_start)};
+        for (const auto &f : frames) {
+            batch.bytes.insert(batch.bytes.end(), f.begin(), f.end());
+        }
+        std::lock_guard<std::mutex> guard(mtx_);
+        pending_.push_back(std::move(batch));
+        cv_.notify_all();
+    }
+
+    void close() {
+        std::lock_guard<std::mutex> guard(mtx_);
+        closed_ = true;
+        cv_.notify_all();
+    }
+
+    /**
+     * @brief Returns true once every byte pushed so far has been read.
+     */
+    bool drained() const {
+        std::lock_guard<std::mutex> guard(mtx_);
+        return pending_.empty() && pos_ == current_.bytes.size();
+    }
+
+    ssize_t read(uint8_t *buffer, size_t len) const override {
+        std::unique_lock<std::mutex> lock(mtx_);
+        if (pos_ == current_.bytes.size()) {
+            cv_.wait(lock, [this] { return !pending_.empty() || closed_; });
+            if (!start_next()) {
+                return 0;
+            }
+        }
+        size_t n = std::min(len, current_.bytes.size() - pos_);
+        std::copy_n(current_.bytes.data() + pos_, n, buffer);
+        pos_ += n;
+        return static_cast<ssize_t>(n);
+    }
+
+    ssize_t write(const uint8_t *, size_t) const override { return -1; }
+
+    bool wait_for_writable(const Duration &) const override { return false; }
+
+    bool wait_for_readable(const Duration &duration) const override {
+        std::unique_lock<std::mutex> lock(mtx_);
+        if (pos_ < current_.bytes.size()) {
+            return true;
+        }
+        if (duration > Duration(0.0)) {
+            cv_.wait_for(lock, std::chrono::nanoseconds(duration.to_nanoseconds()),
+                         [this] { return !pending_.empty() || closed_; });
+            return start_next() || closed_;
+        }
+        return pending_.empty() && closed_;
+    }
+
+    void set_nonblocking(bool) override {}
+    bool is_nonblocking() const override { return false; }
+
+   private:
+    struct Batch {
+        std::vector<uint8_t> bytes;
+        std::function<void()> on_start;
+    };
+
+    bool start_next() const {
+        if (pending_.empty()) {
+            return false;
+        }
+        current_ = std::move(pending_.front());
+        pending_.pop_front();
+        pos_ = 0;
+        if (current_.on_start) {
+            current_.on_start();
+        }
+        return true;
+    }
+
+    mutable std::mutex mtx_;
+    mutable std::condition_variable cv_;
+    mutable std::deque<Batch> pending_;
+    mutable Batch current_;
+    mutable size_t pos_ = 0;
+    bool closed_ = false;
+};
+
+/**
+ * @brief Records the `vx` of every command driven. While held, `drive` blocks
+ * until released, as a slow serial write would.
+ */
+class MockMBot : public MBotBase {
+   public:
+    bool ok() const override { return true; }
+
+    void drive(const Twist2DStamped &cmd) const override {
+        std::unique_lock<std::mutex> lock(mtx_);
+        driven_.push_back(cmd.twist.vx);
+        cv_.notify_all();
+        cv_.wait(lock, [this] { return !held_; });
+    }
+
+    void hold() {
+        std::lock_guard<std::mutex> guard(mtx_);
+        held_ = true;
+    }
+
+    void release() {
+        std::lock_guard<std::mutex> guard(mtx_);
+        held_ = false;
+        cv_.notify_all();
+    }
+
+    /**
+     * @brief Waits in real time until `n` commands have been driven.
+     */
+    bool wait_for_driven(size_t n) const {
+        std::unique_lock<std::mutex> lock(mtx_);
+        return cv_.wait_for(lock, std::chrono::seconds(2), [&] { return driven_.size() >= n; });
+    }
+
+    std::vector<float> driven() const {
+        std::lock_guard<std::mutex> guard(mtx_);
+        return driven_;
+    }
+
+   private:
+    mutable std::mutex mtx_;
+    mutable std::condition_variable cv_;
+    mutable std::vector<float> driven_;
+    bool held_ = false;
+};
+
+class FakeNotification : public interfaces::Notification {
+   public:
+    bool raise() const override {
+        raised_ = true;
+        return true;
+    }
+
+    bool wait(const Duration &duration) const override {
+        if (!raised_ && duration > Duration(0.0)) {
+            std::this_thread::sleep_for(std::chrono::nanoseconds(duration.to_nanoseconds()));
+        }
+        return raised_;
+    }
+
+   private:
+    mutable std::atomic<bool> raised_{false};
+};
+
+/**
+ * @brief A driver wired to fakes the test keeps pointers to.
+ */
+struct Harness {
+    FakeInput *input;
+    MockMBot *mbot;
+    FakeNotification *notif;
+    std::unique_ptr<FakeNotification> notif_owner;
+    MBotDriver driver;
+
+    explicit Harness(const Duration &keep_alive = Duration(0.5))
+        : Harness(std::make_unique<FakeInput>(), std::make_unique<MockMBot>(), keep_alive) {}
+
+    Harness(std::unique_ptr<FakeInput> in, std::unique_ptr<MockMBot> bot, const Duration &keep_alive)
+        : input(in.get()),
+          mbot(bot.get()),
+          notif(nullptr),
+          notif_owner(std::make_unique<FakeNotification>()),
+          driver(std::move(in), std::move(bot), keep_alive) {
+        notif = notif_owner.get();
+    }
+
+    void spin() { driver.spin(std::move(notif_owner)); }
+
+    void spin_pipelined(const MBotDriver::PipelineOptions &options) {
+        driver.spin_pipelined(std::move(notif_owner), options);
+    }
+
+    /**
+     * @brief Pushes `vx` as its own wakeup and waits in real time until the
+     * decode stage has taken it, which it does only after handing on the
+     * frames before it.
+     */
+    bool push_decoded(float vx) {
+        uint64_t decoded = driver.latency().transit.count();
+        input->push({frame(vx)});
+        for (int i = 0; i < 2000; i++) {
+            if (driver.latency().transit.count() > decoded) {
+                return true;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return false;
+    }
+};
+
+/**
+ * @brief Waits in real time until `pred` holds.
+ */
+bool eventually(const std::function<bool()> &pred) {
+    for (int i = 0; i < 2000; i++) {
+        if (pred()) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return false;
+}
+
+/**
+ * @brief Every received command is accounted for once, and `sent` also
+ * counts the stop command sent on shutdown.
+ */
+void expect_counters_add_up(const MBotDriver::Stats &stats) {
+    EXPECT_EQ(stats.received, stats.coalesced + stats.dropped + stats.suppressed + stats.sent - 1);
+}
+
+class MBotDriverSimTest : public ::testing::Test {
+   protected:
+    void SetUp() override { SimulatedClock::start(Time(1000.0)); }
+    void TearDown() override { SimulatedClock::stop(); }
+};
+
+}  // namespace
+
+TEST(MBotDriver, SendsOnlyTheNewestQueuedFrame) {
+    Harness h;
+    h.input->push({frame(1), frame(2), frame(3), frame(4), frame(5)});
+    h.input->close();
+    h.spin();
+
+    EXPECT_EQ(h.mbot->driven(), (std::vector<float>{5, 0}));
+    const MBotDriver::Stats &stats = h.driver.stats();
+    EXPECT_EQ(stats.received, 5);
+    EXPECT_EQ(stats.coalesced, 4);
+    EXPECT_EQ(stats.suppressed, 0);
+    EXPECT_EQ(stats.sent, 2);
+    expect_counters_add_up(stats);
+}
+
+TEST(MBotDriver, EachWakeupIsForwarded) {
+    Harness h;
+    h.input->push({frame(1)});
+    h.input->push({frame(2), frame(3)});
+    h.input->push({frame(4)});
+    h.input->close();
+    h.spin();
+
+    EXPECT_EQ(h.mbot->driven(), (std::vector<float>{1, 3, 4, 0}));
+    EXPECT_EQ(h.driver.stats().coalesced, 1);
+    expect_counters_add_up(h.driver.stats());
+}
+
+TEST(MBotDriver, SkipsOversizedFrame) {
+    Harness h;
+    h.input->push({frame(1)});
+    h.input->push({oversized_frame(), frame(2)});
+    h.input->close();
+    h.spin();
+
+    EXPECT_EQ(h.mbot->driven(), (std::vector<float>{1, 2, 0}));
+    EXPECT_EQ(h.driver.stats().received, 2);
+}
+
+TEST(MBotDriver, StopsOnSignal) {
+    Harness h;
+    h.notif->raise();
+    h.input->push({frame(1)});
+    h.spin();
+    EXPECT_EQ(h.mbot->driven(), (std::vector<float>{0}));
+    EXPECT_EQ(h.driver.stats().received, 0);
+}
+
+TEST_F(MBotDriverSimTest, SuppressesRepeatsWithinKeepAlive) {
+    Harness h(Duration(0.5));
+    h.input->push({frame(1)});
+    h.input->push({frame(1)}, [] { SimulatedClock::advance(Duration(0.2)); });
+    h.input->push({frame(1)}, [] { SimulatedClock::advance(Duration(0.2)); });
+    // 0.5 s after the first was sent
+    h.input->push({frame(1)}, [] { SimulatedClock::advance(Duration(0.1)); });
+    h.input->push({frame(2)});
+    h.input->close();
+    h.spin();
+
+    EXPECT_EQ(h.mbot->driven(), (std::vector<float>{1, 1, 2, 0}));
+    const MBotDriver::Stats &stats = h.driver.stats();
+    EXPECT_EQ(stats.received, 5);
+    EXPECT_EQ(stats.coalesced, 0);
+    EXPECT_EQ(stats.suppressed, 2);
+    EXPECT_EQ(stats.sent, 4);
+    expect_counters_add_up(stats);
+}
+
+TEST(MBotDriverPipelined, DropOldestFrameAtCapacity) {
+    MBotDriver::PipelineOptions options;
+    options.frame_capacity = 2;
+    options.frame_policy = OverflowPolicy::DROP_OLDEST;
+    options.command_capacity = 2;
+    options.command_policy = OverflowPolicy::BLOCK;
+
+    Harness h;
+    h.mbot->hold();
+    std::thread spinner([&] { h.spin_pipelined(options); });
+
+    // Stall the pipeline: 1 is being driven, 2 and 3 fill the command queue
+    // and the decode stage blocks handing on 4
+    ASSERT_TRUE(h.push_decoded(1));
+    ASSERT_TRUE(h.mbot->wait_for_driven(1));
+    for (float vx : {2, 3, 4}) {
+        ASSERT_TRUE(h.push_decoded(vx));
+    }
+
+    // 5 and 6 fill the frame queue; 7 evicts 5
+    h.input->push({frame(5), frame(6)});
+    h.input->push({frame(7)});
+    h.input->close();
+    ASSERT_TRUE(eventually([&] { return h.input->drained(); }));
+    h.mbot->release();
+    spinner.join();
+
+    EXPECT_EQ(h.mbot->driven(), (std::vector<float>{1, 2, 3, 4, 6, 7, 0}));
+    const MBotDriver::Stats &stats = h.driver.stats();
+    EXPECT_EQ(stats.received, 6);
+    EXPECT_EQ(stats.dropped_frames, 1);
+    EXPECT_EQ(stats.dropped, 0);
+    expect_counters_add_up(stats);
+}
+
+TEST(MBotDriverPipelined, NothingDroppedAtExactCapacity) {
+    MBotDriver::PipelineOptions options;
+    options.frame_capacity = 2;
+    options.frame_policy = OverflowPolicy::DROP_OLDEST;
+    options.command_capacity = 2;
+    options.command_policy = OverflowPolicy::BLOCK;
+
+    Harness h;
+    h.mbot->hold();
+    std::thread spinner([&] { h.spin_pipelined(options); });
+    ASSERT_TRUE(h.push_decoded(1));
+    ASSERT_TRUE(h.mbot->wait_for_driven(1));
+    for (float vx : {2, 3, 4}) {
+        ASSERT_TRUE(h.push_decoded(vx));
+    }
+    h.input->push({frame(5), frame(6)});
+    h.input->close();
+    ASSERT_TRUE(eventually([&] { return h.input->drained(); }));
+    h.mbot->release();
+    spinner.join();
+
+    EXPECT_EQ(h.mbot->driven(), (std::vector<float>{1, 2, 3, 4, 5, 6, 0}));
+    EXPECT_EQ(h.driver.stats().dropped, 0);
+    EXPECT_EQ(h.driver.stats().dropped_frames, 0);
+    expect_counters_add_up(h.driver.stats());
+}
+
+TEST(MBotDriverPipelined, KeepLatestCommand) {
+    MBotDriver::PipelineOptions options;
+    options.frame_capacity = 2;
+    options.frame_policy = OverflowPolicy::BLOCK;
+    options.command_capacity = 4;
+    options.command_policy = OverflowPolicy::KEEP_LATEST;
+
+    // While 1 is being driven, each newer command replaces the queued one
+    Harness h;
+    h.mbot->hold();
+    std::thread spinner([&] { h.spin_pipelined(options); });
+    ASSERT_TRUE(h.push_decoded(1));
+    ASSERT_TRUE(h.mbot->wait_for_driven(1));
+    for (float vx : {2, 3, 4, 5}) {
+        ASSERT_TRUE(h.push_decoded(vx));
+    }
+    // Let the decode stage finish handing on 5
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    h.input->close();
+    h.mbot->release();
+    spinner.join();
+
+    EXPECT_EQ(h.mbot->driven(), (std::vector<float>{1, 5, 0}));
+    const MBotDriver::Stats &stats = h.driver.stats();
+    EXPECT_EQ(stats.received, 5);
+    EXPECT_EQ(stats.dropped, 3);
+    expect_counters_add_up(stats);
+}
+
+TEST(MBotDriverPipelined, StopsAtEndOfInput) {
+    Harness h;
+    h.input->push({frame(1), frame(2)});
+    h.input->push({frame(3)});
+    h.input->close();
+    h.spin_pipelined(MBotDriver::PipelineOptions());
+
+    std::vector<float> driven = h.mbot->driven();
+    ASSERT_GE(driven.size(), 2);
+    EXPECT_EQ(driven[driven.size() - 2], 3);
+    EXPECT_EQ(driven.back(), 0);
+    EXPECT_EQ(h.driver.stats().received, 3);
+    expect_counters_add_up(h.driver.stats());
+}
+
+TEST(MBotDriverPipelined, SkipsOversizedFrame) {
+    Harness h;
+    h.input->push({oversized_frame(), frame(1)});
+    h.input->close();
+    h.spin_pipelined(MBotDriver::PipelineOptions());
+
+    EXPECT_EQ(h.mbot->driven(), (std::vector<float>{1, 0}));
+    EXPECT_EQ(h.driver.stats().received, 1);
+}
+
+TEST(MBotDriverPipelined, UndecodableFrameIsNotReceived) {
+    std::vector<uint8_t> corrupt = {2, 0, 0, 0, 0xff, 0xff};
+    Harness h;
+    h.input->push({frame(1), corrupt, frame(2)});
+    h.input->close();
+    h.spin_pipelined(MBotDriver::PipelineOptions());
+
+    EXPECT_EQ(h.driver.stats().received, 2);
+    expect_counters_add_up(h.driver.stats());
+}
+
+TEST(MBotDriverPipelined, StopsOnSignalMidFrame) {
+    Harness h;
+    std::atomic<bool> returned{false};
+    std::thread spinner([&] {
+        h.spin_pipelined(MBotDriver::PipelineOptions());
+        returned = true;
+    });
+
+    // The input thread reads the size and half the body, then waits for the
+    // rest, which never comes
+    std::vector<uint8_t> partial = frame(1);
+    partial.resize(partial.size() / 2);
+    h.input->push({partial});
+    ASSERT_TRUE(eventually([&] { return h.input->drained(); }));
+    h.notif->raise();
+    EXPECT_TRUE(eventually([&] { return returned.load(); }));
+
+    // Unblocks a read that ignored the signal, so a failure does not hang
+    h.input->close();
+    spinner.join();
+    EXPECT_EQ(h.mbot->driven(), (std::vector<float>{0}));
+    EXPECT_EQ(h.driver.stats().received, 0);
+}
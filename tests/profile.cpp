@@ -0,0 +1,81 @@
+#include "rix/util/profile.hpp"
+
+#include <algorithm>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace rix::util;
+
+namespace {
+
+void probed(const Duration &duration) {
+    RIX_PROFILE_SCOPE("test.probed");
+    sleep_for(duration);
+}
+
+}  // namespace
+
+TEST(Profiler, ProbeIsShared) {
+    Histogram &a = Profiler::probe("test.shared");
+    Histogram &b = Profiler::probe("test.shared");
+    EXPECT_EQ(&a, &b);
+    EXPECT_NE(&a, &Profiler::probe("test.other"));
+}
+
+TEST(Profiler, ScopeRecordsDuration) {
+    Histogram &histogram = Profiler::probe("test.probed");
+    histogram.reset();
+    for (int i = 0; i < 5; i++) {
+        probed(Duration(0.002));
+    }
+    EXPECT_EQ(histogram.count(), 5);
+    EXPECT_GE(histogram.min(), 2'000'000);
+    EXPECT_LT(histogram.min(), 20'000'000);
+}
+
+TEST(Profiler, ConcurrentScopes) {
+    Histogram &histogram = Profiler::probe("test.concurrent");
+    histogram.reset();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([] {
+            for (int i = 0; i < 1000; i++) {
+                RIX_PROFILE_SCOPE("test.concurrent");
+            }
+        });
+    }
+    for (auto &thr : threads) {
+        thr.join();
+    }
+    EXPECT_EQ(histogram.count(), 4000);
+}
+
+TEST(Profiler, TimerRecordsIntervals) {
+    Histogram histogram;
+    Timer timer(histogram);
+    for (int i = 0; i < 3; i++) {
+        timer.start();
+        timer.stop();
+    }
+    EXPECT_EQ(histogram.count(), 3);
+    EXPECT_LE(timer.get().to_nanoseconds(), histogram.max());
+}
+
+TEST(Profiler, DumpListsRecordedProbes) {
+    Profiler::reset();
+    Profiler::probe("test.empty");
+    probed(Duration(0.001));
+
+    std::ostringstream os;
+    Profiler::dump(os);
+    std::string out = os.str();
+    EXPECT_NE(out.find("test.probed:"), std::string::npos);
+    EXPECT_EQ(out.find("test.empty"), std::string::npos);
+
+    auto names = Profiler::names();
+    EXPECT_TRUE(std::is_sorted(names.begin(), names.end()));
+    EXPECT_NE(std::find(names.begin(), names.end(), "test.empty"), names.end());
+}
@@ -0,0 +1,177 @@
+#include <cmath>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "mbot/quantized.hpp"
+#include "rix/msg/quantize.hpp"
+
+using rix::msg::Quantizer;
+using rix::msg::Twist2DQuantization;
+using rix::msg::geometry::Twist2D;
+
+namespace {
+
+/**
+ * @brief The worst error allowed for a value inside the range: half a step,
+ * plus float rounding in the scale and in the decoded value.
+ */
+float bound(const Quantizer &q, float value) {
+    return 0.5f * q.resolution() * 1.01f + 4 * std::numeric_limits<float>::epsilon() * std::abs(value);
+}
+
+}  // namespace
+
+TEST(Quantizer, ErrorBound) {
+    std::mt19937 rng(1);
+    for (const Quantizer &q : {Quantizer(-4.0f, 4.0f, 0.001f), Quantizer(-16.0f, 16.0f, 0.0005f),
+                               Quantizer(0.0f, 1.0f, 1.0f / 65535), Quantizer(-3.14159265f, 3.14159265f, 0.0001f),
+                               Quantizer(100.0f, 101.0f, 0.25f)}) {
+        std::uniform_real_distribution<float> dist(q.min(), q.max());
+        std::vector<float> values(10000);
+        for (auto &v : values) {
+            v = dist(rng);
+        }
+        values.push_back(q.min());
+        values.push_back(q.max());
+
+        std::vector<uint16_t> codes(values.size());
+        std::vector<float> decoded(values.size());
+        q.encode(values.data(), values.size(), codes.data());
+        q.decode(codes.data(), codes.size(), decoded.data());
+        for (size_t i = 0; i < values.size(); i++) {
+            ASSERT_EQ(codes[i], q.encode(values[i])) << i;
+            ASSERT_EQ(decoded[i], q.decode(codes[i])) << i;
+            ASSERT_LE(std::abs(decoded[i] - values[i]), bound(q, values[i])) << values[i];
+        }
+        EXPECT_EQ(q.encode(q.min()), 0);
+        EXPECT_EQ(q.encode(q.max()), q.steps());
+    }
+}
+
+TEST(Quantizer, Range) {
+    Quantizer q(-4.0f, 4.0f, 0.001f);
+    EXPECT_EQ(q.steps(), 8000);
+    EXPECT_NEAR(q.max(), 4.0f, 1e-6f);
+
+    // A range that is not a whole number of steps is extended
+    Quantizer r(0.0f, 1.1f, 0.25f);
+    EXPECT_EQ(r.steps(), 5);
+    EXPECT_FLOAT_EQ(r.max(), 1.25f);
+
+    EXPECT_THROW(Quantizer(0.0f, 1.0f, 0.0f), std::invalid_argument);
+    EXPECT_THROW(Quantizer(0.0f, 1.0f, -0.1f), std::invalid_argument);
+    EXPECT_THROW(Quantizer(1.0f, 1.0f, 0.1f), std::invalid_argument);
+    EXPECT_THROW(Quantizer(-10.0f, 10.0f, 0.0001f), std::invalid_argument);
+    EXPECT_THROW(Quantizer(0.0f, std::numeric_limits<float>::infinity(), 1.0f), std::invalid_argument);
+    EXPECT_NO_THROW(Quantizer(0.0f, 65535.0f, 1.0f));
+}
+
+TEST(Quantizer, OutOfRangeValues) {
+    Quantizer q(-4.0f, 4.0f, 0.001f);
+    const float inf = std::numeric_limits<float>::infinity();
+    std::vector<float> values = {-5.0f, 5.0f, -inf, inf, std::numeric_limits<float>::quiet_NaN(), 1e30f, -1e30f};
+    std::vector<uint16_t> codes(values.size());
+    q.encode(values.data(), values.size(), codes.data());
+    for (size_t i = 0; i < values.size(); i++) {
+        EXPECT_EQ(codes[i], q.encode(values[i])) << i;
+    }
+    EXPECT_EQ(codes[0], 0);
+    EXPECT_EQ(codes[1], q.steps());
+    EXPECT_EQ(codes[2], 0);
+    EXPECT_EQ(codes[3], q.steps());
+    EXPECT_NEAR(q.decode(codes[4]), 0.0f, bound(q, 0.0f));  // NaN stops
+
+    // NaN clamps into a range that does not contain zero
+    Quantizer positive(1.0f, 2.0f, 0.5f);
+    EXPECT_EQ(positive.encode(std::numeric_limits<float>::quiet_NaN()), 0);
+}
+
+TEST(Quantizer, Twist2D) {
+    Twist2DQuantization quantization;
+    std::mt19937 rng(2);
+    std::uniform_real_distribution<float> linear(-4.0f, 4.0f), angular(-16.0f, 16.0f);
+    std::vector<Twist2D> twists(150);
+    for (auto &t : twists) {
+        t.vx = linear(rng);
+        t.vy = linear(rng);
+        t.wz = angular(rng);
+    }
+
+    std::vector<uint8_t> batch(twists.size() * Twist2DQuantization::SIZE);
+    quantization.serialize(twists.data(), twists.size(), batch.data());
+    std::vector<Twist2D> decoded(twists.size());
+    quantization.deserialize(batch.data(), decoded.size(), decoded.data());
+
+    std::vector<uint8_t> bytes(batch.size());
+    size_t offset = 0;
+    for (const auto &t : twists) {
+        quantization.serialize(t, bytes.data(), offset);
+    }
+    ASSERT_EQ(offset, bytes.size());
+    EXPECT_EQ(bytes, batch);
+
+    offset = 0;
+    for (size_t i = 0; i < twists.size(); i++) {
+        Twist2D t;
+        ASSERT_TRUE(quantization.deserialize(t, bytes.data(), bytes.size(), offset));
+        EXPECT_EQ(t.vx, decoded[i].vx);
+        EXPECT_EQ(t.vy, decoded[i].vy);
+        EXPECT_EQ(t.wz, decoded[i].wz);
+        EXPECT_LE(std::abs(t.vx - twists[i].vx), bound(quantization.linear, twists[i].vx));
+        EXPECT_LE(std::abs(t.vy - twists[i].vy), bound(quantization.linear, twists[i].vy));
+        EXPECT_LE(std::abs(t.wz - twists[i].wz), bound(quantization.angular, twists[i].wz));
+    }
+    Twist2D t;
+    EXPECT_FALSE(quantization.deserialize(t, bytes.data(), bytes.size(), offset));
+    offset = bytes.size() - Twist2DQuantization::SIZE + 1;
+    EXPECT_FALSE(quantization.deserialize(t, bytes.data(), bytes.size(), offset));
+}
+
+TEST(Quantizer, SerialStructs) {
+    static_assert(sizeof(serial_quantized_twist2D_t) == 14);
+    static_assert(sizeof(serial_quantized_pose2D_t) == 14);
+    EXPECT_LT(sizeof(serial_quantized_twist2D_t), sizeof(serial_twist2D_t));
+
+    SerialPose2DQuantization pose_quantization;
+    SerialTwist2DQuantization twist_quantization;
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<float> position(-32.0f, 32.0f), angle(-3.14159f, 3.14159f);
+    std::uniform_real_distribution<float> linear(-4.0f, 4.0f), angular(-16.0f, 16.0f);
+    std::vector<serial_pose2D_t> poses(100);
+    std::vector<serial_twist2D_t> twists(100);
+    for (size_t i = 0; i < poses.size(); i++) {
+        poses[i] = {static_cast<int64_t>(i) * 1000 - 7, position(rng), position(rng), angle(rng)};
+        twists[i] = {static_cast<int64_t>(i) * 20000, linear(rng), linear(rng), angular(rng)};
+    }
+
+    std::vector<serial_quantized_pose2D_t> qposes(poses.size());
+    std::vector<serial_quantized_twist2D_t> qtwists(twists.size());
+    pose_quantization.encode(poses.data(), poses.size(), qposes.data());
+    twist_quantization.encode(twists.data(), twists.size(), qtwists.data());
+    std::vector<serial_pose2D_t> dposes(poses.size());
+    std::vector<serial_twist2D_t> dtwists(twists.size());
+    pose_quantization.decode(qposes.data(), qposes.size(), dposes.data());
+    twist_quantization.decode(qtwists.data(), qtwists.size(), dtwists.data());
+
+    for (size_t i = 0; i < poses.size(); i++) {
+        const serial_pose2D_t pose = poses[i], decoded = dposes[i], one = pose_quantization.decode(pose_quantization.encode(pose));
+        EXPECT_EQ(decoded.utime, pose.utime);
+        EXPECT_EQ(one.x, decoded.x);
+        EXPECT_EQ(one.theta, decoded.theta);
+        EXPECT_LE(std::abs(decoded.x - pose.x), bound(pose_quantization.position, pose.x));
+        EXPECT_LE(std::abs(decoded.y - pose.y), bound(pose_quantization.position, pose.y));
+        EXPECT_LE(std::abs(decoded.theta - pose.theta), bound(pose_quantization.angle, pose.theta));
+
+        const serial_twist2D_t twist = twists[i], dtwist = dtwists[i], tone = twist_quantization.decode(twist_quantization.encode(twist));
+        EXPECT_EQ(dtwist.utime, twist.utime);
+        EXPECT_EQ(tone.vy, dtwist.vy);
+        EXPECT_EQ(tone.wz, dtwist.wz);
+        EXPECT_LE(std::abs(dtwist.vx - twist.vx), bound(twist_quantization.linear, twist.vx));
+        EXPECT_LE(std::abs(dtwist.vy - twist.vy), bound(twist_quantization.linear, twist.vy));
+        EXPECT_LE(std::abs(dtwist.wz - twist.wz), bound(twist_quantization.angular, twist.wz));
+    }
+}
@@ -0,0 +1,144 @@
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "rix/util/clock.hpp"
+#include "rix/util/time.hpp"
+
+using namespace rix::util;
+
+namespace {
+
+/**
+ * @brief Runs the Rate on simulated time, so that wakeups are exactly on
+ * their deadlines unless a test makes them late.
+ */
+class RateTest : public ::testing::Test {
+   protected:
+    void SetUp() override { SimulatedClock::start(Time(1000.0)); }
+    void TearDown() override { SimulatedClock::stop(); }
+
+    /**
+     * @brief Calls `rate.sleep()` on this thread while another moves
+     * simulated time to each deadline it waits for.
+     */
+    static bool stepped_sleep(Rate &rate) {
+        std::atomic<bool> done{false};
+        std::thread stepper([&] {
+            while (!done) {
+                if (!SimulatedClock::step()) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+        bool on_time = rate.sleep();
+        done = true;
+        stepper.join();
+        return on_time;
+    }
+};
+
+}  // namespace
+
+TEST_F(RateTest, SleepModeWaitsOnePeriod) {
+    Rate rate(Duration(0.01));
+    EXPECT_EQ(rate.mode(), Rate::Mode::SLEEP);
+    Time start = Time::now();
+    EXPECT_TRUE(stepped_sleep(rate));
+    EXPECT_EQ(Time::now() - start, Duration(0.01));
+    EXPECT_EQ(rate.stats().cycles, 1);
+    EXPECT_EQ(rate.stats().overruns, 0);
+}
+
+TEST_F(RateTest, SleepModeReportsOverrun) {
+    Rate rate(Duration(0.005));
+    SimulatedClock::advance(Duration(0.01));
+    EXPECT_FALSE(rate.sleep());
+    EXPECT_EQ(rate.stats().overruns, 1);
+    EXPECT_EQ(rate.stats().last_lateness, Duration(0.005));
+}
+
+TEST_F(RateTest, PreciseKeepsSchedule) {
+    const int cycles = 200;
+    Rate rate(1000.0, Rate::Mode::PRECISE, Rate::Overrun::CATCH_UP);
+    Time start = Time::now();
+    for (int i = 0; i < cycles; i++) {
+        if (i == 100) {
+            // Make the next wakeup 0.5 ms late
+            SimulatedClock::advance(Duration(0.0015));
+        }
+        stepped_sleep(rate);
+    }
+
+    // Deadlines are fixed, so the late wakeup does not delay the rest
+    EXPECT_EQ(Time::now() - start, Duration(0.2));
+    const Rate::Stats &stats = rate.stats();
+    EXPECT_EQ(stats.cycles, cycles);
+    EXPECT_EQ(stats.overruns, 1);
+    EXPECT_EQ(stats.max_lateness, Duration(0.0005));
+    EXPECT_EQ(stats.last_lateness, Duration(0.0));
+    EXPECT_GT(stats.mean_lateness(), Duration(0.0));
+    EXPECT_LE(stats.mean_lateness(), stats.max_lateness);
+}
+
+TEST_F(RateTest, PreciseSkipDropsMissedDeadlines) {
+    Rate rate(Duration(0.01), Rate::Mode::PRECISE, Rate::Overrun::SKIP);
+    Time first = Time::now() + Duration(0.01);
+    SimulatedClock::advance(Duration(0.035));
+    EXPECT_FALSE(rate.sleep());
+    EXPECT_EQ(rate.stats().overruns, 1);
+    // The deadline at 10 ms ran late; those at 20 and 30 ms are dropped
+    EXPECT_EQ(rate.stats().skipped, 2);
+
+    // The next wakeup keeps the original phase
+    EXPECT_TRUE(stepped_sleep(rate));
+    EXPECT_EQ(Time::now(), first + Duration(0.03));
+}
+
+TEST_F(RateTest, PreciseCatchUpRunsMissedCycles) {
+    Rate rate(Duration(0.01), Rate::Mode::PRECISE, Rate::Overrun::CATCH_UP);
+    Time first = Time::now() + Duration(0.01);
+    SimulatedClock::advance(Duration(0.035));
+    // Deadlines at 10, 20 and 30 ms have passed and run back to back
+    EXPECT_FALSE(rate.sleep());
+    EXPECT_FALSE(rate.sleep());
+    EXPECT_FALSE(rate.sleep());
+    EXPECT_TRUE(stepped_sleep(rate));
+    EXPECT_EQ(Time::now(), first + Duration(0.03));
+    EXPECT_EQ(rate.stats().overruns, 3);
+    EXPECT_EQ(rate.stats().skipped, 0);
+    EXPECT_EQ(rate.stats().cycles, 4);
+}
+
+TEST_F(RateTest, PreciseSkipWithZeroPeriod) {
+    Rate rate(Duration(0.01), Rate::Mode::PRECISE, Rate::Overrun::SKIP);
+    rate.set_period(Duration(0.0));
+    SimulatedClock::advance(Duration(0.035));
+    EXPECT_FALSE(rate.sleep());
+    EXPECT_FALSE(rate.sleep());
+    EXPECT_EQ(rate.stats().overruns, 2);
+    EXPECT_EQ(rate.stats().skipped, 0);
+    EXPECT_EQ(rate.stats().last_lateness, Duration(0.0));
+}
+
+TEST_F(RateTest, ResetStats) {
+    Rate rate(Duration(0.001), Rate::Mode::PRECISE);
+    stepped_sleep(rate);
+    stepped_sleep(rate);
+    EXPECT_EQ(rate.stats().cycles, 2);
+    rate.reset_stats();
+    EXPECT_EQ(rate.stats().cycles, 0);
+    EXPECT_EQ(rate.stats().mean_lateness(), Duration(0.0));
+}
+
+TEST(Rate, SleepsInRealTime) {
+    Rate rate(Duration(0.01));
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_TRUE(rate.sleep());
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    // Loose bounds: never early, and not stuck
+    EXPECT_GE(elapsed, std::chrono::milliseconds(9));
+    EXPECT_LT(elapsed, std::chrono::seconds(1));
+}
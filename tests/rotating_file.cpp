@@ -0,0 +1,208 @@
+#include "rix/util/rotating_file.hpp"
+
+#include <dirent.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "rix/util/clock.hpp"
+
+using namespace rix::util;
+
+namespace {
+
+class RotatingFileTest : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        char templ[] = "/tmp/rix_rotating_file_XXXXXX";
+        ASSERT_NE(mkdtemp(templ), nullptr);
+        dir = templ;
+    }
+
+    void TearDown() override {
+        for (const auto &file : files()) {
+            unlink((dir + "/" + file).c_str());
+        }
+        rmdir(dir.c_str());
+    }
+
+    // Returns the log files in `dir`, oldest first
+    std::vector<std::string> files() const {
+        std::vector<std::string> result;
+        DIR *d = opendir(dir.c_str());
+        while (struct dirent *entry = readdir(d)) {
+            std::string name(entry->d_name);
+            if (name != "." && name != "..") {
+                result.push_back(name);
+            }
+        }
+        closedir(d);
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+
+    std::string read(const std::string &file) const {
+        std::ifstream in(dir + "/" + file);
+        std::stringstream ss;
+        ss << in.rdbuf();
+        return ss.str();
+    }
+
+    void write(RotatingFile &file, const std::string &data) {
+        file.sputn(data.data(), data.size());
+        file.pubsync();
+    }
+
+    std::string dir;
+};
+
+}  // namespace
+
+TEST_F(RotatingFileTest, WritesAndFlushes) {
+    RotatingFile file;
+    ASSERT_TRUE(file.open(dir, "test"));
+    EXPECT_TRUE(file.is_open());
+    write(file, "hello\n");
+    write(file, "world\n");
+    EXPECT_TRUE(file.flush());
+    EXPECT_EQ(file.bytes_written(), 12);
+    EXPECT_GE(file.syncs(), 1);
+
+    auto names = files();
+    ASSERT_EQ(names.size(), 1);
+    EXPECT_EQ(dir + "/" + names[0], file.path());
+    EXPECT_EQ(read(names[0]), "hello\nworld\n");
+
+    file.close();
+    EXPECT_FALSE(file.is_open());
+    struct stat st;
+    ASSERT_EQ(stat(file.path().c_str(), &st), 0);
+    // Preallocated space past the data is released on close
+    EXPECT_EQ(st.st_size, 12);
+}
+
+TEST_F(RotatingFileTest, RotatesBySizeWithoutSplittingWrites) {
+    RotatingFile::Options options;
+    options.max_bytes = 100;
+    options.max_files = 0;
+    RotatingFile file;
+    ASSERT_TRUE(file.open(dir, "test", options));
+
+    std::string expected;
+    for (int i = 0; i < 50; i++) {
+        std::string line = "line " + std::to_string(i) + "\n";
+        expected += line;
+        write(file, line);
+        file.flush();
+    }
+    file.close();
+
+    auto names = files();
+    EXPECT_GT(names.size(), 1);
+    EXPECT_EQ(file.rotations(), names.size() - 1);
+    std::string contents;
+    for (const auto &name : names) {
+        std::string data = read(name);
+        EXPECT_LE(data.size(), options.max_bytes);
+        EXPECT_EQ(data.back(), '\n');
+        contents += data;
+    }
+    EXPECT_EQ(contents, expected);
+}
+
+TEST_F(RotatingFileTest, Retention) {
+    RotatingFile::Options options;
+    options.max_bytes = 10;
+    options.max_files = 3;
+    RotatingFile file;
+    ASSERT_TRUE(file.open(dir, "test", options));
+    for (int i = 0; i < 10; i++) {
+        write(file, "0123456789");
+        file.flush();
+    }
+    file.close();
+
+    auto names = files();
+    ASSERT_EQ(names.size(), 3);
+    EXPECT_EQ(file.rotations(), 9);
+    EXPECT_EQ(dir + "/" + names.back(), file.path());
+}
+
+TEST_F(RotatingFileTest, RotatesWithinOneClockReading) {
+    // Time::now does not move, but every rotation still gets a new file
+    SimulatedClock::start(Time(1000.0));
+    RotatingFile::Options options;
+    options.max_bytes = 10;
+    options.max_files = 0;
+    RotatingFile file;
+    ASSERT_TRUE(file.open(dir, "test", options));
+    for (const char *data : {"first....\n", "second...\n", "third....\n"}) {
+        write(file, data);
+        file.flush();
+    }
+    file.close();
+    SimulatedClock::stop();
+
+    auto names = files();
+    ASSERT_EQ(names.size(), 3);
+    EXPECT_EQ(file.rotations(), 2);
+    EXPECT_EQ(read(names[0]), "first....\n");
+    EXPECT_EQ(read(names[1]), "second...\n");
+    EXPECT_EQ(read(names[2]), "third....\n");
+}
+
+TEST_F(RotatingFileTest, RotatesByAge) {
+    RotatingFile::Options options;
+    options.max_age = Duration(0.05);
+    options.max_files = 0;
+    RotatingFile file;
+    ASSERT_TRUE(file.open(dir, "test", options));
+    write(file, "first\n");
+    file.flush();
+    sleep_for(Duration(0.1));
+    write(file, "second\n");
+    file.flush();
+    file.close();
+
+    auto names = files();
+    ASSERT_EQ(names.size(), 2);
+    EXPECT_EQ(read(names[0]), "first\n");
+    EXPECT_EQ(read(names[1]), "second\n");
+}
+
+TEST_F(RotatingFileTest, BackgroundThreadWritesAndSyncs) {
+    RotatingFile::Options options;
+    options.sync_interval = Duration(0.02);
+    RotatingFile file;
+    ASSERT_TRUE(file.open(dir, "test", options));
+    write(file, "background\n");
+
+    Time deadline = Time::now() + Duration(2.0);
+    while (file.syncs() == 0 && Time::now() < deadline) {
+        sleep_for(Duration(0.005));
+    }
+    EXPECT_EQ(file.bytes_written(), 11);
+    EXPECT_GE(file.syncs(), 1);
+    EXPECT_EQ(read(files()[0]), "background\n");
+}
+
+TEST_F(RotatingFileTest, DropsWhenPendingIsFull) {
+    RotatingFile::Options options;
+    options.max_pending = 8;
+    options.write_interval = Duration(10.0);
+    RotatingFile file;
+    ASSERT_TRUE(file.open(dir, "test", options));
+    file.sputn("12345678", 8);
+    file.sputn("9", 1);
+    EXPECT_EQ(file.dropped(), 1);
+    file.close();
+    EXPECT_EQ(read(files()[0]), "12345678");
+}
@@ -0,0 +1,136 @@
+#include "rix/util/scheduler.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "rix/util/clock.hpp"
+
+using namespace rix::util;
+
+namespace {
+
+/**
+ * @brief Waits in real time until `pred` holds.
+ */
+bool eventually(const std::function<bool()> &pred) {
+    for (int i = 0; i < 2000; i++) {
+        if (pred()) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return false;
+}
+
+/**
+ * @brief Runs the scheduler on simulated time, so that each test decides
+ * exactly when deadlines pass.
+ */
+class SchedulerTest : public ::testing::Test {
+   protected:
+    void SetUp() override { SimulatedClock::start(Time(1000.0)); }
+    void TearDown() override { SimulatedClock::stop(); }
+};
+
+}  // namespace
+
+TEST_F(SchedulerTest, RunsPeriodically) {
+    Scheduler scheduler;
+    std::atomic<int> count{0};
+    scheduler.add(Duration(0.01), [&] { count++; });
+    ASSERT_TRUE(eventually([&] { return count == 1; }));
+    for (int i = 2; i <= 11; i++) {
+        SimulatedClock::advance(Duration(0.01));
+        ASSERT_TRUE(eventually([&] { return count == i; }));
+    }
+    SimulatedClock::advance(Duration(0.005));
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    EXPECT_EQ(count, 11);
+}
+
+TEST_F(SchedulerTest, RunsMultipleJobsInDeadlineOrder) {
+    Scheduler scheduler;
+    std::mutex mtx;
+    std::vector<int> order;
+    auto size = [&] {
+        std::lock_guard<std::mutex> g(mtx);
+        return order.size();
+    };
+    scheduler.add(Duration(1.0), [&] { std::lock_guard<std::mutex> g(mtx); order.push_back(2); }, Duration(0.02));
+    scheduler.add(Duration(1.0), [&] { std::lock_guard<std::mutex> g(mtx); order.push_back(1); }, Duration(0.01));
+    scheduler.add(Duration(1.0), [&] { std::lock_guard<std::mutex> g(mtx); order.push_back(3); }, Duration(0.03));
+    SimulatedClock::advance(Duration(0.06));
+    ASSERT_TRUE(eventually([&] { return size() == 3; }));
+    std::lock_guard<std::mutex> g(mtx);
+    EXPECT_EQ(order, (std::vector<int>{1, 2, 3}));
+}
+
+TEST_F(SchedulerTest, Cancel) {
+    Scheduler scheduler;
+    std::atomic<int> count{0};
+    auto id = scheduler.add(Duration(0.01), [&] { count++; });
+    EXPECT_EQ(scheduler.size(), 1);
+    ASSERT_TRUE(eventually([&] { return count == 1; }));
+    for (int i = 2; i <= 4; i++) {
+        SimulatedClock::advance(Duration(0.01));
+        ASSERT_TRUE(eventually([&] { return count == i; }));
+    }
+    EXPECT_TRUE(scheduler.cancel(id));
+    EXPECT_FALSE(scheduler.cancel(id));
+    EXPECT_EQ(scheduler.size(), 0);
+    SimulatedClock::advance(Duration(0.03));
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    EXPECT_EQ(count, 4);
+}
+
+TEST_F(SchedulerTest, SelfCancel) {
+    Scheduler scheduler;
+    std::atomic<int> count{0};
+    Scheduler::JobId id = 0;
+    id = scheduler.add(Duration(0.005), [&] {
+        if (++count == 3) {
+            scheduler.cancel(id);
+        }
+    });
+    ASSERT_TRUE(eventually([&] { return count == 1; }));
+    for (int i = 2; i <= 3; i++) {
+        SimulatedClock::advance(Duration(0.005));
+        ASSERT_TRUE(eventually([&] { return count == i; }));
+    }
+    EXPECT_TRUE(eventually([&] { return scheduler.size() == 0; }));
+    SimulatedClock::advance(Duration(0.05));
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    EXPECT_EQ(count, 3);
+}
+
+TEST_F(SchedulerTest, StopIsPrompt) {
+    // The next deadline never comes unless simulated time is advanced, so
+    // stopping must not wait for it
+    auto start = std::chrono::steady_clock::now();
+    {
+        Scheduler scheduler;
+        std::atomic<int> count{0};
+        scheduler.add(Duration(10.0), [&] { count++; });
+        ASSERT_TRUE(eventually([&] { return count == 1; }));
+    }
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(1));
+}
+
+TEST(Scheduler, RunsPeriodicallyInRealTime) {
+    Scheduler scheduler;
+    std::atomic<int> count{0};
+    auto start = std::chrono::steady_clock::now();
+    scheduler.add(Duration(0.01), [&] { count++; });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    int runs = count;
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // Loose bounds: the first run is immediate, and there are never more runs
+    // than periods have passed
+    EXPECT_GE(runs, 1);
+    EXPECT_LE(runs, elapsed / 0.01 + 2);
+}
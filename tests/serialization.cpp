@@ -9,6 +9,7 @@ x size_message_array
 x size_number_vector
 x size_string_vector
 x size_message_vector
+x size_indexed_message_vector
 
 x serialize_number
 x serialize_string
@@ -19,6 +20,7 @@ x serialize_message_array
 x serialize_number_vector
 x serialize_string_vector
 x serialize_message_vector
+x serialize_indexed_message_vector
 
 deserialize_number
 deserialize_string
@@ -29,6 +31,7 @@ deserialize_message_array
 deserialize_number_vector
 deserialize_string_vector
 deserialize_message_vector
+deserialize_indexed_message_vector
 */
 
 #include "rix/msg/serialization.hpp"
@@ -36,6 +39,8 @@ deserialize_message_vector
 #include <gtest/gtest.h>
 
 #include "rix/msg/message.hpp"
+#include "rix/msg/message_vector_view.hpp"
+#include "rix/msg/standard/Header.hpp"
 
 using namespace rix::msg::detail;
 
@@ -643,3 +648,151 @@ TEST(DeserializeTest, MessageVector_Success) {
     EXPECT_TRUE(deserialize_message_vector(result, bytes.data(), bytes.size(), offset));
     EXPECT_EQ(result, input);
 }
+
+namespace {
+
+std::vector<rix::msg::standard::Header> headers(size_t n) {
+    std::vector<rix::msg::standard::Header> vec(n);
+    for (size_t i = 0; i < n; i++) {
+        vec[i].seq = i;
+        vec[i].stamp.sec = i * 10;
+        vec[i].frame_id = std::string(i % 7, 'a' + i % 26);  // Elements of different sizes
+    }
+    return vec;
+}
+
+}  // namespace
+
+TEST(Size, IndexedMessageVectorTest) {
+    std::vector<TestMessage> vec(3);
+    EXPECT_EQ(size_indexed_message_vector(vec), 32) << "size_indexed_message_vector incorrect.";
+    EXPECT_EQ(size_indexed_message_vector(std::vector<TestMessage>()), 8) << "size_indexed_message_vector incorrect.";
+}
+
+TEST(Serialize, IndexedMessageVectorTest) {
+    std::vector<uint8_t> buffer(256);
+    std::vector<TestMessage> vec(3);
+    vec[0].value = 1;
+    vec[1].value = 2;
+    vec[2].value = 3;
+    size_t offset = 0;
+    serialize_indexed_message_vector(buffer.data(), offset, vec);
+    EXPECT_EQ(offset, 32) << "serialize_indexed_message_vector offset incorrect.";
+
+    uint32_t words[8];
+    std::memcpy(words, buffer.data(), sizeof(words));
+    EXPECT_EQ(words[0], 3) << "count incorrect.";
+    EXPECT_EQ(words[1], 12) << "byte length incorrect.";
+    EXPECT_EQ(words[2], 1);
+    EXPECT_EQ(words[3], 2);
+    EXPECT_EQ(words[4], 3);
+    EXPECT_EQ(words[5], 0) << "offset table incorrect.";
+    EXPECT_EQ(words[6], 4) << "offset table incorrect.";
+    EXPECT_EQ(words[7], 8) << "offset table incorrect.";
+}
+
+TEST(Deserialize, IndexedMessageVector_Success) {
+    auto input = headers(50);
+    std::vector<uint8_t> bytes(size_indexed_message_vector(input) + 3);
+    size_t offset = 3;
+    serialize_indexed_message_vector(bytes.data(), offset, input);
+    ASSERT_EQ(offset, bytes.size());
+
+    std::vector<rix::msg::standard::Header> result;
+    offset = 3;
+    EXPECT_TRUE(deserialize_indexed_message_vector(result, bytes.data(), bytes.size(), offset));
+    EXPECT_EQ(offset, bytes.size());
+    ASSERT_EQ(result.size(), input.size());
+    for (size_t i = 0; i < input.size(); i++) {
+        EXPECT_EQ(result[i].seq, input[i].seq);
+        EXPECT_EQ(result[i].stamp.sec, input[i].stamp.sec);
+        EXPECT_EQ(result[i].frame_id, input[i].frame_id);
+    }
+}
+
+TEST(Deserialize, IndexedMessageVector_Fail) {
+    auto input = headers(5);
+    std::vector<uint8_t> bytes(size_indexed_message_vector(input));
+    size_t offset = 0;
+    serialize_indexed_message_vector(bytes.data(), offset, input);
+
+    std::vector<rix::msg::standard::Header> result;
+    for (size_t size = 0; size < bytes.size(); size++) {
+        offset = 0;
+        EXPECT_FALSE(deserialize_indexed_message_vector(result, bytes.data(), size, offset)) << size;
+    }
+
+    // A table entry that does not match where the element starts
+    std::vector<uint8_t> bad = bytes;
+    bad[bad.size() - 4]++;
+    offset = 0;
+    EXPECT_FALSE(deserialize_indexed_message_vector(result, bad.data(), bad.size(), offset));
+
+    // A count too large for the table
+    uint32_t huge = 0x40000000;
+    bad = bytes;
+    std::memcpy(bad.data(), &huge, sizeof(huge));
+    offset = 0;
+    EXPECT_FALSE(deserialize_indexed_message_vector(result, bad.data(), bad.size(), offset));
+}
+
+TEST(MessageVectorView, RandomAccess) {
+    auto input = headers(1000);
+    std::vector<uint8_t> bytes(size_indexed_message_vector(input) + 4);
+    size_t offset = 0;
+    serialize_indexed_message_vector(bytes.data(), offset, input);
+    serialize_number(bytes.data(), offset, uint32_t(0xabcd));
+
+    rix::msg::MessageVectorView<rix::msg::standard::Header> view;
+    offset = 0;
+    ASSERT_TRUE(view.parse(bytes.data(), bytes.size(), offset));
+    EXPECT_EQ(offset, bytes.size() - 4);
+    ASSERT_EQ(view.size(), input.size());
+
+    for (size_t i : {999, 0, 500, 1, 998, 7}) {
+        rix::msg::standard::Header header;
+        ASSERT_TRUE(view.get(i, header)) << i;
+        EXPECT_EQ(header.seq, input[i].seq);
+        EXPECT_EQ(header.frame_id, input[i].frame_id);
+        EXPECT_EQ(view.bytes(i).size(), input[i].size());
+    }
+    rix::msg::standard::Header header;
+    EXPECT_FALSE(view.get(1000, header));
+    EXPECT_TRUE(view.bytes(1000).empty());
+
+    rix::msg::MessageVectorView<rix::msg::standard::Header> empty;
+    EXPECT_TRUE(empty.empty());
+    EXPECT_FALSE(empty.get(0, header));
+}
+
+TEST(MessageVectorView, CorruptEntries) {
+    auto input = headers(10);
+    std::vector<uint8_t> bytes(size_indexed_message_vector(input));
+    size_t offset = 0;
+    serialize_indexed_message_vector(bytes.data(), offset, input);
+
+    rix::msg::MessageVectorView<rix::msg::standard::Header> view;
+    for (size_t size = 0; size < bytes.size(); size++) {
+        offset = 0;
+        EXPECT_FALSE(view.parse(bytes.data(), size, offset)) << size;
+    }
+
+    // Point element 4 past the end of the elements: only elements 3 and 4,
+    // whose extents use that entry, are lost
+    uint32_t elements = 0;
+    for (const auto &header : input) {
+        elements += header.size();
+    }
+    const size_t entry = 8 + elements + 4 * 4;
+    ASSERT_LE(entry + 4, bytes.size());
+    uint32_t past = 0xffff;
+    for (size_t b = 0; b < sizeof(past); b++) {
+        bytes.at(entry + b) = static_cast<uint8_t>(past >> (8 * b));
+    }
+    offset = 0;
+    ASSERT_TRUE(view.parse(bytes.data(), bytes.size(), offset));
+    rix::msg::standard::Header header;
+    for (size_t i = 0; i < view.size(); i++) {
+        EXPECT_EQ(view.get(i, header), i != 3 && i != 4) << i;
+    }
+}
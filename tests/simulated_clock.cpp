@@ -0,0 +1,211 @@
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "rix/ipc/pipe.hpp"
+#include "rix/util/clock.hpp"
+#include "rix/util/scheduler.hpp"
+
+using namespace rix::util;
+
+namespace {
+
+/**
+ * @brief Waits in real time until `n` threads wait for simulated time.
+ */
+bool wait_for_waiters(size_t n) {
+    for (int i = 0; i < 2000; i++) {
+        if (SimulatedClock::waiting() == n) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return false;
+}
+
+/**
+ * @brief Waits in real time until `count` reaches `n`.
+ */
+bool wait_for_count(const std::atomic<int> &count, int n) {
+    for (int i = 0; i < 2000; i++) {
+        if (count == n) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return false;
+}
+
+class SimulatedClockTest : public ::testing::Test {
+   protected:
+    void SetUp() override { SimulatedClock::start(Time(1000.0)); }
+    void TearDown() override { SimulatedClock::stop(); }
+};
+
+}  // namespace
+
+TEST_F(SimulatedClockTest, OnlyMovesWhenDriven) {
+    EXPECT_TRUE(SimulatedClock::running());
+    EXPECT_EQ(clock_source(), ClockSource::SIMULATED);
+    EXPECT_EQ(Time::now(), Time(1000.0));
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    EXPECT_EQ(Time::now(), Time(1000.0));
+
+    SimulatedClock::advance(Duration(1.5));
+    EXPECT_EQ(Time::now(), Time(1001.5));
+    SimulatedClock::set(Time(1001.0));
+    EXPECT_EQ(Time::now(), Time(1001.5));
+    SimulatedClock::set(Time(1002.0));
+    EXPECT_EQ(Time::now(), Time(1002.0));
+}
+
+TEST_F(SimulatedClockTest, StopRestoresPreviousSource) {
+    SimulatedClock::stop();
+    EXPECT_FALSE(SimulatedClock::running());
+    EXPECT_EQ(clock_source(), ClockSource::SYSTEM);
+    EXPECT_GT(Time::now(), Time(1'000'000'000.0));
+}
+
+TEST_F(SimulatedClockTest, SleepWaitsForSimulatedTime) {
+    std::atomic<bool> done{false};
+    std::thread sleeper([&] {
+        sleep_for(Duration(10.0));
+        done = true;
+    });
+    ASSERT_TRUE(wait_for_waiters(1));
+    SimulatedClock::advance(Duration(5.0));
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    EXPECT_FALSE(done);
+    SimulatedClock::advance(Duration(5.0));
+    sleeper.join();
+    EXPECT_TRUE(done);
+    EXPECT_EQ(SimulatedClock::waiting(), 0);
+}
+
+TEST_F(SimulatedClockTest, StepWakesSleepersInDeadlineOrder) {
+    std::vector<int> order;
+    std::mutex mtx;
+    auto sleeper = [&](int id, double at) {
+        sleep_until(Time(at));
+        std::lock_guard<std::mutex> guard(mtx);
+        order.push_back(id);
+    };
+    std::thread late(sleeper, 2, 1003.0);
+    std::thread early(sleeper, 1, 1001.0);
+    ASSERT_TRUE(wait_for_waiters(2));
+
+    EXPECT_TRUE(SimulatedClock::step());
+    EXPECT_EQ(Time::now(), Time(1001.0));
+    early.join();
+    ASSERT_TRUE(wait_for_waiters(1));
+    EXPECT_TRUE(SimulatedClock::step());
+    EXPECT_EQ(Time::now(), Time(1003.0));
+    late.join();
+
+    EXPECT_EQ(order, (std::vector<int>{1, 2}));
+    EXPECT_FALSE(SimulatedClock::step());
+}
+
+TEST_F(SimulatedClockTest, RateRunsFasterThanRealTime) {
+    const int cycles = 1000;
+    std::atomic<bool> done{false};
+    Rate::Stats stats;
+    Time start = Time::now();
+    std::thread loop([&] {
+        Rate rate(1000.0, Rate::Mode::PRECISE);
+        for (int i = 0; i < cycles; i++) {
+            rate.sleep();
+        }
+        stats = rate.stats();
+        done = true;
+    });
+
+    auto real_start = std::chrono::steady_clock::now();
+    while (!done) {
+        if (!SimulatedClock::step()) {
+            std::this_thread::yield();
+        }
+    }
+    loop.join();
+
+    // One simulated second, exactly, in a fraction of a real one
+    EXPECT_EQ(Time::now() - start, Duration(1.0));
+    EXPECT_LT(std::chrono::steady_clock::now() - real_start, std::chrono::milliseconds(900));
+    EXPECT_EQ(stats.cycles, cycles);
+    EXPECT_EQ(stats.overruns, 0);
+    EXPECT_EQ(stats.max_lateness, Duration(0.0));
+}
+
+TEST_F(SimulatedClockTest, IoTimeoutsUseSimulatedTime) {
+    auto [reader, writer] = rix::ipc::Pipe::create();
+
+    std::atomic<int> result{-1};
+    std::thread waiter([&, &reader = reader] { result = reader.wait_for_readable(Duration(2.0)); });
+    ASSERT_TRUE(wait_for_waiters(1));
+    SimulatedClock::advance(Duration(1.0));
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    EXPECT_EQ(result, -1);
+    SimulatedClock::advance(Duration(1.0));
+    waiter.join();
+    EXPECT_EQ(result, 0);
+
+    // Data still ends the wait without any simulated time passing
+    std::thread reader_thr([&, &reader = reader] { result = reader.wait_for_readable(Duration(2.0)); });
+    ASSERT_TRUE(wait_for_waiters(1));
+    uint8_t byte = 1;
+    writer.write(&byte, 1);
+    reader_thr.join();
+    EXPECT_EQ(result, 1);
+    EXPECT_EQ(Time::now(), Time(1002.0));
+}
+
+TEST_F(SimulatedClockTest, StopWakesWaiters) {
+    std::thread sleeper([] { sleep_for(Duration(100.0)); });
+    ASSERT_TRUE(wait_for_waiters(1));
+    SimulatedClock::stop();
+    sleeper.join();
+    EXPECT_EQ(SimulatedClock::waiting(), 0);
+}
+
+TEST_F(SimulatedClockTest, SchedulerRunsOnSimulatedTime) {
+    Scheduler scheduler;
+    std::atomic<int> count{0};
+    scheduler.add(Duration(1.0), [&] { count++; }, Duration(1.0));
+    ASSERT_TRUE(wait_for_waiters(1));
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    EXPECT_EQ(count, 0);
+
+    for (int i = 1; i <= 3; i++) {
+        ASSERT_TRUE(wait_for_waiters(1));
+        SimulatedClock::advance(Duration(1.0));
+        ASSERT_TRUE(wait_for_count(count, i));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    EXPECT_EQ(count, 3);
+}
+
+TEST_F(SimulatedClockTest, SchedulerWakesForEarlierJob) {
+    Scheduler scheduler;
+    std::atomic<int> late{0}, early{0};
+    scheduler.add(Duration(10.0), [&] { late++; }, Duration(10.0));
+    ASSERT_TRUE(wait_for_waiters(1));
+
+    // The worker must stop waiting for the later deadline to run this one
+    scheduler.add(Duration(10.0), [&] { early++; }, Duration(1.0));
+    SimulatedClock::advance(Duration(1.0));
+    ASSERT_TRUE(wait_for_count(early, 1));
+    EXPECT_EQ(late, 0);
+}
+
+TEST_F(SimulatedClockTest, SchedulerStopsWhileWaiting) {
+    Scheduler scheduler;
+    scheduler.add(Duration(100.0), [] {}, Duration(100.0));
+    ASSERT_TRUE(wait_for_waiters(1));
+    scheduler.stop();
+    EXPECT_EQ(scheduler.size(), 0);
+    EXPECT_EQ(SimulatedClock::waiting(), 0);
+    EXPECT_EQ(Time::now(), Time(1000.0));
+}
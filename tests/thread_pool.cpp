@@ -0,0 +1,114 @@
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "rix/util/thread_pool.hpp"
+
+using namespace rix::util;
+
+TEST(ThreadPoolTest, RunsEveryTask) {
+    ThreadPool pool(4);
+    EXPECT_EQ(pool.size(), 4);
+    std::atomic<int> sum(0);
+    for (int i = 1; i <= 1000; i++) {
+        pool.submit([&sum, i] { sum += i; });
+    }
+    pool.wait();
+    EXPECT_EQ(sum.load(), 500500);
+
+    // The pool can be reused after waiting
+    pool.submit([&sum] { sum = 0; });
+    pool.wait();
+    EXPECT_EQ(sum.load(), 0);
+}
+
+TEST(ThreadPoolTest, RunsInParallel) {
+    // Each task waits for the other to start, which only happens if they run
+    // at the same time
+    ThreadPool pool(2);
+    std::atomic<int> started(0);
+    std::atomic<int> met(0);
+    for (int i = 0; i < 2; i++) {
+        pool.submit([&] {
+            started++;
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+            while (started < 2 && std::chrono::steady_clock::now() < deadline) {
+                std::this_thread::yield();
+            }
+            if (started == 2) {
+                met++;
+            }
+        });
+    }
+    pool.wait();
+    EXPECT_EQ(met.load(), 2);
+}
+
+TEST(ThreadPoolTest, ParallelFor) {
+    ThreadPool pool(3);
+    EXPECT_EQ(pool.worker(), pool.size());
+
+    std::vector<int> hits(1000, 0);
+    std::vector<size_t> workers(1000, pool.size());
+    pool.parallel_for(hits.size(), [&](size_t i) {
+        hits[i]++;
+        workers[i] = pool.worker();
+    });
+    for (size_t i = 0; i < hits.size(); i++) {
+        EXPECT_EQ(hits[i], 1);
+        EXPECT_LT(workers[i], pool.size());
+    }
+
+    // Nested loops run on the calling worker rather than deadlocking
+    std::atomic<int> inner(0);
+    pool.parallel_for(3, [&](size_t) { pool.parallel_for(10, [&](size_t) { inner++; }); });
+    EXPECT_EQ(inner.load(), 30);
+}
+
+TEST(ThreadPoolTest, StealsFromBusyWorkers) {
+    // Tasks submitted by one worker land in its own queue; the others must
+    // steal them to run them in parallel
+    ThreadPool pool(2);
+    std::atomic<int> started(0);
+    std::atomic<int> met(0);
+    pool.submit([&] {
+        for (int i = 0; i < 2; i++) {
+            pool.submit([&] {
+                started++;
+                auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+                while (started < 2 && std::chrono::steady_clock::now() < deadline) {
+                    std::this_thread::yield();
+                }
+                met += started == 2;
+            });
+        }
+    });
+    pool.wait();
+    EXPECT_EQ(met.load(), 2);
+}
+
+TEST(ThreadPoolTest, DestructorDrainsQueue) {
+    std::atomic<int> count(0);
+    {
+        ThreadPool pool(1);
+        for (int i = 0; i < 100; i++) {
+            pool.submit([&count] {
+                std::this_thread::sleep_for(std::chrono::microseconds(10));
+                count++;
+            });
+        }
+    }
+    EXPECT_EQ(count.load(), 100);
+}
+
+TEST(ThreadPoolTest, AtLeastOneThread) {
+    ThreadPool pool(0);
+    EXPECT_EQ(pool.size(), 1);
+    bool ran = false;
+    pool.submit([&ran] { ran = true; });
+    pool.wait();
+    EXPECT_TRUE(ran);
+}
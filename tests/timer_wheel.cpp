@@ -0,0 +1,168 @@
+#include "rix/util/timer_wheel.hpp"
+
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace rix::util;
+
+namespace {
+
+const Duration MS(0.001);
+
+}  // namespace
+
+TEST(TimerWheel, FiresAtDeadline) {
+    Time t0 = Time::now();
+    TimerWheel wheel(MS, t0);
+    int fired = 0;
+    wheel.schedule_at(t0 + MS * 10, [&] { fired++; });
+    EXPECT_EQ(wheel.size(), 1);
+
+    EXPECT_EQ(wheel.advance(t0 + MS * 9), 0);
+    EXPECT_EQ(fired, 0);
+    EXPECT_EQ(wheel.advance(t0 + MS * 10), 1);
+    EXPECT_EQ(fired, 1);
+    EXPECT_TRUE(wheel.empty());
+    EXPECT_EQ(wheel.advance(t0 + MS * 100), 0);
+}
+
+TEST(TimerWheel, RoundsDeadlinesUp) {
+    Time t0 = Time::now();
+    TimerWheel wheel(MS, t0);
+    int fired = 0;
+    wheel.schedule_at(t0 + Duration(0.0101), [&] { fired++; });
+    wheel.advance(t0 + Duration(0.0105));
+    EXPECT_EQ(fired, 0);
+    wheel.advance(t0 + MS * 11);
+    EXPECT_EQ(fired, 1);
+}
+
+TEST(TimerWheel, Cancel) {
+    Time t0 = Time::now();
+    TimerWheel wheel(MS, t0);
+    int fired = 0;
+    auto id = wheel.schedule_at(t0 + MS * 5, [&] { fired++; });
+    EXPECT_TRUE(wheel.cancel(id));
+    EXPECT_FALSE(wheel.cancel(id));
+    EXPECT_TRUE(wheel.empty());
+
+    // The node is reused; the old id must not reach the new timer
+    auto other = wheel.schedule_at(t0 + MS * 5, [&] { fired++; });
+    EXPECT_NE(id, other);
+    EXPECT_FALSE(wheel.cancel(id));
+    wheel.advance(t0 + MS * 5);
+    EXPECT_EQ(fired, 1);
+    EXPECT_FALSE(wheel.cancel(other));
+}
+
+TEST(TimerWheel, Reschedule) {
+    Time t0 = Time::now();
+    TimerWheel wheel(MS, t0);
+    int fired = 0;
+    auto id = wheel.schedule_at(t0 + MS * 5, [&] { fired++; });
+    wheel.advance(t0 + MS * 4);
+    EXPECT_TRUE(wheel.reschedule(id, t0 + MS * 500));
+    wheel.advance(t0 + MS * 499);
+    EXPECT_EQ(fired, 0);
+    wheel.advance(t0 + MS * 500);
+    EXPECT_EQ(fired, 1);
+    EXPECT_FALSE(wheel.reschedule(id, t0 + MS * 600));
+}
+
+TEST(TimerWheel, CascadesFromEveryLevel) {
+    Time t0 = Time::now();
+    TimerWheel wheel(MS, t0);
+    // One deadline per wheel, and one beyond the top wheel (2^32 ms)
+    std::vector<int64_t> deadlines_ms = {200, 70'000, 20'000'000, 4'000'000'000, 6'000'000'000};
+    std::vector<int> fired(deadlines_ms.size(), 0);
+    for (size_t i = 0; i < deadlines_ms.size(); i++) {
+        wheel.schedule_at(t0 + Duration(Duration::Type(deadlines_ms[i] * 1'000'000)), [&, i] { fired[i]++; });
+    }
+    for (size_t i = 0; i < deadlines_ms.size(); i++) {
+        Time deadline = t0 + Duration(Duration::Type(deadlines_ms[i] * 1'000'000));
+        wheel.advance(deadline - MS);
+        EXPECT_EQ(fired[i], 0) << deadlines_ms[i];
+        wheel.advance(deadline);
+        EXPECT_EQ(fired[i], 1) << deadlines_ms[i];
+    }
+    EXPECT_TRUE(wheel.empty());
+}
+
+TEST(TimerWheel, TimeUntilNext) {
+    Time t0 = Time::now();
+    TimerWheel wheel(MS, t0);
+    EXPECT_EQ(wheel.time_until_next(t0), Duration::max());
+
+    auto far = wheel.schedule_at(t0 + Duration(3.0), [] {});
+    // Far timers give a lower bound
+    Duration wait = wheel.time_until_next(t0);
+    EXPECT_GT(wait, Duration(0.0));
+    EXPECT_LE(wait, Duration(3.0));
+
+    wheel.schedule_at(t0 + MS * 20, [] {});
+    EXPECT_EQ(wheel.time_until_next(t0), MS * 20);
+    EXPECT_EQ(wheel.time_until_next(t0 + MS * 5), MS * 15);
+    EXPECT_EQ(wheel.time_until_next(t0 + MS * 30), Duration(0.0));
+
+    wheel.advance(t0 + MS * 20);
+    wheel.cancel(far);
+    EXPECT_EQ(wheel.time_until_next(t0), Duration::max());
+}
+
+TEST(TimerWheel, CallbacksMayScheduleAndCancel) {
+    Time t0 = Time::now();
+    TimerWheel wheel(MS, t0);
+    int fired = 0;
+    TimerWheel::TimerId victim = 0;
+    wheel.schedule_at(t0 + MS * 10, [&] {
+        fired++;
+        wheel.cancel(victim);
+        // Due immediately: runs on the next tick, not in this one
+        wheel.schedule_at(t0, [&] { fired += 10; });
+    });
+    victim = wheel.schedule_at(t0 + MS * 10, [&] { fired += 100; });
+
+    EXPECT_EQ(wheel.advance(t0 + MS * 10), 1);
+    EXPECT_EQ(fired, 1);
+    EXPECT_EQ(wheel.advance(t0 + MS * 11), 1);
+    EXPECT_EQ(fired, 11);
+}
+
+TEST(TimerWheel, ManyTimers) {
+    Time t0 = Time::now();
+    TimerWheel wheel(MS, t0);
+    std::mt19937_64 rng(42);
+    std::uniform_int_distribution<int64_t> deadline_ms(1, 120'000);
+
+    const int n = 20000;
+    std::vector<int64_t> due(n);
+    std::vector<int64_t> fired_at(n, -1);
+    std::vector<TimerWheel::TimerId> ids(n);
+    int64_t now_ms = 0;
+    for (int i = 0; i < n; i++) {
+        due[i] = deadline_ms(rng);
+        ids[i] = wheel.schedule_at(t0 + MS * static_cast<int>(due[i]), [&, i] { fired_at[i] = now_ms; });
+    }
+    for (int i = 0; i < n; i += 3) {
+        EXPECT_TRUE(wheel.cancel(ids[i]));
+    }
+
+    std::uniform_int_distribution<int64_t> step_ms(1, 700);
+    while (now_ms < 121'000) {
+        int64_t prev_ms = now_ms;
+        now_ms += step_ms(rng);
+        wheel.advance(t0 + MS * static_cast<int>(now_ms));
+        for (int i = 1; i < n; i++) {
+            // Fired by the first advance past the deadline, never before
+            if (i % 3 != 0 && due[i] > prev_ms && due[i] <= now_ms) {
+                ASSERT_EQ(fired_at[i], now_ms) << i;
+            }
+        }
+    }
+    for (int i = 0; i < n; i++) {
+        EXPECT_EQ(fired_at[i] >= 0, i % 3 != 0) << i;
+    }
+    EXPECT_TRUE(wheel.empty());
+}
@@ -0,0 +1,73 @@
+#include "rix/util/timestamp.hpp"
+
+#include <ctime>
+
+#include <gtest/gtest.h>
+
+using namespace rix::util;
+
+namespace {
+
+Time from_ns(int64_t ns) { return Time(Time::Type(std::chrono::nanoseconds(ns))); }
+
+}  // namespace
+
+TEST(Timestamp, FormatMicros) {
+    char out[6];
+    detail::format_micros(0, out);
+    EXPECT_EQ(std::string(out, 6), "000000");
+    detail::format_micros(12345, out);
+    EXPECT_EQ(std::string(out, 6), "012345");
+    detail::format_micros(999999, out);
+    EXPECT_EQ(std::string(out, 6), "999999");
+    detail::format_micros(100, out);
+    EXPECT_EQ(std::string(out, 6), "000100");
+}
+
+TEST(Timestamp, Epoch) {
+    TimestampFormatter formatter;
+    EXPECT_EQ(formatter.format(from_ns(0)), "01/01/70 00:00:00.000000 GMT");
+}
+
+TEST(Timestamp, PadsMicroseconds) {
+    TimestampFormatter formatter;
+    EXPECT_EQ(formatter.format(from_ns(1'000'012'345)), "01/01/70 00:00:01.000012 GMT");
+    EXPECT_EQ(formatter.format(from_ns(1'999'999'999)), "01/01/70 00:00:01.999999 GMT");
+}
+
+TEST(Timestamp, BeforeEpoch) {
+    TimestampFormatter formatter;
+    EXPECT_EQ(formatter.format(from_ns(-1'000)), "12/31/69 23:59:59.999999 GMT");
+}
+
+TEST(Timestamp, CacheFollowsSecondChanges) {
+    TimestampFormatter formatter;
+    // 2024-02-29 23:59:59 UTC
+    const int64_t base = 1709251199LL * 1'000'000'000;
+    EXPECT_EQ(formatter.format(from_ns(base + 500'000'000)), "02/29/24 23:59:59.500000 GMT");
+    EXPECT_EQ(formatter.format(from_ns(base + 1'000'000'000)), "03/01/24 00:00:00.000000 GMT");
+    EXPECT_EQ(formatter.format(from_ns(base + 999'999'000)), "02/29/24 23:59:59.999999 GMT");
+}
+
+TEST(Timestamp, MatchesStrftime) {
+    TimestampFormatter formatter;
+    Time now = Time::now();
+    for (int i = 0; i < 100; i++) {
+        Time t = now + Duration(i * 0.37);
+        int64_t ns = t.to_nanoseconds();
+        std::time_t sec = ns / 1'000'000'000;
+        std::tm tm;
+        gmtime_r(&sec, &tm);
+        char expected[64];
+        size_t n = std::strftime(expected, sizeof(expected), "%D %T", &tm);
+        char micros[16];
+        snprintf(micros, sizeof(micros), ".%06d", static_cast<int>((ns / 1000) % 1'000'000));
+        EXPECT_EQ(formatter.format(t), std::string(expected, n) + micros + " GMT");
+    }
+}
+
+TEST(Timestamp, TimeToString) {
+    EXPECT_EQ(from_ns(1'000'012'345).to_string(), "01/01/70 00:00:01.000012 GMT");
+    Time now = Time::now();
+    EXPECT_EQ(now.to_string(true), TimestampFormatter(true).format(now));
+}
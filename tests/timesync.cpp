@@ -0,0 +1,100 @@
+#include "mbot/timesync.hpp"
+
+#include <gtest/gtest.h>
+
+TEST(TimeSync, UnsynchronizedIsIdentity) {
+    TimeSync sync;
+    EXPECT_FALSE(sync.synchronized());
+    EXPECT_EQ(sync.host_to_board(1234), 1234);
+    EXPECT_EQ(sync.board_to_host(1234), 1234);
+}
+
+TEST(TimeSync, RoundTripOffset) {
+    TimeSync sync;
+    const int64_t offset = 5'000'000;
+
+    // Symmetric 1 ms delay: the midpoint is exact
+    for (int64_t t = 0; t < 10'000'000; t += 500'000) {
+        sync.add_round_trip(t, t + 1'000 + offset, t + 2'000);
+    }
+
+    ASSERT_TRUE(sync.synchronized());
+    EXPECT_NEAR(sync.offset(5'000'000), offset, 1.0);
+    EXPECT_NEAR(sync.drift_ppm(), 0.0, 1e-3);
+    EXPECT_NEAR(sync.host_to_board(20'000'000), 20'000'000 + offset, 1);
+    EXPECT_NEAR(sync.board_to_host(20'000'000 + offset), 20'000'000, 1);
+}
+
+TEST(TimeSync, MinDelayRejectsQueuedSamples) {
+    TimeSync sync(64, 4);
+    const int64_t offset = -250'000;
+    const int64_t transit = 500;
+
+    // Most packets are delayed by queuing; a few arrive after the minimum
+    // transit time. The filter should lock onto the latter.
+    for (int i = 0; i < 64; i++) {
+        int64_t board = i * 10'000;
+        int64_t host_event = board - offset;
+        int64_t delay = (i % 8 == 0) ? transit : transit + 3'000 + (i * 37) % 2'000;
+        sync.add_one_way(board, host_event + delay, transit);
+    }
+
+    ASSERT_TRUE(sync.synchronized());
+    EXPECT_NEAR(sync.offset(300'000), offset, 1.0);
+}
+
+TEST(TimeSync, EstimatesDrift) {
+    TimeSync sync(256, 8);
+    const double drift = 100e-6;  // 100 ppm fast
+    const int64_t offset = 1'000;
+
+    for (int64_t t = 0; t < 60'000'000; t += 250'000) {
+        int64_t board = offset + t + static_cast<int64_t>(drift * t);
+        sync.add_round_trip(t - 500, board, t + 500);
+    }
+
+    EXPECT_NEAR(sync.drift_ppm(), 100.0, 1.0);
+    int64_t host = 70'000'000;
+    int64_t board = offset + host + static_cast<int64_t>(drift * host);
+    EXPECT_NEAR(sync.host_to_board(host), board, 20);
+    EXPECT_NEAR(sync.board_to_host(board), host, 20);
+}
+
+TEST(TimeSync, MixedSamplesDoNotSkewTheFit) {
+    TimeSync sync;  // Window of 256 in 8 buckets: 0.32 s each at 100 Hz
+    const double drift = 50e-6;
+    const int64_t offset = 2'000'000;
+    const int64_t transit = 500;  // Serialization time, the known minimum
+    const int64_t delay = 3'000;  // Actual one-way delay, in both directions
+    auto board_at = [&](int64_t host) { return offset + host + static_cast<int64_t>(drift * host); };
+
+    // Telemetry at 100 Hz; a timesync reply every 0.5 s, so some buckets hold
+    // a round trip and others only one-way samples
+    for (int64_t t = 0; t < 10'000'000; t += 10'000) {
+        sync.add_one_way(board_at(t), t + delay, transit);
+        if (t % 500'000 == 0) {
+            sync.add_round_trip(t - delay, board_at(t), t + delay, transit);
+        }
+    }
+
+    EXPECT_NEAR(sync.drift_ppm(), 50.0, 5.0);
+    int64_t host = 10'000'000;
+    EXPECT_NEAR(sync.host_to_board(host), board_at(host), 100);
+}
+
+TEST(TimeSync, DriftIsClamped) {
+    TimeSync sync(16, 4, 50.0);
+    for (int64_t t = 0; t < 16'000'000; t += 1'000'000) {
+        sync.add_round_trip(t, t + t / 100, t);  // 10000 ppm
+    }
+    EXPECT_NEAR(sync.drift_ppm(), 50.0, 1e-6);
+}
+
+TEST(TimeSync, Reset) {
+    TimeSync sync;
+    sync.add_one_way(100, 50);
+    ASSERT_TRUE(sync.synchronized());
+    sync.reset();
+    EXPECT_FALSE(sync.synchronized());
+    EXPECT_EQ(sync.host_to_board(42), 42);
+}